@@ -0,0 +1,357 @@
+// backtest_engine.h - 蝶式策略的歷史回測
+//
+// 輸入是逐 bar (日線或日內) 的 spot / IV 序列；CSV 以 4 MB 區塊串流解析成欄式陣列，
+// 不保留檔案文字。每組參數 (間距、進場天數、停利停損...) 在同一份序列上獨立重播：
+//   - 空手時依規則進場：ATM 取最接近的 strike_step，間距 = spot * width_pct%
+//   - 持倉中每個 bar 用 OptionLegStore 以當下 spot / IV / 剩餘天數評價
+//   - 到期 (或停利 / 停損 / 剩餘天數到 exit_dte) 出場，已實現損益累加
+// 每個 BacktestEngine 自帶部位儲存，不同執行緒各用一個，參數組之間沒有共享狀態。
+#pragma once
+
+#include "butterfly_pricing.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ----------------------------- 行情序列 -----------------------------
+struct MarketSeries
+{
+    std::vector<double> time;       // Unix 秒 (UTC)
+    std::vector<double> spot;
+    std::vector<double> iv;         // 小數
+    std::vector<double> rate;       // 小數
+
+    std::size_t size() const { return time.size(); }
+
+    // 每年幾個 bar (年化 Sharpe 用)，由頭尾時間推估
+    double BarsPerYear() const
+    {
+        if (size() < 2 || time.back() <= time.front())
+            return 252.0;
+        return (size() - 1) / ((time.back() - time.front()) / (365.25 * 86400.0));
+    }
+};
+
+// 公曆日期 -> 1970-01-01 起的天數 (Howard Hinnant 的 days_from_civil)
+static inline std::int64_t backtest_days_from_civil(std::int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (std::int64_t)doe - 719468;
+}
+
+static inline bool backtest_parse_uint(const char*& p, const char* end, int digits, unsigned& out)
+{
+    out = 0;
+    for (int i = 0; i < digits; ++i, ++p)
+    {
+        if (p >= end || *p < '0' || *p > '9')
+            return false;
+        out = out * 10 + (unsigned)(*p - '0');
+    }
+    return true;
+}
+
+// 時間欄位："YYYY-MM-DD"、"YYYY-MM-DD HH:MM[:SS]" (或 'T' 分隔) 或 Unix 秒數
+static inline bool ParseBacktestTime(const char*& p, const char* end, double& out)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    const char* q = p;
+    unsigned y, mo, d;
+    if (end - q >= 10 && q[4] == '-' && backtest_parse_uint(q, end, 4, y) && *q++ == '-' &&
+        backtest_parse_uint(q, end, 2, mo) && *q++ == '-' && backtest_parse_uint(q, end, 2, d))
+    {
+        double sec = (double)backtest_days_from_civil(y, mo, d) * 86400.0;
+        unsigned hh, mm, ss = 0;
+        const char* t = q;
+        if (t < end && (*t == ' ' || *t == 'T') && (++t, backtest_parse_uint(t, end, 2, hh)) && t < end && *t++ == ':' &&
+            backtest_parse_uint(t, end, 2, mm))
+        {
+            if (t < end && *t == ':')
+            {
+                ++t;
+                if (!backtest_parse_uint(t, end, 2, ss))
+                    return false;
+            }
+            sec += hh * 3600.0 + mm * 60.0 + ss;
+            q = t;
+        }
+        out = sec;
+        p = q;
+    }
+    else
+    {
+        auto res = std::from_chars(p, end, out);
+        if (res.ec != std::errc())
+            return false;
+        p = res.ptr;
+    }
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p < end && *p == ',') ++p;
+    return true;
+}
+
+static inline bool ParseBacktestDouble(const char*& p, const char* end, double& out)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p < end && *p == '+') ++p;
+    auto res = std::from_chars(p, end, out);
+    if (res.ec != std::errc())
+        return false;
+    p = res.ptr;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p < end && *p == ',') ++p;
+    return true;
+}
+
+// CSV 欄位: time,spot,iv_pct[,rate_pct] (第一行若不是資料視為標題；沒有 rate 欄時用 default_rate_pct)
+// 時間必須遞增；倒退的列略過。
+static inline bool LoadMarketSeriesCsv(const char* path, MarketSeries& out, double default_rate_pct)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        printf("Error: cannot open %s\n", path);
+        return false;
+    }
+
+    out = MarketSeries();
+    std::vector<char> buf(4 << 20);
+    std::string carry;   // 跨區塊的半行
+    std::uint64_t line_no = 0, skipped = 0;
+
+    auto handle_line = [&](const char* b, const char* e) {
+        ++line_no;
+        if (e > b && e[-1] == '\r') --e;
+        if (b == e) return;
+        double t, spot, iv_pct, rate_pct = default_rate_pct;
+        const char* p = b;
+        if (!ParseBacktestTime(p, e, t) || !ParseBacktestDouble(p, e, spot) || !ParseBacktestDouble(p, e, iv_pct) ||
+            (p < e && !ParseBacktestDouble(p, e, rate_pct)))
+        {
+            if (line_no != 1)   // 第一行允許是標題
+                ++skipped;
+            return;
+        }
+        if (spot <= 0.0 || iv_pct <= 0.0 || (!out.time.empty() && t <= out.time.back()))
+        {
+            ++skipped;
+            return;
+        }
+        out.time.push_back(t);
+        out.spot.push_back(spot);
+        out.iv.push_back(iv_pct / 100.0);
+        out.rate.push_back(rate_pct / 100.0);
+    };
+
+    std::size_t n;
+    while ((n = fread(buf.data(), 1, buf.size(), f)) > 0)
+    {
+        const char* p = buf.data();
+        const char* end = p + n;
+        while (p < end)
+        {
+            const char* nl = (const char*)memchr(p, '\n', end - p);
+            if (!nl)
+            {
+                carry.append(p, end);
+                break;
+            }
+            if (!carry.empty())
+            {
+                carry.append(p, nl);
+                handle_line(carry.data(), carry.data() + carry.size());
+                carry.clear();
+            }
+            else
+            {
+                handle_line(p, nl);
+            }
+            p = nl + 1;
+        }
+    }
+    if (!carry.empty())
+        handle_line(carry.data(), carry.data() + carry.size());
+    fclose(f);
+
+    if (skipped)
+        fprintf(stderr, "Warning: %s: skipped %llu malformed or out-of-order lines\n", path, (unsigned long long)skipped);
+    return true;
+}
+
+// ----------------------------- 規則 / 結果 -----------------------------
+struct BacktestParams
+{
+    double width_pct = 5.0;          // 翼寬 = spot * width_pct%，四捨五入到 strike_step
+    int entry_dte = 30;              // 進場時的到期天數 (日曆日)
+    double take_profit_pct = 0.0;    // 未實現損益 >= 成本 * tp% 時出場 (0 = 不用)
+    double stop_loss_pct = 0.0;      // 未實現損益 <= -成本 * sl% 時出場 (0 = 不用)
+    int exit_dte = 0;                // 剩餘天數 <= exit_dte 時出場 (0 = 持有到期)
+    int cooldown_bars = 0;           // 出場後等幾個 bar 再進場
+    double strike_step = 1.0;        // 履約價間隔
+    double commission = 0.0;         // 每口每邊手續費 (一組蝶式 4 口)
+};
+
+struct BacktestTrade
+{
+    std::uint32_t entry_bar, exit_bar;
+    double k_mid, width;
+    double debit;                    // 進場成本 (含手續費)
+    double pnl;                      // 已實現 (含雙邊手續費)
+};
+
+struct BacktestStats
+{
+    std::uint32_t trades = 0;
+    std::uint32_t wins = 0;
+    double total_pnl = 0.0;          // 最後權益 (含未平倉的未實現損益)
+    double gross_profit = 0.0;
+    double gross_loss = 0.0;
+    double max_drawdown = 0.0;       // 權益曲線自高點的最大回落 ($)
+    double sharpe = 0.0;             // 逐 bar 權益變化的年化 Sharpe (以 $ 計，不是報酬率)
+    double avg_bars_held = 0.0;
+
+    double win_rate() const { return trades ? (double)wins / trades : 0.0; }
+    double avg_trade() const { return trades ? (gross_profit - gross_loss) / trades : 0.0; }
+    double profit_factor() const { return gross_loss > 0.0 ? gross_profit / gross_loss : 0.0; }
+};
+
+// ----------------------------- Engine -----------------------------
+class BacktestEngine
+{
+public:
+    explicit BacktestEngine(const MarketSeries& series)
+        : s_(series)
+    {
+        legs_.add_leg({ 95.0, 0.0, OptionType::Call, 1.0, 0.2, 0.0 });
+        legs_.add_leg({ 100.0, 0.0, OptionType::Call, -2.0, 0.2, 0.0 });
+        legs_.add_leg({ 105.0, 0.0, OptionType::Call, 1.0, 0.2, 0.0 });
+    }
+
+    // equity / trades 非 null 時輸出逐 bar 權益與每筆交易
+    BacktestStats Run(const BacktestParams& prm, std::vector<double>* equity = nullptr, std::vector<BacktestTrade>* trades = nullptr)
+    {
+        BacktestStats st;
+        const std::size_t n = s_.size();
+        if (equity)
+            equity->assign(n, 0.0);
+        if (trades)
+            trades->clear();
+
+        const double* time = s_.time.data();
+        const double* spot = s_.spot.data();
+        const double* iv = s_.iv.data();
+        const double* rate = s_.rate.data();
+        const double fees = 4.0 * prm.commission;
+
+        bool open = false;
+        BacktestTrade cur = {};
+        double expiry_time = 0.0;
+        std::size_t next_entry = 0;
+        double realized = 0.0, peak = 0.0, prev_equity = 0.0;
+        double sum_d = 0.0, sum_d2 = 0.0, bars_held = 0.0;
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (!open && i >= next_entry)
+            {
+                const double step = prm.strike_step > 0.0 ? prm.strike_step : 0.0;
+                const double k_mid = step > 0.0 ? std::round(spot[i] / step) * step : spot[i];
+                double width = spot[i] * prm.width_pct / 100.0;
+                if (step > 0.0)
+                    width = std::max(step, std::round(width / step) * step);
+                legs_.set_strike(0, k_mid - width);
+                legs_.set_strike(1, k_mid);
+                legs_.set_strike(2, k_mid + width);
+                legs_.set_market(spot[i], prm.entry_dte / 365.0, iv[i], rate[i]);
+
+                cur = {};
+                cur.entry_bar = (std::uint32_t)i;
+                cur.k_mid = k_mid;
+                cur.width = width;
+                cur.debit = legs_.total_value() + fees;
+                expiry_time = time[i] + prm.entry_dte * 86400.0;
+                open = true;
+            }
+
+            double unrealized = 0.0;
+            if (open)
+            {
+                const double days_left = (expiry_time - time[i]) / 86400.0;
+                bool close = false;
+                double value;
+                if (days_left <= 0.0)
+                {
+                    // 到期：以這個 bar 的 spot 結算內含價值
+                    legs_.payoff_curve(&spot[i], 1, &value);
+                    close = true;
+                }
+                else
+                {
+                    legs_.set_market(spot[i], days_left / 365.0, iv[i], rate[i]);
+                    value = legs_.total_value();
+                }
+                const double pnl = value - cur.debit - fees;
+                const double base = std::max(1e-9, cur.debit);
+                if (i > cur.entry_bar)
+                {
+                    if (prm.take_profit_pct > 0.0 && pnl >= base * prm.take_profit_pct / 100.0) close = true;
+                    if (prm.stop_loss_pct > 0.0 && pnl <= -base * prm.stop_loss_pct / 100.0) close = true;
+                    if (prm.exit_dte > 0 && days_left <= prm.exit_dte) close = true;
+                }
+
+                if (close)
+                {
+                    cur.exit_bar = (std::uint32_t)i;
+                    cur.pnl = pnl;
+                    realized += pnl;
+                    ++st.trades;
+                    if (pnl > 0.0) { ++st.wins; st.gross_profit += pnl; }
+                    else st.gross_loss -= pnl;
+                    bars_held += (double)(i - cur.entry_bar);
+                    if (trades)
+                        trades->push_back(cur);
+                    open = false;
+                    next_entry = i + 1 + (std::size_t)std::max(0, prm.cooldown_bars);
+                }
+                else
+                {
+                    unrealized = pnl;
+                }
+            }
+
+            const double eq = realized + unrealized;
+            if (equity)
+                (*equity)[i] = eq;
+            peak = std::max(peak, eq);
+            st.max_drawdown = std::max(st.max_drawdown, peak - eq);
+            const double d = eq - prev_equity;
+            sum_d += d;
+            sum_d2 += d * d;
+            prev_equity = eq;
+        }
+
+        st.total_pnl = prev_equity;
+        st.avg_bars_held = st.trades ? bars_held / st.trades : 0.0;
+        if (n > 1)
+        {
+            const double mean = sum_d / n;
+            const double var = std::max(0.0, sum_d2 / n - mean * mean);
+            st.sharpe = var > 0.0 ? mean / std::sqrt(var) * std::sqrt(s_.BarsPerYear()) : 0.0;
+        }
+        return st;
+    }
+
+private:
+    const MarketSeries& s_;
+    OptionLegStore legs_;
+};
@@ -0,0 +1,889 @@
+// butterfly_app.h - 蝶式價差視覺化的 App State 與 UI (三個 backend 共用)
+#pragma once
+
+#include "imgui.h"
+#include "implot.h"
+#include "butterfly_pricing.h"
+#include "theta_surface.h"
+#include "report_export.h"
+#include "polyline_renderer.h"
+#include "curve_shm.h"
+#include "latest_wins.h"
+#include "curve_precision.h"
+#include "curve_tiles.h"
+#include "memory_tracker.h"
+
+#include <stdio.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// ----------------------------- Helper Functions -----------------------------
+// 用來包裝 SliderScalar，使其用起來像 SliderDouble
+static bool SliderDouble(const char* label, double* v, double v_min, double v_max,
+    const char* format = "%.3f", ImGuiSliderFlags flags = 0)
+{
+    return ImGui::SliderScalar(label, ImGuiDataType_Double, v, &v_min, &v_max, format, flags);
+}
+
+// 用來包裝 InputScalar，使其用起來像 InputDouble
+static bool InputDouble(const char* label, double* v, double step = 0.0, double step_fast = 0.0,
+    const char* format = "%.6f", ImGuiInputTextFlags flags = 0)
+{
+    return ImGui::InputScalar(label, ImGuiDataType_Double, v,
+        step > 0.0 ? &step : NULL,
+        step_fast > 0.0 ? &step_fast : NULL,
+        format, flags);
+}
+
+// ----------------------------- App State -----------------------------
+// 蝶式三條腿在 legs 裡的位置
+enum ButterflyLeg
+{
+    ButterflyLeg_Low = 0,
+    ButterflyLeg_Mid = 1,
+    ButterflyLeg_High = 2,
+    ButterflyLeg_COUNT
+};
+
+
+// 一份曲線結果：背景定價寫入，UI 以 swap 接手
+struct CurveBuffers
+{
+    CurveVector xs, ys_exp, ys_cur;   // ys_exp 為空表示只算 T+0
+    std::uint64_t generation = ~0ull;          // 對應的 legs.generation()
+    CurvePrecision precision = CurvePrecision::Float64;
+};
+
+// spot ±25%、n 點的損益曲線；cancel 非空時每一段檢查一次，已過時就放棄並回傳 false。
+// T+0 曲線依 precision 計算 (只用於顯示)，到期損益與 entry_cost 一律 double。
+static bool EvaluateCurveBuffers(const OptionLegStore& legs, double spot, double entry_cost, int n, bool with_expiry,
+                                 CurvePrecision precision, CurveBuffers& out, const CancelToken* cancel)
+{
+    constexpr int kChunk = 8192;
+    out.xs.resize(n);
+    out.ys_cur.resize(n);
+    out.ys_exp.resize(with_expiry ? n : 0);
+    const double x_min = spot * 0.75;
+    const double x_max = spot * 1.25;
+    for (int i = 0; i < n; ++i)
+        out.xs[i] = x_min + (x_max - x_min) * i / (n - 1);
+    for (int b = 0; b < n; b += kChunk)
+    {
+        if (cancel && cancel->cancelled())
+            return false;
+        const int m = std::min(kChunk, n - b);
+        price_curve_display(legs, &out.xs[b], m, &out.ys_cur[b], precision);
+        if (with_expiry)
+            legs.payoff_curve(&out.xs[b], m, &out.ys_exp[b]);
+        for (int i = b; i < b + m; ++i)
+        {
+            out.ys_cur[i] -= entry_cost;
+            if (with_expiry)
+                out.ys_exp[i] -= entry_cost;
+        }
+    }
+    out.generation = legs.generation();
+    out.precision = precision;
+    return true;
+}
+
+// 一次背景定價的結果：主圖缺的塊 (curve_tiles.h)，參考曲線過時時再加上 spot ±25% 的 n_points 點
+struct CurveJobResult
+{
+    CurveBuffers curve;                  // generation = ~0 表示這次沒算
+    CurveTileCache::TileBatch tiles;
+};
+
+static bool EvaluateCurveJob(const OptionLegStore& legs, double spot, double entry_cost, int n, bool with_curve, CurvePrecision precision,
+                             const CurveTileCache::TileRequest& req, CurveJobResult& out, const CancelToken* cancel)
+{
+    out.curve.generation = ~0ull;
+    if (with_curve && !EvaluateCurveBuffers(legs, spot, entry_cost, n, true, precision, out.curve, cancel))
+        return false;
+    return CurveTileCache::BuildTiles(legs, req, out.tiles, cancel);
+}
+
+// 成本歷史 (固定容量環狀緩衝)，每次部位或行情改變時記一筆
+struct HistorySample
+{
+    double time;          // Unix 秒
+    double spot;
+    double entry_cost;
+};
+
+struct HistoryRing
+{
+    std::vector<HistorySample> samples;
+    std::uint64_t total_pushed = 0;    // 累計寫入筆數；寫入位置 = total_pushed % capacity
+
+    explicit HistoryRing(std::size_t capacity) : samples(capacity) {}
+
+    std::size_t capacity() const { return samples.size(); }
+    std::size_t count() const { return (std::size_t)std::min<std::uint64_t>(total_pushed, capacity()); }
+
+    void push(const HistorySample& s)
+    {
+        samples[total_pushed % capacity()] = s;
+        ++total_pushed;
+    }
+
+    // i = 0 為最舊的一筆
+    const HistorySample& at(std::size_t i) const
+    {
+        const std::uint64_t first = total_pushed - count();
+        return samples[(first + i) % capacity()];
+    }
+};
+
+// 期限結構 / 股利的 UI 輸入 (market_curves.h)；改變時才重建 MarketCurves
+struct TermStructureInput
+{
+    static constexpr int kPillars = 5;
+    static constexpr int kMaxDividends = 4;
+    double pillar_days[kPillars] = { 30, 91, 182, 365, 730 };
+    double zero_pct[kPillars] = { 4.0, 4.1, 4.2, 4.3, 4.4 };   // 連續複利
+    double yield_pct = 0.0;
+    int n_dividends = 0;
+    double div_days[kMaxDividends] = { 14, 105, 196, 287 };    // 距除息日天數
+    double div_amount[kMaxDividends] = { 0.5, 0.5, 0.5, 0.5 };
+
+    bool operator==(const TermStructureInput&) const = default;
+
+    std::shared_ptr<const MarketCurves> Build() const
+    {
+        auto c = std::make_shared<MarketCurves>();
+        for (int p = 0; p < kPillars; ++p)
+            c->rates.add_pillar(pillar_days[p] / 365.0, zero_pct[p] / 100.0);
+        c->dividends.yield = yield_pct / 100.0;
+        for (int d = 0; d < n_dividends; ++d)
+            if (div_amount[d] > 0.0 && div_days[d] > 0.0)
+                c->add_cash_dividend(div_days[d] / 365.0, div_amount[d]);
+        return c;
+    }
+};
+
+// 定價模型選擇 + 隨機波動率參數 (heston_cos.h)；波動率類欄位以 % 輸入
+enum PricingModel
+{
+    PricingModel_BlackScholes = 0,
+    PricingModel_Heston = 1,
+    PricingModel_Bates = 2,
+};
+
+struct StochVolInput
+{
+    int model = PricingModel_BlackScholes;
+    double v0_vol_pct = 18.0;      // sqrt(v0)
+    double kappa = 2.0;
+    double theta_vol_pct = 20.0;   // sqrt(theta)
+    double xi = 0.5;
+    double rho = -0.7;
+    double jump_lambda = 0.5;
+    double jump_mu_pct = -5.0;
+    double jump_sigma_pct = 10.0;
+
+    bool operator==(const StochVolInput&) const = default;
+
+    std::shared_ptr<const StochVolParams> Build() const
+    {
+        if (model == PricingModel_BlackScholes)
+            return nullptr;
+        auto p = std::make_shared<StochVolParams>();
+        p->v0 = (v0_vol_pct / 100.0) * (v0_vol_pct / 100.0);
+        p->kappa = kappa;
+        p->theta = (theta_vol_pct / 100.0) * (theta_vol_pct / 100.0);
+        p->xi = xi;
+        p->rho = rho;
+        if (model == PricingModel_Bates)
+        {
+            p->jump_lambda = jump_lambda;
+            p->jump_mu = jump_mu_pct / 100.0;
+            p->jump_sigma = jump_sigma_pct / 100.0;
+        }
+        return p;
+    }
+};
+
+struct ButterflyApp
+{
+    // App State (邏輯參數)
+    double current_price = 95.0;
+    double iv_pct = 18.0;
+    int days_to_expiry = 27;
+    double risk_free_pct = 4.0;
+    // 開啟時改用零息曲線 + 股利，risk_free_pct 不使用
+    bool use_term_structure = false;
+    TermStructureInput term_structure;
+    TermStructureInput applied_term_structure;
+    // Heston / Bates 時 IV 滑桿不使用 (波動率由模型參數決定)
+    StochVolInput stoch_vol;
+    StochVolInput applied_stoch_vol;
+    double strike_atm = 100.0;
+    double width = 5.0;
+    bool show_explain = true;
+    bool show_dashboard = false;
+    bool show_latency = false;
+    bool show_pacing = false;
+    bool show_memory = false;
+    bool show_ladder = false;
+
+    // 部位與行情 (SoA)，定價直接吃這份資料
+    OptionLegStore legs;
+
+    // 曲線輸出
+    static constexpr int n_points = 200;
+    CurveVector xs, ys_exp, ys_cur;
+    double entry_cost = 0.0;
+    std::uint64_t curve_generation = ~0ull;   // 曲線對應的 legs.generation()
+
+    static constexpr std::size_t history_capacity = 1 << 16;
+    HistoryRing history{ history_capacity };
+    std::uint64_t history_generation = 0;
+    bool history_pending = false;
+    double history_min_interval = 0.25;
+
+    // 到期衰減動畫：背景預算曲面，播放時查表內插
+    ThetaSurface theta_surface;
+    bool theta_playing = false;
+    double theta_days_left = 0.0;
+    float theta_speed = 5.0f;              // 天 / 秒
+    CurveVector ys_anim;
+
+    // 匯出 (report_export.h)
+    char export_status[160] = "";
+
+    // 設定檔重新載入結果 (live_config.h)
+    char config_status[192] = "";
+
+    // 高解析 T+0 曲線 (polyline_renderer.h)：點數大時走 GPU instanced 或 CPU 抽樣
+    PolylineRenderer polylines;
+    bool dense_curve = false;
+    int dense_points = 200000;
+    CurveVector dense_xs, dense_ys;
+    std::uint64_t dense_generation = ~0ull;   // 對應的 legs.generation()
+    std::uint64_t dense_version = 0;          // 內容改變就遞增，GPU 端據此決定是否重傳
+
+    // 共享記憶體發佈 (curve_shm.h)
+    std::uint64_t published_generation = ~0ull;
+
+    // 背景定價 (latest_wins.h)：拖拉中只算最新參數，畫面沿用上一份完成的曲線。
+    // curve_job 一次處理主圖缺的塊與參考曲線 (xs / ys_*：匯出、發佈、快照、動畫用)，同一份 legs 副本只送一次
+    bool async_pricing = true;
+    LatestWinsJob<CurveJobResult> curve_job;
+    LatestWinsJob<CurveBuffers> dense_job;
+    CurveJobResult curve_landing;                   // TakeLatest 交換用，保留容量
+    CurveBuffers dense_landing;
+    CurveTileCache::TileRequest tiles_requested;    // 最近一次送出的塊
+    std::uint64_t curve_requested = ~0ull;          // 最近一次連同參考曲線送出的 generation
+    std::uint64_t dense_requested = ~0ull;
+    int dense_requested_points = 0;
+
+    // 顯示曲線的精度 (curve_precision.h)；成本、Greeks、報表不受影響
+    CurvePrecision precision = CurvePrecision::Float64;
+    CurvePrecision curve_precision = CurvePrecision::Float64;   // 目前畫面上曲線的精度
+    CurvePrecision dense_precision = CurvePrecision::Float64;
+    CurvePrecision curve_requested_precision = CurvePrecision::Float64;
+    CurvePrecision dense_requested_precision = CurvePrecision::Float64;
+
+    // 主圖可自由縮放 / 平移 (curve_tiles.h)：可見範圍的曲線分塊在背景算、逐幀細化；fit_view 時重設到 spot ±25%
+    CurveTileCache curve_tiles;
+    bool fit_view = true;
+    double view_x_min = 0.0, view_x_max = 0.0;   // 上一幀的可見範圍
+
+    // 模型隱含波動率微笑：中間腿到期日、一次 COS 定價整排履約價
+    static constexpr int smile_points = 241;
+    TaggedVector<double, MemTag_Pricing> smile_strikes, smile_iv;
+    std::uint64_t smile_generation = ~0ull;
+    double smile_us = 0.0;                    // 整排履約價的定價時間 (不含反推 IV)
+
+    ButterflyApp()
+        : xs(n_points), ys_exp(n_points), ys_cur(n_points), ys_anim(n_points)
+    {
+        legs.add_leg({ strike_atm - width, 0.0, OptionType::Call, 1.0, 0.0, 0.0 });
+        legs.add_leg({ strike_atm, 0.0, OptionType::Call, -2.0, 0.0, 0.0 });
+        legs.add_leg({ strike_atm + width, 0.0, OptionType::Call, 1.0, 0.0, 0.0 });
+        SyncButterflyLegs();
+    }
+
+    // 把 UI 參數同步進 legs；只有真的改變的欄位會觸發該腿重算
+    void SyncButterflyLegs()
+    {
+        const double sigma = iv_pct / 100.0;
+        const double r = risk_free_pct / 100.0;
+        const double T = std::max(0.0, days_to_expiry / 365.0);
+        const double strikes[ButterflyLeg_COUNT] = { strike_atm - width, strike_atm, strike_atm + width };
+
+        for (int i = 0; i < ButterflyLeg_COUNT; ++i)
+        {
+            legs.set_strike(i, strikes[i]);
+            legs.set_expiry(i, T);
+            legs.set_vol(i, sigma);
+            legs.set_rate(i, r);
+        }
+        if (!use_term_structure)
+            legs.set_curves(nullptr);
+        else if (!legs.curves() || !(term_structure == applied_term_structure))
+        {
+            legs.set_curves(term_structure.Build());
+            applied_term_structure = term_structure;
+        }
+        if (!(stoch_vol == applied_stoch_vol) || (stoch_vol.model != PricingModel_BlackScholes) != (bool)legs.model())
+        {
+            legs.set_model(stoch_vol.Build());
+            applied_stoch_vol = stoch_vol;
+        }
+        legs.set_spot(current_price);
+        entry_cost = legs.total_value();
+
+        // 行情每個 tick 都會改 generation：數值真的變了才記，且兩筆至少隔 history_min_interval 秒 (最後一個值會在間隔到時補記)
+        if (legs.generation() != history_generation)
+        {
+            history_generation = legs.generation();
+            history_pending = true;
+        }
+        if (history_pending)
+        {
+            const double now = std::chrono::duration<double>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            const HistorySample* last = history.count() ? &history.at(history.count() - 1) : nullptr;
+            if (last && last->spot == current_price && last->entry_cost == entry_cost)
+                history_pending = false;
+            else if (!last || now - last->time >= history_min_interval)
+            {
+                history.push({ now, current_price, entry_cost });
+                history_pending = false;
+            }
+        }
+    }
+
+    // 接手背景完成的結果；部位或現價沒變就沿用上次 (或快照載入) 的曲線
+    void ComputeCurves()
+    {
+        if (curve_job.TakeLatest(curve_landing))
+        {
+            if (curve_landing.curve.generation == legs.generation() && curve_landing.curve.precision == precision)   // 比 ComputeCurvesNow 同步算的舊就不要
+                AdoptCurve(curve_landing.curve);
+            curve_tiles.Accept(curve_landing.tiles);
+        }
+        if (curve_generation == ~0ull)   // 第一份參考曲線同步算，之後才有「舊曲線」可以沿用
+            ComputeCurvesNow();
+    }
+
+    // 主圖：組出可見範圍的分塊曲線，缺的塊與過時的參考曲線合成一個背景工作；UI 執行緒不定價。
+    // 關掉背景定價時改為每幀同步算一批 (最多 kBatchTiles 塊)
+    bool UpdateCurveTiles(double x_min, double x_max, float pixel_width)
+    {
+        const bool done = curve_tiles.Update(legs, entry_cost, precision, x_min, x_max, pixel_width);
+        const CurveTileCache::TileRequest& req = curve_tiles.PendingRequest();
+        const std::uint64_t gen = legs.generation();
+        const bool with_curve = curve_generation != gen || curve_precision != precision;
+        if (req.keys.empty() && !with_curve)
+            return done;
+        if (!async_pricing)
+        {
+            EvaluateCurveJob(legs, current_price, entry_cost, n_points, with_curve, precision, req, curve_landing, nullptr);
+            if (with_curve)
+                AdoptCurve(curve_landing.curve);
+            curve_tiles.Accept(curve_landing.tiles);
+            return done;
+        }
+        // 同一份請求還在算就不重送 (新請求會讓執行中的工作放棄)
+        const bool curve_in_flight = !with_curve || (curve_requested == gen && curve_requested_precision == precision);
+        if (curve_job.Busy() && req == tiles_requested && curve_in_flight)
+            return done;
+        tiles_requested = req;
+        curve_requested = with_curve ? gen : ~0ull;
+        curve_requested_precision = precision;
+        curve_job.Submit([legs = OptionLegStore(legs), spot = current_price, cost = entry_cost, p = precision, with_curve, req](
+                             CurveJobResult& out, const CancelToken& cancel) {
+            return EvaluateCurveJob(legs, spot, cost, n_points, with_curve, p, req, out, &cancel);
+        });
+        return done;
+    }
+
+    // 在 UI 執行緒立即算好目前參數的參考曲線 (匯出、動畫起點等需要「現在」的結果時)；
+    // 背景工作照常進行，之後送回的同一份結果會被略過
+    void ComputeCurvesNow()
+    {
+        if (curve_generation == legs.generation() && curve_precision == precision)
+            return;
+        EvaluateCurveBuffers(legs, current_price, entry_cost, n_points, true, precision, curve_landing.curve, nullptr);
+        AdoptCurve(curve_landing.curve);
+    }
+
+    void AdoptCurve(CurveBuffers& c)
+    {
+        xs.swap(c.xs);
+        ys_exp.swap(c.ys_exp);
+        ys_cur.swap(c.ys_cur);
+        curve_generation = c.generation;
+        curve_precision = c.precision;
+    }
+
+    // 與 ComputeCurves 同範圍、dense_points 點的 T+0 曲線；部位與點數都沒變就沿用
+    void ComputeDenseCurve()
+    {
+        if (!dense_curve)
+            return;
+        if (dense_job.TakeLatest(dense_landing))
+            AdoptDenseCurve(dense_landing);
+        const std::uint64_t gen = legs.generation();
+        if (dense_generation == gen && (int)dense_xs.size() == dense_points && dense_precision == precision)
+            return;
+        if (dense_requested == gen && dense_requested_points == dense_points && dense_requested_precision == precision)
+            return;
+        dense_requested = gen;
+        dense_requested_points = dense_points;
+        dense_requested_precision = precision;
+        if (!async_pricing)
+        {
+            dense_job.Cancel();
+            EvaluateCurveBuffers(legs, current_price, entry_cost, dense_points, false, precision, dense_landing, nullptr);
+            AdoptDenseCurve(dense_landing);
+            return;
+        }
+        dense_job.Submit([legs = OptionLegStore(legs), spot = current_price, cost = entry_cost, n = dense_points, p = precision](CurveBuffers& out, const CancelToken& cancel) {
+            return EvaluateCurveBuffers(legs, spot, cost, n, false, p, out, &cancel);
+        });
+    }
+
+    void AdoptDenseCurve(CurveBuffers& c)
+    {
+        dense_xs.swap(c.xs);
+        dense_ys.swap(c.ys_cur);
+        dense_generation = c.generation;
+        dense_precision = c.precision;
+        ++dense_version;
+    }
+
+    // 目前模型下中間腿到期日的微笑：所有履約價共用同一組 COS 係數，一次 cos_put_grid 算完
+    void ComputeSmile()
+    {
+        if (!legs.model() || smile_generation == legs.generation())
+            return;
+        smile_generation = legs.generation();
+        smile_strikes.resize(smile_points);
+        smile_iv.resize(smile_points);
+        const std::size_t mid = ButterflyLeg_Mid;
+        const double T = std::max(0.0, legs.expiry[mid]);
+        const CosSlice* slice = legs.cos_slice(T);
+        const double df = legs.discount[mid];
+        const double F = (current_price - legs.div_pv[mid]) * legs.div_discount[mid] / df;
+        if (!slice || F <= 0.0)
+        {
+            std::fill(smile_iv.begin(), smile_iv.end(), 0.0);
+            smile_us = 0.0;
+            return;
+        }
+        TaggedVector<double, MemTag_Pricing> fk(smile_points), put(smile_points);
+        for (int j = 0; j < smile_points; ++j)
+        {
+            smile_strikes[j] = F * (0.7 + 0.6 * j / (smile_points - 1));
+            fk[j] = F / smile_strikes[j];
+        }
+        const auto t0 = std::chrono::steady_clock::now();
+        cos_put_grid(*slice, fk.data(), smile_points, put.data());
+        smile_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        // 價外那一邊反推 (K < F 用 put，否則用 call)
+        for (int j = 0; j < smile_points; ++j)
+        {
+            const double K = smile_strikes[j];
+            const double p = put[j] * K * df;
+            const bool use_call = K >= F;
+            smile_iv[j] = 100.0 * black76_implied_vol(use_call ? p + df * (F - K) : p, F, K, T, df, use_call);
+        }
+    }
+
+    // 背景定價還沒追上目前參數
+    bool CurvesPending() const
+    {
+        return curve_generation != legs.generation() || (dense_curve && dense_generation != legs.generation());
+    }
+
+    void StartThetaAnimation()
+    {
+        ComputeCurvesNow();
+        theta_playing = true;
+        theta_days_left = days_to_expiry;
+        if (theta_surface.Key() != legs.generation() || theta_surface.Precision() != precision)
+            theta_surface.Start(legs, xs, entry_cost, days_to_expiry, legs.generation(), precision);
+    }
+
+    // 每幀推進播放時間；參數被改動就停止 (曲面已不對應)
+    void UpdateThetaAnimation(float dt)
+    {
+        if (!theta_playing)
+            return;
+        if (theta_surface.Key() != legs.generation())
+        {
+            theta_playing = false;
+            return;
+        }
+        if (!theta_surface.Ready())
+            return;
+
+        theta_surface.Sample(theta_days_left, ys_anim.data());
+        if (theta_days_left <= 0.0)
+            theta_playing = false;
+        theta_days_left = std::max(0.0, theta_days_left - (double)theta_speed * dt);
+    }
+
+    bool ThetaAnimationVisible() const
+    {
+        return theta_playing && theta_surface.Ready();
+    }
+
+    // 曲線有更新才發佈；在 DrawButterflyApp (ComputeCurves) 之後呼叫
+    void PublishCurves(CurvePublisher& pub)
+    {
+        if (!pub.IsOpen() || published_generation == curve_generation)
+            return;
+        published_generation = curve_generation;
+
+        const Greeks g = legs.greeks_at(current_price);
+        CurveFrame f;
+        f.xs = xs.data();
+        f.ys_exp = ys_exp.data();
+        f.ys_cur = ys_cur.data();
+        f.n_points = (std::uint32_t)n_points;
+        f.legs_generation = curve_generation;
+        f.publish_time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        f.spot = current_price;
+        f.entry_cost = entry_cost;
+        f.delta = g.delta;
+        f.gamma = g.gamma;
+        f.theta = g.theta;
+        f.vega = g.vega;
+        f.rho = g.rho;
+        pub.Publish(f);
+    }
+
+    // 匯出目前的損益網格 + Greeks
+    void ExportReport(bool json)
+    {
+        SyncButterflyLegs();
+        ComputeCurvesNow();
+        CurveReport rep;
+        rep.legs = &legs;
+        rep.xs = xs.data();
+        rep.ys_exp = ys_exp.data();
+        rep.ys_cur = ys_cur.data();
+        rep.n_points = n_points;
+        rep.entry_cost = entry_cost;
+        const char* path = json ? "butterfly_report.json" : "butterfly_report.csv";
+        const bool ok = json ? ExportCurveJson(path, rep) : ExportCurveCsv(path, rep);
+        snprintf(export_status, sizeof(export_status), ok ? "已匯出 %s" : "匯出失敗: %s", path);
+    }
+};
+
+// ----------------------------- UI -----------------------------
+static void DrawButterflyApp(ButterflyApp& app, ImGuiIO& io)
+{
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::Begin("##Host", nullptr,
+        ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+        ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoBringToFrontOnFocus);
+
+    static char str[256] = "";
+    ImGui::InputText("Test", str, IM_ARRAYSIZE(str));
+
+    ImGui::BeginChild("##Sidebar", ImVec2(600.0f, 0), true);
+    ImGui::Text("1. 市場參數");
+    ImGui::Separator();
+    if (app.config_status[0])
+        ImGui::TextDisabled("%s", app.config_status);
+
+    InputDouble("當前股價 ($)", &app.current_price, 1.0, 5.0, "%.2f");
+    if (app.current_price < 0.01) app.current_price = 0.01;
+    SliderDouble("隱含波動率 (IV %)", &app.iv_pct, 1.0, 150.0, "%.0f");
+    ImGui::SliderInt("距離到期天數", &app.days_to_expiry, 0, 90);
+    InputDouble("無風險利率 (%)", &app.risk_free_pct, 0.1, 1.0, "%.2f");
+    ImGui::Checkbox("利率期限結構 / 股利", &app.use_term_structure);
+    if (app.use_term_structure)
+    {
+        TermStructureInput& ts = app.term_structure;
+        static const char* pillar_names[TermStructureInput::kPillars] = { "1M", "3M", "6M", "1Y", "2Y" };
+        ImGui::TextDisabled("零息利率 (%%，連續複利)；上面的無風險利率此時不使用");
+        for (int p = 0; p < TermStructureInput::kPillars; ++p)
+        {
+            ImGui::PushID(p);
+            ImGui::SetNextItemWidth(70.0f);
+            InputDouble(pillar_names[p], &ts.zero_pct[p], 0.0, 0.0, "%.2f");
+            ImGui::PopID();
+            if (p + 1 < TermStructureInput::kPillars)
+                ImGui::SameLine();
+        }
+        InputDouble("股利率 (%)", &ts.yield_pct, 0.1, 0.5, "%.2f");
+        ImGui::SliderInt("現金股利筆數", &ts.n_dividends, 0, TermStructureInput::kMaxDividends);
+        for (int d = 0; d < ts.n_dividends; ++d)
+        {
+            ImGui::PushID(100 + d);
+            ImGui::SetNextItemWidth(180.0f);
+            InputDouble("除息天數", &ts.div_days[d], 1.0, 7.0, "%.0f");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(180.0f);
+            InputDouble("金額 ($)", &ts.div_amount[d], 0.05, 0.5, "%.2f");
+            ImGui::PopID();
+        }
+    }
+
+    const char* model_items[] = { "Black-Scholes", "Heston", "Bates (Heston + 跳躍)" };
+    ImGui::Combo("定價模型", &app.stoch_vol.model, model_items, IM_ARRAYSIZE(model_items));
+    if (app.stoch_vol.model != PricingModel_BlackScholes)
+    {
+        StochVolInput& sv = app.stoch_vol;
+        ImGui::TextDisabled("COS 定價；上面的 IV 此時不使用");
+        SliderDouble("初始波動率 sqrt(v0) (%)", &sv.v0_vol_pct, 1.0, 150.0, "%.1f");
+        SliderDouble("長期波動率 sqrt(theta) (%)", &sv.theta_vol_pct, 1.0, 150.0, "%.1f");
+        SliderDouble("回復速度 kappa", &sv.kappa, 0.01, 10.0, "%.2f");
+        SliderDouble("波動率的波動率 xi", &sv.xi, 0.01, 2.0, "%.2f");
+        SliderDouble("相關係數 rho", &sv.rho, -0.99, 0.99, "%.2f");
+        if (sv.model == PricingModel_Bates)
+        {
+            SliderDouble("跳躍頻率 (次/年)", &sv.jump_lambda, 0.0, 5.0, "%.2f");
+            SliderDouble("平均跳幅 (%)", &sv.jump_mu_pct, -30.0, 30.0, "%.1f");
+            SliderDouble("跳幅標準差 (%)", &sv.jump_sigma_pct, 0.0, 50.0, "%.1f");
+        }
+    }
+
+    ImGui::Spacing();
+    ImGui::Text("2. 策略設定 (蝶式)");
+    ImGui::Separator();
+    InputDouble("中間履約價 (ATM)", &app.strike_atm, 1.0, 5.0, "%.2f");
+    InputDouble("履約價間距 (Width)", &app.width, 0.5, 1.0, "%.2f");
+    if (app.width < 0.1) app.width = 0.1;
+
+    app.SyncButterflyLegs();
+    const double K_low = app.legs.strike[ButterflyLeg_Low];
+    const double K_mid = app.legs.strike[ButterflyLeg_Mid];
+    const double K_high = app.legs.strike[ButterflyLeg_High];
+
+    ImGui::Spacing();
+    ImGui::TextColored(ImVec4(0.2f, 0.4f, 0.8f, 1), "  Buy 1 Call @ %.2f", K_low);
+    ImGui::TextColored(ImVec4(0.8f, 0.2f, 0.2f, 1), "  Sell 2 Calls @ %.2f", K_mid);
+    ImGui::TextColored(ImVec4(0.2f, 0.4f, 0.8f, 1), "  Buy 1 Call @ %.2f", K_high);
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Checkbox("顯示書中概念對應", &app.show_explain);
+    ImGui::Checkbox("儀表板模式 (多標的)", &app.show_dashboard);
+    ImGui::SameLine();
+    ImGui::Checkbox("延遲量測", &app.show_latency);
+    ImGui::SameLine();
+    ImGui::Checkbox("畫面節奏", &app.show_pacing);
+    ImGui::SameLine();
+    ImGui::Checkbox("風險階梯", &app.show_ladder);
+    ImGui::SameLine();
+    ImGui::Checkbox("記憶體", &app.show_memory);
+    ImGui::Checkbox("高解析 T+0 曲線", &app.dense_curve);
+    if (app.dense_curve)
+    {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200.0f);
+        ImGui::SliderInt("點數", &app.dense_points, 10000, 1000000, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::SameLine();
+        ImGui::TextDisabled(app.polylines.HasGpuBackend() ? "(GPU instanced)" : "(CPU 抽樣)");
+    }
+    ImGui::Checkbox("背景定價 (只算最新參數)", &app.async_pricing);
+    if (ImGui::IsItemHovered())
+    {
+        const auto c = app.curve_job.GetStats();
+        const auto d = app.dense_job.GetStats();
+        ImGui::SetTooltip("曲線: 送出 %llu / 完成 %llu / 覆蓋 %llu / 中止 %llu (上次 %.2f ms)\n"
+            "高解析: 送出 %llu / 完成 %llu / 覆蓋 %llu / 中止 %llu (上次 %.2f ms)",
+            (unsigned long long)c.submitted, (unsigned long long)c.completed, (unsigned long long)c.superseded,
+            (unsigned long long)c.cancelled, c.last_ms,
+            (unsigned long long)d.submitted, (unsigned long long)d.completed, (unsigned long long)d.superseded,
+            (unsigned long long)d.cancelled, d.last_ms);
+    }
+    ImGui::SameLine();
+    const char* precision_items[] = { "float64", "float32 (僅顯示)" };
+    int precision = (int)app.precision;
+    ImGui::SetNextItemWidth(200.0f);
+    if (ImGui::Combo("曲線精度", &precision, precision_items, IM_ARRAYSIZE(precision_items)))
+        app.precision = (CurvePrecision)precision;
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("float32 只用於 T+0 曲線與衰減曲面；成本、Greeks、報表仍為 float64");
+
+    ImGui::Spacing();
+    ImGui::Text("3. 時間衰減動畫");
+    ImGui::Separator();
+    if (ImGui::Button(app.theta_playing ? "停止播放" : "播放到期衰減"))
+    {
+        if (app.theta_playing)
+            app.theta_playing = false;
+        else
+            app.StartThetaAnimation();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::SliderFloat("播放速度 (天/秒)", &app.theta_speed, 1.0f, 30.0f, "%.0f");
+    if (app.theta_playing && !app.theta_surface.Ready())
+        ImGui::ProgressBar(app.theta_surface.Progress(), ImVec2(-1, 0), "預先計算曲面...");
+
+    ImGui::Spacing();
+    ImGui::Text("4. 匯出報表");
+    ImGui::Separator();
+    if (ImGui::Button("匯出 CSV"))
+        app.ExportReport(false);
+    ImGui::SameLine();
+    if (ImGui::Button("匯出 JSON"))
+        app.ExportReport(true);
+    if (app.export_status[0])
+        ImGui::TextDisabled("%s", app.export_status);
+    ImGui::EndChild();
+
+    ImGui::SameLine();
+
+    ImGui::BeginChild("##Content", ImVec2(0, 0), false);
+    ImGui::Text("選擇權策略數學分析：蝶式價差 (Butterfly Spread)");
+    ImGui::TextWrapped("此工具模擬書中強調的「期望值與時間價值」概念。觀察「當前曲線 (T+0)」如何隨著「時間流逝」與「波動率變化」而向到期損益線收斂。");
+    ImGui::Spacing();
+
+    app.ComputeCurves();
+    app.ComputeDenseCurve();
+    app.UpdateThetaAnimation(io.DeltaTime);
+    app.polylines.BeginFrame();
+    const int n_points = ButterflyApp::n_points;
+    const bool anim = app.ThetaAnimationVisible();
+    const double* ys_t0 = anim ? app.ys_anim.data() : app.ys_cur.data();
+
+    double y_min = 1e9, y_max = -1e9;
+    for (int i = 0; i < n_points; ++i)
+    {
+        y_min = std::min(y_min, std::min(app.ys_exp[i], app.ys_cur[i]));
+        y_max = std::max(y_max, std::max(app.ys_exp[i], app.ys_cur[i]));
+        if (anim)
+        {
+            y_min = std::min(y_min, app.ys_anim[i]);
+            y_max = std::max(y_max, app.ys_anim[i]);
+        }
+    }
+    y_min = std::min(y_min, 0.0) - 1.0;
+    y_max = std::max(y_max, 0.0) + 1.0;
+
+    if (anim)
+        ImGui::Text("蝶式價差損益圖 (成本: $%.2f，動畫剩餘 %.1f 天)", app.entry_cost, app.theta_days_left);
+    else
+        ImGui::Text("蝶式價差損益圖 (成本: $%.2f)", app.entry_cost);
+    if (app.CurvesPending())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(計算中...)");
+    }
+    ImGui::SameLine();
+    if (ImGui::SmallButton("重設縮放"))
+        app.fit_view = true;
+    // 現價被移出畫面時自動回到 spot ±25%
+    if (app.view_x_max > app.view_x_min && (app.current_price < app.view_x_min || app.current_price > app.view_x_max))
+        app.fit_view = true;
+    if (ImPlot::BeginPlot("##ButterflyPlot", ImVec2(-1, 500)))
+    {
+        MemTagScope implot_scope(MemTag_ImPlot);
+        ImPlot::SetupAxes("標的股價 (Stock Price)", "損益 (P&L)");
+        if (app.fit_view)
+        {
+            ImPlot::SetupAxisLimits(ImAxis_X1, app.xs.front(), app.xs.back(), ImGuiCond_Always);
+            ImPlot::SetupAxisLimits(ImAxis_Y1, y_min, y_max, ImGuiCond_Always);
+            app.fit_view = false;
+        }
+
+        // [兼容性] 手動畫參考線
+        ImPlotRect limits = ImPlot::GetPlotLimits();
+        app.view_x_min = limits.X.Min;
+        app.view_x_max = limits.X.Max;
+        const bool tiles_done = app.UpdateCurveTiles(limits.X.Min, limits.X.Max, ImPlot::GetPlotSize().x);
+        const CurveVector& tile_xs = app.curve_tiles.Xs();
+        const int n_tile = (int)tile_xs.size();
+        double h_xs[2] = { limits.X.Min, limits.X.Max };
+        double h_ys[2] = { 0.0, 0.0 };
+        ImPlot::SetNextLineStyle(ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
+        ImPlot::PlotLine("##Zero", h_xs, h_ys, 2);
+
+        double v_xs[2] = { app.current_price, app.current_price };
+        double v_ys[2] = { limits.Y.Min, limits.Y.Max };
+        ImPlot::SetNextLineStyle(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), 1.0f);
+        ImPlot::PlotLine("現價", v_xs, v_ys, 2);
+
+        ImPlot::SetNextLineStyle(ImVec4(0.9f, 0.2f, 0.2f, 1.0f), 2.0f);
+        ImPlot::PlotLine("到期損益 (Expiration)", tile_xs.data(), app.curve_tiles.YsExp().data(), n_tile);
+
+        if (app.dense_curve && !anim)
+        {
+            const ImVec4 blue(0.2f, 0.4f, 0.9f, 1.0f);
+            const int n = (int)app.dense_xs.size();
+            app.polylines.PlotShaded("當前損益區域", app.dense_xs.data(), app.dense_ys.data(), n, 0.0, app.dense_version, blue, 0.2f);
+            app.polylines.PlotLine("當前損益 (T+0)", app.dense_xs.data(), app.dense_ys.data(), n, app.dense_version, blue, 3.0f);
+        }
+        else if (anim)
+        {
+            ImPlot::SetNextLineStyle(ImVec4(0.2f, 0.4f, 0.9f, 1.0f), 3.0f);
+            ImPlot::PushStyleVar(ImPlotStyleVar_FillAlpha, 0.2f);
+            ImPlot::PlotShaded("當前損益區域", app.xs.data(), ys_t0, n_points, 0.0);
+            ImPlot::PopStyleVar();
+            ImPlot::PlotLine("當前損益 (T+0)", app.xs.data(), ys_t0, n_points);
+        }
+        else
+        {
+            const double* tile_ys = app.curve_tiles.YsCur().data();
+            ImPlot::SetNextLineStyle(ImVec4(0.2f, 0.4f, 0.9f, 1.0f), 3.0f);
+            ImPlot::PushStyleVar(ImPlotStyleVar_FillAlpha, 0.2f);
+            ImPlot::PlotShaded("當前損益區域", tile_xs.data(), tile_ys, n_tile, 0.0);
+            ImPlot::PopStyleVar();
+            ImPlot::PlotLine("當前損益 (T+0)", tile_xs.data(), tile_ys, n_tile);
+        }
+
+        ImPlot::EndPlot();
+        if (!tiles_done)
+        {
+            const CurveTileCache::Stats& ts = app.curve_tiles.GetStats();
+            if (ts.stale)
+                ImGui::TextDisabled("計算中: 先顯示上一組曲線 (快取 %zu 塊)", ts.tiles_cached);
+            else
+                ImGui::TextDisabled("細化中: 第 %d 層，尚缺 %d / %d 塊 (快取 %zu 塊)", ts.target_level, ts.tiles_missing, ts.tiles_visible, ts.tiles_cached);
+        }
+    }
+    else
+    {
+        app.UpdateCurveTiles(app.view_x_min, app.view_x_max, 0.0f);   // 圖沒畫 (視窗縮小等) 時參考曲線照常更新
+    }
+
+    if (app.legs.model())
+    {
+        app.ComputeSmile();
+        ImGui::Text("模型隱含波動率微笑 (%d 個履約價，COS 定價 %.1f us)", ButterflyApp::smile_points, app.smile_us);
+        if (ImPlot::BeginPlot("##SmilePlot", ImVec2(-1, 250)))
+        {
+            MemTagScope implot_scope(MemTag_ImPlot);
+            ImPlot::SetupAxes("履約價 (Strike)", "隱含波動率 (%)", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot::SetNextLineStyle(ImVec4(0.9f, 0.6f, 0.1f, 1.0f), 2.0f);
+            ImPlot::PlotLine("模型 IV", app.smile_strikes.data(), app.smile_iv.data(), (int)app.smile_strikes.size());
+            const double strikes[ButterflyLeg_COUNT] = { K_low, K_mid, K_high };
+            double leg_iv[ButterflyLeg_COUNT];
+            for (int i = 0; i < ButterflyLeg_COUNT; ++i)
+            {
+                const double* it = std::lower_bound(app.smile_strikes.data(), app.smile_strikes.data() + app.smile_strikes.size(), strikes[i]);
+                const std::size_t j = std::min<std::size_t>(it - app.smile_strikes.data(), app.smile_strikes.size() - 1);
+                leg_iv[i] = app.smile_iv[j];
+            }
+            ImPlot::PlotScatter("蝶式履約價", strikes, leg_iv, ButterflyLeg_COUNT);
+            ImPlot::EndPlot();
+        }
+    }
+
+    if (app.show_explain)
+    {
+        ImGui::Separator();
+        ImGui::Text("書中概念對應:");
+        ImGui::BulletText("期望值區域 (The Tent)：紅色三角形區域是獲利目標區。");
+        ImGui::BulletText("時間價值 (Time Decay)：減少「距離到期天數」，藍線會逐漸隆起貼近紅線。");
+        ImGui::BulletText("波動率風險 (Vega Risk)：增加 IV，藍線會變得更平坦，代表獲利空間被壓縮。");
+    }
+
+    ImGui::EndChild();
+    ImGui::End();
+}
@@ -0,0 +1,701 @@
+// butterfly_pricing.h - 共用定價數學 + SoA 部位 / 行情儲存
+// 三個 demo (OpenGL / SDL_Renderer / SDL_GPU) 共用，只依賴標準函式庫。
+#pragma once
+
+#include "heston_cos.h"
+#include "market_curves.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+// ----------------------------- Math Logic -----------------------------
+static inline double norm_cdf(double x)
+{
+    constexpr double INV_SQRT2 = 0.7071067811865475244008443621048490;
+    return 0.5 * std::erfc(-x * INV_SQRT2);
+}
+
+static inline double black_scholes_call(double S, double K, double T, double r, double sigma)
+{
+    if (T <= 0.0) return std::max(0.0, S - K);
+    if (S <= 0.0 || K <= 0.0 || sigma <= 0.0) return 0.0;
+
+    const double sqrtT = std::sqrt(T);
+    const double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * sqrtT);
+    const double d2 = d1 - sigma * sqrtT;
+    return S * norm_cdf(d1) - K * std::exp(-r * T) * norm_cdf(d2);
+}
+
+// 遠期價 F 的 Black-76 Call；df 由呼叫端預先算好 (同一到期日的所有履約價 / 格點共用)
+static inline double black76_call(double F, double K, double T, double df, double sigma)
+{
+    if (T <= 0.0 || F <= 0.0 || K <= 0.0 || sigma <= 0.0) return df * std::max(0.0, F - K);
+
+    const double vst = sigma * std::sqrt(T);
+    const double d1 = (std::log(F / K) + 0.5 * vst * vst) / vst;
+    return df * (F * norm_cdf(d1) - K * norm_cdf(d1 - vst));
+}
+
+// 買賣權平價：P = C - df (F - K)
+static inline double black76_put(double F, double K, double T, double df, double sigma)
+{
+    return black76_call(F, K, T, df, sigma) - df * (F - K);
+}
+
+static inline double call_payoff(double S, double K)
+{
+    return std::max(0.0, S - K);
+}
+
+static inline double put_payoff(double S, double K)
+{
+    return std::max(0.0, K - S);
+}
+
+// Black-Scholes Call 的 Greeks (theta 以「每年」計，vega / rho 以「每 1.00」計)
+struct Greeks
+{
+    double delta = 0.0;
+    double gamma = 0.0;
+    double theta = 0.0;
+    double vega = 0.0;
+    double rho = 0.0;
+};
+
+static inline double norm_pdf(double x)
+{
+    constexpr double INV_SQRT_2PI = 0.3989422804014326779399460599343819;
+    return INV_SQRT_2PI * std::exp(-0.5 * x * x);
+}
+
+// q：連續股利率 (預設 0)
+static inline Greeks black_scholes_call_greeks(double S, double K, double T, double r, double sigma, double q = 0.0)
+{
+    Greeks g;
+    if (T <= 0.0 || S <= 0.0 || K <= 0.0 || sigma <= 0.0)
+    {
+        g.delta = S > K ? 1.0 : 0.0;
+        return g;
+    }
+
+    const double sqrtT = std::sqrt(T);
+    const double d1 = (std::log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / (sigma * sqrtT);
+    const double d2 = d1 - sigma * sqrtT;
+    const double df = std::exp(-r * T);
+    const double qdf = std::exp(-q * T);
+    const double pdf1 = norm_pdf(d1);
+
+    g.delta = qdf * norm_cdf(d1);
+    g.gamma = qdf * pdf1 / (S * sigma * sqrtT);
+    g.theta = -S * qdf * pdf1 * sigma / (2.0 * sqrtT) + q * S * qdf * norm_cdf(d1) - r * K * df * norm_cdf(d2);
+    g.vega = S * qdf * pdf1 * sqrtT;
+    g.rho = K * T * df * norm_cdf(d2);
+    return g;
+}
+
+// Black-76 隱含波動率：Newton，跳出區間或 vega 太小時改二分；價格不在無套利範圍內回傳 0
+static inline double black76_implied_vol(double price, double F, double K, double T, double df, bool is_call)
+{
+    if (T <= 0.0 || F <= 0.0 || K <= 0.0 || df <= 0.0) return 0.0;
+    const double intrinsic = df * std::max(0.0, is_call ? F - K : K - F);
+    const double upper = df * (is_call ? F : K);
+    if (price <= intrinsic || price >= upper) return 0.0;
+
+    const double sqrtT = std::sqrt(T);
+    double lo = 1e-4, hi = 5.0, sigma = 0.3;
+    for (int it = 0; it < 64; ++it)
+    {
+        const double v = is_call ? black76_call(F, K, T, df, sigma) : black76_put(F, K, T, df, sigma);
+        const double diff = v - price;
+        if (std::fabs(diff) < 1e-12 * std::max(1.0, price)) break;
+        if (diff > 0.0) hi = sigma; else lo = sigma;
+        const double d1 = (std::log(F / K) + 0.5 * sigma * sigma * T) / (sigma * sqrtT);
+        const double vega = df * F * norm_pdf(d1) * sqrtT;
+        const double next = vega > 1e-14 ? sigma - diff / vega : lo - 1.0;
+        sigma = next > lo && next < hi ? next : 0.5 * (lo + hi);
+    }
+    return sigma;
+}
+
+// ----------------------------- Aligned Storage -----------------------------
+// 64-byte 對齊 (cache line / AVX-512)，讓每個欄位都能直接被向量化迴圈讀取
+template <typename T, std::size_t Align = 64>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// ----------------------------- SoA Leg Store -----------------------------
+enum class OptionType : std::uint8_t
+{
+    Call = 0,
+    Put = 1,
+};
+
+struct OptionLeg
+{
+    double strike = 100.0;
+    double expiry = 0.0;      // 年化到期時間 (T)
+    OptionType type = OptionType::Call;
+    double qty = 1.0;         // 正數 = 買進，負數 = 賣出
+    double vol = 0.2;         // 隱含波動率 (小數)
+    double rate = 0.0;        // 無風險利率 (小數)；設定了期限結構 (set_curves) 時不使用
+};
+
+// 選擇權部位與行情報價的欄式 (Structure-of-Arrays) 儲存。
+// 每個欄位是獨立的連續對齊陣列；另外快取每條腿在 spot 下的衍生項與現值，
+// 單一報價變動時只重算那一條腿，總值以差額更新 (O(1))。
+// 設定 MarketCurves (market_curves.h) 後改用零息曲線與股利：折現 / 遠期因子依到期日快取，
+// 同到期日的腿共用；沒有設定時是單一利率、無股利 (div_pv = 0、div_discount = 1)。
+// 設定隨機波動率模型 (heston_cos.h) 後改用 COS 定價：vol 欄位不使用，每個到期日的展開係數快取一份。
+class OptionLegStore
+{
+public:
+    // 原始欄位
+    AlignedVector<double> strike;
+    AlignedVector<double> expiry;
+    AlignedVector<std::uint8_t> type;
+    AlignedVector<double> qty;
+    AlignedVector<double> vol;
+    AlignedVector<double> rate;
+
+    // 衍生欄位 (只隨該腿的輸入改變)
+    AlignedVector<double> sqrt_t;       // sqrt(T)
+    AlignedVector<double> vol_sqrt_t;   // sigma * sqrt(T)
+    AlignedVector<double> drift_t;      // (r - q + 0.5 sigma^2) T
+    AlignedVector<double> discount;     // exp(-r T)
+    AlignedVector<double> div_discount; // exp(-q T)
+    AlignedVector<double> div_pv;       // 到期前現金股利現值 (從 spot 扣掉)
+    AlignedVector<double> value;        // qty * 單腿價格 @ spot()
+
+    std::size_t size() const { return strike.size(); }
+    double spot() const { return spot_; }
+    double total_value() const { return total_value_; }
+    // 任何欄位或 spot 改變都會遞增，供快取 / 快照判斷是否需要更新
+    std::uint64_t generation() const { return generation_; }
+
+    void reserve(std::size_t n)
+    {
+        for_each_column([n](auto& col) { col.reserve(n); });
+    }
+
+    void clear()
+    {
+        for_each_column([](auto& col) { col.clear(); });
+        total_value_ = 0.0;
+        ++generation_;
+    }
+
+    std::size_t add_leg(const OptionLeg& leg)
+    {
+        strike.push_back(leg.strike);
+        expiry.push_back(leg.expiry);
+        type.push_back(static_cast<std::uint8_t>(leg.type));
+        qty.push_back(leg.qty);
+        vol.push_back(leg.vol);
+        rate.push_back(leg.rate);
+        sqrt_t.push_back(0.0);
+        vol_sqrt_t.push_back(0.0);
+        drift_t.push_back(0.0);
+        discount.push_back(1.0);
+        div_discount.push_back(1.0);
+        div_pv.push_back(0.0);
+        value.push_back(0.0);
+
+        const std::size_t i = size() - 1;
+        refresh_leg(i);
+        ++generation_;
+        return i;
+    }
+
+    OptionLeg leg(std::size_t i) const
+    {
+        OptionLeg l;
+        l.strike = strike[i];
+        l.expiry = expiry[i];
+        l.type = static_cast<OptionType>(type[i]);
+        l.qty = qty[i];
+        l.vol = vol[i];
+        l.rate = rate[i];
+        return l;
+    }
+
+    // 單一欄位更新：值沒變就不動，變了只重算該腿
+    void set_strike(std::size_t i, double v) { update(strike, i, v); }
+    void set_expiry(std::size_t i, double v) { update(expiry, i, v); }
+    void set_qty(std::size_t i, double v) { update(qty, i, v); }
+    void set_vol(std::size_t i, double v) { update(vol, i, v); }
+    void set_rate(std::size_t i, double v) { update(rate, i, v); }
+
+    void set_type(std::size_t i, OptionType t)
+    {
+        if (type[i] == static_cast<std::uint8_t>(t)) return;
+        type[i] = static_cast<std::uint8_t>(t);
+        refresh_leg(i);
+        ++generation_;
+    }
+
+    // 整個部位換一組行情 (回測逐 bar 評價用)：所有腿同一個 T / sigma / r，只重算一次
+    void set_market(double s, double T, double sigma, double r)
+    {
+        const std::size_t n = size();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            expiry[i] = T;
+            vol[i] = sigma;
+            rate[i] = r;
+        }
+        spot_ = s;
+        reprice_all();
+        ++generation_;
+    }
+
+    // 換一組利率曲線 / 股利 (nullptr = 回到每腿單一利率)；所有腿重算一次
+    void set_curves(std::shared_ptr<const MarketCurves> curves)
+    {
+        if (curves == curves_) return;
+        curves_ = std::move(curves);
+        factor_cache_.clear();
+        reprice_all();
+        ++generation_;
+    }
+
+    const std::shared_ptr<const MarketCurves>& curves() const { return curves_; }
+
+    // 換定價模型 (nullptr = Black-Scholes)；所有腿重算一次
+    void set_model(std::shared_ptr<const StochVolParams> model)
+    {
+        if (model == model_) return;
+        model_ = std::move(model);
+        cos_cache_.clear();
+        reprice_all();
+        ++generation_;
+    }
+
+    const std::shared_ptr<const StochVolParams>& model() const { return model_; }
+
+    // 目前模型下該到期日的 COS 係數 (refresh 時已建好)；沒有模型或找不到時回傳 nullptr
+    const CosSlice* cos_slice(double T) const
+    {
+        for (const CosSlice& c : cos_cache_)
+            if (c.T == T)
+                return &c;
+        return nullptr;
+    }
+
+    // 現價變動會影響所有腿：線性掃描重算
+    void set_spot(double s)
+    {
+        if (s == spot_) return;
+        spot_ = s;
+        reprice_all();
+        ++generation_;
+    }
+
+    void reprice_all()
+    {
+        const std::size_t n = size();
+        for (std::size_t i = 0; i < n; ++i)
+            refresh_derived(i);
+        price_legs_at(spot_, value.data());
+        total_value_ = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+            total_value_ += value[i];
+    }
+
+    // 批次定價：對單一 spot 掃描所有腿，out[i] = qty * price
+    void price_legs_at(double s, double* out) const
+    {
+        const std::size_t n = size();
+        const double* k = strike.data();
+        const double* q = qty.data();
+        const double* st = sqrt_t.data();
+        const double* vst = vol_sqrt_t.data();
+        const double* dt = drift_t.data();
+        const double* df = discount.data();
+        const double* qdf = div_discount.data();
+        const double* pv = div_pv.data();
+        const std::uint8_t* ty = type.data();
+        if (model_)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = q[i] * model_leg_price(i, s);
+            return;
+        }
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = q[i] * leg_price(s, k[i], st[i], vst[i], dt[i], df[i], qdf[i], pv[i], ty[i]);
+    }
+
+    // 部位 T+0 曲線：ys[j] = sum_i qty_i * price_i(spots[j])
+    // 外層跑腿、內層跑連續的 spot 陣列，腿參數在內層是常數
+    void price_curve(const double* spots, int n_points, double* ys) const
+    {
+        std::fill(ys, ys + n_points, 0.0);
+        const std::size_t n = size();
+        if (model_)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                add_model_curve(i, spots, n_points, ys);
+            return;
+        }
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const double k = strike[i], q = qty[i];
+            const double vst = vol_sqrt_t[i], dt = drift_t[i], df = discount[i];
+            const double qdf = div_discount[i], pv = div_pv[i];
+            const std::uint8_t ty = type[i];
+            // 腿層級的特例 (已到期、參數無效) 提到迴圈外
+            if (sqrt_t[i] <= 0.0 || k <= 0.0 || vst <= 0.0)
+            {
+                for (int j = 0; j < n_points; ++j)
+                    ys[j] += q * leg_price(spots[j], k, sqrt_t[i], vst, dt, df, qdf, pv, ty);
+                continue;
+            }
+            // 內層沒有分支：put = call + w_put (K df - s qdf)，s <= 0 用 select 換成下限 (call 0、put K df)，
+            // log 的引數先夾成正數以免 NaN。本 repo 的建置不開 -ffast-math，std::log / erfc 仍是逐點的純量呼叫，
+            // 這個迴圈不會向量化 (省下的是逐點的分支)；要 SIMD 走 curve_precision.h 的 float32 路徑
+            const double w_put = ty == static_cast<std::uint8_t>(OptionType::Put) ? 1.0 : 0.0;
+            const double kdf = k * df, inv_k = 1.0 / k, inv_vst = 1.0 / vst;
+            const double floor_value = q * w_put * kdf;
+            for (int j = 0; j < n_points; ++j)
+            {
+                const double s = spots[j] - pv;
+                const double d1 = (std::log(std::max(s, 1e-300) * inv_k) + dt) * inv_vst;
+                const double d2 = d1 - vst;
+                const double sq = s * qdf;
+                const double v = sq * norm_cdf(d1) - kdf * norm_cdf(d2) + w_put * (kdf - sq);
+                ys[j] += s > 0.0 ? q * v : floor_value;
+            }
+        }
+    }
+
+    // 部位 Greeks (現價 S)；Put 由買賣權平價自 Call 推得。
+    // 期限結構下以該到期日的等效零息利率 / 股利率計算，現金股利以 S - div_pv 處理
+    Greeks greeks_at(double S) const
+    {
+        Greeks pos;
+        const std::size_t n = size();
+        if (model_)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                const Greeks g = model_leg_greeks(i, S);
+                const double q = qty[i];
+                pos.delta += q * g.delta;
+                pos.gamma += q * g.gamma;
+                pos.theta += q * g.theta;
+                pos.vega += q * g.vega;
+                pos.rho += q * g.rho;
+            }
+            return pos;
+        }
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const double T = std::max(0.0, expiry[i]);
+            const double s_adj = S - div_pv[i];
+            double r = rate[i], q_yield = 0.0;
+            if (curves_ && T > 0.0)
+            {
+                r = -std::log(discount[i]) / T;
+                q_yield = -std::log(div_discount[i]) / T;
+            }
+            Greeks g = black_scholes_call_greeks(s_adj, strike[i], T, r, vol[i], q_yield);
+            if (type[i] == static_cast<std::uint8_t>(OptionType::Put))
+            {
+                g.delta -= div_discount[i];
+                g.theta += r * strike[i] * discount[i] - q_yield * s_adj * div_discount[i];
+                g.rho -= strike[i] * T * discount[i];
+            }
+            const double q = qty[i];
+            pos.delta += q * g.delta;
+            pos.gamma += q * g.gamma;
+            pos.theta += q * g.theta;
+            pos.vega += q * g.vega;
+            pos.rho += q * g.rho;
+        }
+        return pos;
+    }
+
+    // 部位到期損益曲線 (intrinsic)
+    void payoff_curve(const double* spots, int n_points, double* ys) const
+    {
+        std::fill(ys, ys + n_points, 0.0);
+        const std::size_t n = size();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const double k = strike[i], q = qty[i];
+            if (type[i] == static_cast<std::uint8_t>(OptionType::Put))
+                for (int j = 0; j < n_points; ++j) ys[j] += q * put_payoff(spots[j], k);
+            else
+                for (int j = 0; j < n_points; ++j) ys[j] += q * call_payoff(spots[j], k);
+        }
+    }
+
+private:
+    double spot_ = 0.0;
+    double total_value_ = 0.0;
+    std::uint64_t generation_ = 0;
+    std::shared_ptr<const MarketCurves> curves_;
+    std::vector<ExpiryFactors> factor_cache_;   // 依到期日；同到期日的腿共用
+    std::shared_ptr<const StochVolParams> model_;
+    std::vector<CosSlice> cos_cache_;           // 依到期日；複製 store 時一起複製，背景執行緒各用各的
+
+    template <typename F>
+    void for_each_column(F&& f)
+    {
+        f(strike); f(expiry); f(type); f(qty); f(vol); f(rate);
+        f(sqrt_t); f(vol_sqrt_t); f(drift_t); f(discount); f(div_discount); f(div_pv); f(value);
+    }
+
+    void update(AlignedVector<double>& col, std::size_t i, double v)
+    {
+        if (col[i] == v) return;
+        col[i] = v;
+        refresh_leg(i);
+        ++generation_;
+    }
+
+    // 曲線 / 股利不變時，同一個到期日只算一次 exp (theta 曲面逐日改到期日，快取設上限)
+    const ExpiryFactors& expiry_factors(double T)
+    {
+        for (const ExpiryFactors& f : factor_cache_)
+            if (f.T == T)
+                return f;
+        if (factor_cache_.size() >= 64)
+            factor_cache_.clear();
+        factor_cache_.push_back(curves_->factors(T));
+        return factor_cache_.back();
+    }
+
+    // 同 expiry_factors；快取滿了就清掉，再替其他腿的到期日補回來 (價格迴圈假設每條腿都找得到)
+    void ensure_cos_slice(double T)
+    {
+        if (T <= 0.0 || cos_slice(T))
+            return;
+        if (cos_cache_.size() >= 64)
+        {
+            cos_cache_.clear();
+            for (std::size_t j = 0; j < size(); ++j)
+            {
+                const double Tj = std::max(0.0, expiry[j]);
+                if (Tj > 0.0 && Tj != T && !cos_slice(Tj))
+                    cos_cache_.push_back(build_cos_slice(*model_, Tj));
+            }
+        }
+        cos_cache_.push_back(build_cos_slice(*model_, T));
+    }
+
+    void refresh_derived(std::size_t i)
+    {
+        const double T = std::max(0.0, expiry[i]);
+        const double s = vol[i];
+        sqrt_t[i] = std::sqrt(T);
+        vol_sqrt_t[i] = s * sqrt_t[i];
+        if (model_)
+            ensure_cos_slice(T);
+        if (curves_)
+        {
+            const ExpiryFactors& f = expiry_factors(T);
+            drift_t[i] = f.carry_t + 0.5 * s * s * T;
+            discount[i] = f.df;
+            div_discount[i] = f.div_df;
+            div_pv[i] = f.div_pv;
+            return;
+        }
+        const double r = rate[i];
+        drift_t[i] = (r + 0.5 * s * s) * T;
+        discount[i] = std::exp(-r * T);
+        div_discount[i] = 1.0;
+        div_pv[i] = 0.0;
+    }
+
+    void refresh_leg(std::size_t i)
+    {
+        refresh_derived(i);
+        const double old_value = value[i];
+        value[i] = qty[i] * (model_ ? model_leg_price(i, spot_)
+            : leg_price(spot_, strike[i], sqrt_t[i], vol_sqrt_t[i], drift_t[i], discount[i], div_discount[i], div_pv[i], type[i]));
+        total_value_ += value[i] - old_value;
+    }
+
+    // 模型下單腿價格，與 leg_price 相同的慣例 (已到期 = 內含價值，S - div_pv <= 0 時 call 為 0、put 為 K df)
+    static double model_price(const CosSlice* slice, double S, double K, double df, double qdf, double pv, std::uint8_t ty)
+    {
+        const bool is_put = ty == static_cast<std::uint8_t>(OptionType::Put);
+        if (!slice) return is_put ? put_payoff(S, K) : call_payoff(S, K);
+        const double s = S - pv;
+        if (K <= 0.0) return 0.0;
+        if (s <= 0.0) return is_put ? K * df : 0.0;
+        const double fk = s * qdf / (df * K);
+        double put = 0.0;
+        cos_put_grid(*slice, &fk, 1, &put);
+        put *= K * df;
+        return is_put ? put : put + s * qdf - K * df;
+    }
+
+    double model_leg_price(std::size_t i, double S) const
+    {
+        return model_price(cos_slice(std::max(0.0, expiry[i])), S, strike[i], discount[i], div_discount[i], div_pv[i], type[i]);
+    }
+
+    // 一條腿整段格點：F/K 一次算好交給 cos_put_grid，同一組係數跑完所有點
+    void add_model_curve(std::size_t i, const double* spots, int n_points, double* ys) const
+    {
+        constexpr int kBlock = 256;
+        const double k = strike[i], q = qty[i], df = discount[i], qdf = div_discount[i], pv = div_pv[i];
+        const bool is_put = type[i] == static_cast<std::uint8_t>(OptionType::Put);
+        const CosSlice* slice = cos_slice(std::max(0.0, expiry[i]));
+        if (!slice)
+        {
+            for (int j = 0; j < n_points; ++j)
+                ys[j] += q * (is_put ? put_payoff(spots[j], k) : call_payoff(spots[j], k));
+            return;
+        }
+        if (k <= 0.0)
+            return;
+        alignas(64) double fk[kBlock];
+        alignas(64) double put[kBlock];
+        const double to_fk = qdf / (df * k);
+        const double floor_value = is_put ? q * k * df : 0.0;
+        for (int b = 0; b < n_points; b += kBlock)
+        {
+            const int m = std::min(kBlock, n_points - b);
+            for (int j = 0; j < m; ++j)
+                fk[j] = std::max(1e-12, (spots[b + j] - pv) * to_fk);
+            cos_put_grid(*slice, fk, m, put);
+            for (int j = 0; j < m; ++j)
+            {
+                const double s = spots[b + j] - pv;
+                const double p = put[j] * k * df;
+                const double v = is_put ? p : p + s * qdf - k * df;
+                ys[b + j] += s > 0.0 ? q * v : floor_value;
+            }
+        }
+    }
+
+    // 模型下的單腿 Greeks 全部在模型內重新定價：delta / gamma 以 spot 中央差分，theta 以少一天 (或剩餘時間)
+    // 重建係數差分，vega 平移 sqrt(v0)、rho 平移利率曲線 (該腿的 vol 在模型下不使用)
+    Greeks model_leg_greeks(std::size_t i, double S) const
+    {
+        const double T = std::max(0.0, expiry[i]);
+        const double K = strike[i], df = discount[i], qdf = div_discount[i], pv = div_pv[i];
+        const std::uint8_t ty = type[i];
+        const CosSlice* slice = cos_slice(T);
+        Greeks g;
+        if (!slice || S <= 0.0)
+        {
+            const bool itm = ty == static_cast<std::uint8_t>(OptionType::Put) ? S < K : S > K;
+            g.delta = itm ? (ty == static_cast<std::uint8_t>(OptionType::Put) ? -1.0 : 1.0) : 0.0;
+            return g;
+        }
+        const double h = 1e-3 * S;
+        const double v0 = model_price(slice, S, K, df, qdf, pv, ty);
+        const double up = model_price(slice, S + h, K, df, qdf, pv, ty);
+        const double dn = model_price(slice, S - h, K, df, qdf, pv, ty);
+        g.delta = (up - dn) / (2.0 * h);
+        g.gamma = (up - 2.0 * v0 + dn) / (h * h);
+
+        const double dT = std::min(1.0 / 365.0, T);
+        const double T1 = T - dT;
+        double df1 = 1.0, qdf1 = 1.0, pv1 = 0.0;
+        if (curves_)
+        {
+            const ExpiryFactors f = curves_->factors(T1);
+            df1 = f.df, qdf1 = f.div_df, pv1 = f.div_pv;
+        }
+        else
+            df1 = std::exp(-rate[i] * T1);
+        const CosSlice later = build_cos_slice(*model_, T1);
+        g.theta = (model_price(T1 > 0.0 ? &later : nullptr, S, K, df1, qdf1, pv1, ty) - v0) / dT;
+
+        // vega：對初始波動度 sqrt(v0) 中央差分 (v0 是模型裡唯一對應「目前 vol」的參數)
+        const double sigma0 = std::sqrt(std::max(0.0, model_->v0));
+        const double hv = 1e-3;
+        const double sigma_dn = std::max(0.0, sigma0 - hv);
+        StochVolParams bumped = *model_;
+        bumped.v0 = (sigma0 + hv) * (sigma0 + hv);
+        const CosSlice vol_up = build_cos_slice(bumped, T);
+        bumped.v0 = sigma_dn * sigma_dn;
+        const CosSlice vol_dn = build_cos_slice(bumped, T);
+        g.vega = (model_price(&vol_up, S, K, df, qdf, pv, ty) - model_price(&vol_dn, S, K, df, qdf, pv, ty)) / (sigma0 + hv - sigma_dn);
+
+        // rho：整條零息曲線 (或單一利率) 平移 ±hr 重新定價；COS 係數只跟模型與 T 有關，沿用同一個 slice
+        const double hr = 1e-4;
+        const double p_up = model_price(slice, S, K, shifted_factors(i, T, hr), ty);
+        const double p_dn = model_price(slice, S, K, shifted_factors(i, T, -hr), ty);
+        g.rho = (p_up - p_dn) / (2.0 * hr);
+        return g;
+    }
+
+    // 利率平移 shift 後的折現因子；曲線節點全部加 shift 即為 r(t) T 的平行移動 (現金股利現值也跟著變)
+    ExpiryFactors shifted_factors(std::size_t i, double T, double shift) const
+    {
+        if (curves_)
+        {
+            MarketCurves c = *curves_;
+            if (c.rates.times.empty())
+                c.rates.add_pillar(1.0, 0.0);
+            for (double& r : c.rates.rates)
+                r += shift;
+            return c.factors(T);
+        }
+        ExpiryFactors f;
+        f.T = T;
+        f.df = std::exp(-(rate[i] + shift) * T);
+        return f;
+    }
+
+    static double model_price(const CosSlice* slice, double S, double K, const ExpiryFactors& f, std::uint8_t ty)
+    {
+        return model_price(slice, S, K, f.df, f.div_df, f.div_pv, ty);
+    }
+
+    // Black-76 寫成 spot 形式，吃預先算好的衍生項；Put 由買賣權平價求得。
+    // 單一利率、無股利時 (qdf = 1、pv = 0) 與 black_scholes_call 相同
+    static inline double leg_price(double S, double K, double sqrtT, double vol_sqrtT,
+        double driftT, double df, double qdf, double pv, std::uint8_t ty)
+    {
+        const bool is_put = ty == static_cast<std::uint8_t>(OptionType::Put);
+        if (sqrtT <= 0.0) return is_put ? put_payoff(S, K) : call_payoff(S, K);
+        const double s = S - pv;
+        if (K <= 0.0) return 0.0;
+        if (s <= 0.0) return is_put ? K * df : 0.0;   // 標的淨值歸零：call 一文不值，put 必定履約
+        if (vol_sqrtT <= 0.0) return 0.0;
+
+        const double d1 = (std::log(s / K) + driftT) / vol_sqrtT;
+        const double d2 = d1 - vol_sqrtT;
+        const double call = s * qdf * norm_cdf(d1) - K * df * norm_cdf(d2);
+        return is_put ? call - s * qdf + K * df : call;
+    }
+};
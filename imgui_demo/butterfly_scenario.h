@@ -0,0 +1,143 @@
+// butterfly_scenario.h - 單一情境 (spot / IV / 天數 / 利率 / 履約價 / 間距) 的蝶式風險計算
+// GUI 與 CLI 共用；每個執行緒各自持有一個 ScenarioPricer，彼此不共享狀態。
+#pragma once
+
+#include "butterfly_pricing.h"
+
+#include <cstdint>
+#include <vector>
+
+// 二進位情境檔：8-byte magic + u64 筆數 + Scenario[筆數] (native endian)
+static constexpr char kScenarioFileMagic[8] = { 'B', 'F', 'L', 'Y', 'S', 'C', 'N', '1' };
+
+struct Scenario
+{
+    double spot;
+    double iv_pct;
+    double days;
+    double rate_pct;
+    double strike_atm;
+    double width;
+};
+
+struct ScenarioResult
+{
+    double entry_cost = 0.0;
+    double t0_min = 0.0;         // T+0 損益在網格上的最小 / 最大 / 平均
+    double t0_max = 0.0;
+    double t0_mean = 0.0;
+    double expiry_min = 0.0;     // 到期損益 = 最大虧損
+    double expiry_max = 0.0;     // 到期損益 = 最大獲利
+    Greeks greeks;               // 部位 Greeks (現價)
+};
+
+class ScenarioPricer
+{
+public:
+    explicit ScenarioPricer(int n_points = 200)
+        : n_points_(n_points), xs_(n_points), ys_(n_points)
+    {
+        legs_.add_leg({ 95.0, 0.0, OptionType::Call, 1.0, 0.2, 0.0 });
+        legs_.add_leg({ 100.0, 0.0, OptionType::Call, -2.0, 0.2, 0.0 });
+        legs_.add_leg({ 105.0, 0.0, OptionType::Call, 1.0, 0.2, 0.0 });
+    }
+
+    ScenarioResult Evaluate(const Scenario& sc)
+    {
+        const double sigma = sc.iv_pct / 100.0;
+        const double r = sc.rate_pct / 100.0;
+        const double T = std::max(0.0, sc.days / 365.0);
+        double strikes[3];
+        SetScenario(sc, strikes);
+
+        ScenarioResult res;
+        res.entry_cost = legs_.total_value();
+
+        const double x_min = sc.spot * 0.75;
+        const double x_max = sc.spot * 1.25;
+        for (int i = 0; i < n_points_; ++i)
+            xs_[i] = x_min + (x_max - x_min) * i / (n_points_ - 1);
+
+        legs_.price_curve(xs_.data(), n_points_, ys_.data());
+        double lo = ys_[0], hi = ys_[0], sum = 0.0;
+        for (int i = 0; i < n_points_; ++i)
+        {
+            lo = std::min(lo, ys_[i]);
+            hi = std::max(hi, ys_[i]);
+            sum += ys_[i];
+        }
+        res.t0_min = lo - res.entry_cost;
+        res.t0_max = hi - res.entry_cost;
+        res.t0_mean = sum / n_points_ - res.entry_cost;
+
+        legs_.payoff_curve(xs_.data(), n_points_, ys_.data());
+        lo = ys_[0]; hi = ys_[0];
+        for (int i = 0; i < n_points_; ++i)
+        {
+            lo = std::min(lo, ys_[i]);
+            hi = std::max(hi, ys_[i]);
+        }
+        res.expiry_min = lo - res.entry_cost;
+        res.expiry_max = hi - res.entry_cost;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const Greeks g = black_scholes_call_greeks(sc.spot, strikes[i], T, r, sigma);
+            const double q = legs_.qty[i];
+            res.greeks.delta += q * g.delta;
+            res.greeks.gamma += q * g.gamma;
+            res.greeks.theta += q * g.theta;
+            res.greeks.vega += q * g.vega;
+            res.greeks.rho += q * g.rho;
+        }
+        return res;
+    }
+
+    // 填入與 GUI 相同的曲線 (x 範圍 0.75S ~ 1.25S，已扣除成本)，回傳成本
+    double EvaluateCurves(const Scenario& sc, double* xs, double* ys_exp, double* ys_cur)
+    {
+        double strikes[3];
+        SetScenario(sc, strikes);
+        const double entry_cost = legs_.total_value();
+
+        const double x_min = sc.spot * 0.75;
+        const double x_max = sc.spot * 1.25;
+        for (int i = 0; i < n_points_; ++i)
+            xs[i] = x_min + (x_max - x_min) * i / (n_points_ - 1);
+        legs_.payoff_curve(xs, n_points_, ys_exp);
+        legs_.price_curve(xs, n_points_, ys_cur);
+        for (int i = 0; i < n_points_; ++i)
+        {
+            ys_exp[i] -= entry_cost;
+            ys_cur[i] -= entry_cost;
+        }
+        return entry_cost;
+    }
+
+    int n_points() const { return n_points_; }
+
+private:
+    int n_points_;
+    OptionLegStore legs_;
+    std::vector<double> xs_, ys_;
+
+    void SetScenario(const Scenario& sc, double strikes[3])
+    {
+        const double sigma = sc.iv_pct / 100.0;
+        const double r = sc.rate_pct / 100.0;
+        const double T = std::max(0.0, sc.days / 365.0);
+        const double width = std::max(0.1, sc.width);
+        strikes[0] = sc.strike_atm - width;
+        strikes[1] = sc.strike_atm;
+        strikes[2] = sc.strike_atm + width;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            legs_.set_strike(i, strikes[i]);
+            legs_.set_expiry(i, T);
+            legs_.set_vol(i, sigma);
+            legs_.set_rate(i, r);
+        }
+        legs_.set_spot(sc.spot);
+    }
+};
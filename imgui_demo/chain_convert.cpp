@@ -0,0 +1,320 @@
+// chain_convert.cpp - 選擇權鏈 CSV 轉欄式二進位檔，及檢視 / 讀取效能測試 (option_chain.h)
+//
+// 用法:
+//   chain_convert <chain.csv> <out.chain>                         CSV -> 二進位
+//   chain_convert --info <file.chain> [--verify]                  摘要 + 開檔 / 全表掃描耗時
+//   chain_convert --dump <file.chain> <YYYY-MM-DD> [expiry] [symbol]   印出某日 (某到期日) 的報價
+//   chain_convert --generate <days> <out.csv> [symbols]           產生隨機全鏈資料 (壓力測試用)
+//
+// CSV 欄位: timestamp,underlying,expiry,strike,type,bid,ask,iv,oi (第一行若不是資料視為標題)
+//   timestamp 為 YYYY-MM-DD[ HH:MM[:SS]] 或 Unix 秒，expiry 為 YYYY-MM-DD，type 為 C/P (或 call/put)，iv 為小數。
+// 輸入以 4 MB 區塊串流解析；時間與數值欄位的解析與 backtest 共用 backtest_engine.h。
+
+#include "option_chain.h"
+#include "backtest_engine.h"
+#include "report_export.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static std::string_view ParseToken(const char*& p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    const char* b = p;
+    while (p < end && *p != ',') ++p;
+    const char* e = p;
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t')) --e;
+    if (p < end) ++p;
+    return std::string_view(b, e - b);
+}
+
+static bool ParseOptionType(std::string_view s, std::uint8_t& out)
+{
+    if (s.empty()) return false;
+    const char c = s[0];
+    if (c == 'C' || c == 'c') { out = 0; return true; }
+    if (c == 'P' || c == 'p') { out = 1; return true; }
+    return false;
+}
+
+static std::string FormatDay(std::int64_t day)
+{
+    int y;
+    unsigned m, d;
+    chain_civil_from_days(day, y, m, d);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%04d-%02u-%02u", y, m, d);
+    return buf;
+}
+
+static bool ParseDay(const char* s, std::int32_t& out)
+{
+    double t;
+    const char* p = s;
+    if (!ParseBacktestTime(p, s + strlen(s), t))
+        return false;
+    out = chain_day_of((std::int64_t)t);
+    return true;
+}
+
+static int Convert(const char* in_path, const char* out_path)
+{
+    const auto t_start = std::chrono::steady_clock::now();
+    FILE* f = fopen(in_path, "rb");
+    if (!f)
+    {
+        printf("Error: cannot open %s\n", in_path);
+        return -1;
+    }
+
+    OptionChainBuilder builder;
+    std::vector<char> buf(4 << 20);
+    std::string carry;   // 跨區塊的半行
+    std::uint64_t line_no = 0, skipped = 0;
+
+    auto handle_line = [&](const char* b, const char* e) {
+        ++line_no;
+        if (e > b && e[-1] == '\r') --e;
+        if (b == e) return;
+        const char* p = b;
+        ChainQuote q;
+        double ts, expiry, strike, bid, ask, iv, oi;
+        std::string_view sym;
+        const bool ok = ParseBacktestTime(p, e, ts) && !(sym = ParseToken(p, e)).empty() &&
+            ParseBacktestTime(p, e, expiry) && ParseBacktestDouble(p, e, strike) && ParseOptionType(ParseToken(p, e), q.type) &&
+            ParseBacktestDouble(p, e, bid) && ParseBacktestDouble(p, e, ask) && ParseBacktestDouble(p, e, iv) &&
+            ParseBacktestDouble(p, e, oi);
+        if (!ok || strike <= 0.0)
+        {
+            if (line_no != 1)   // 第一行允許是標題
+                ++skipped;
+            return;
+        }
+        q.timestamp = (std::int64_t)ts;
+        q.expiry_day = chain_day_of((std::int64_t)expiry);
+        q.underlying = builder.SymbolId(sym);
+        q.strike = strike;
+        q.bid = (float)bid;
+        q.ask = (float)ask;
+        q.iv = (float)iv;
+        q.oi = oi > 0.0 ? (std::uint32_t)std::min(oi, 4294967295.0) : 0u;
+        builder.Add(q);
+    };
+
+    std::size_t n;
+    while ((n = fread(buf.data(), 1, buf.size(), f)) > 0)
+    {
+        const char* p = buf.data();
+        const char* end = p + n;
+        while (p < end)
+        {
+            const char* nl = (const char*)memchr(p, '\n', end - p);
+            if (!nl)
+            {
+                carry.append(p, end);
+                break;
+            }
+            if (!carry.empty())
+            {
+                carry.append(p, nl);
+                handle_line(carry.data(), carry.data() + carry.size());
+                carry.clear();
+            }
+            else
+            {
+                handle_line(p, nl);
+            }
+            p = nl + 1;
+        }
+    }
+    if (!carry.empty())
+        handle_line(carry.data(), carry.data() + carry.size());
+    fclose(f);
+
+    const double parse_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    if (!builder.Write(out_path))
+        return -1;
+    const double total_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    printf("Converted %zu quotes (%llu lines skipped): parse %.3f s, encode + write %.3f s -> %s\n",
+        builder.size(), (unsigned long long)skipped, parse_sec, total_sec - parse_sec, out_path);
+    return 0;
+}
+
+static int Info(const char* path, bool verify)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    OptionChainFile chain;
+    if (!chain.Open(path, verify))
+        return -1;
+    const auto t1 = std::chrono::steady_clock::now();
+
+    // 全表掃描：解每組履約價並累加，確保每一頁都真的讀進來
+    double sum = 0.0;
+    std::uint64_t oi_total = 0;
+    for (std::size_t i = 0; i < chain.group_count(); ++i)
+    {
+        chain.ForEachQuote(chain.groups()[i], [&](const ChainQuote& q) {
+            sum += q.strike + 0.5 * (q.bid + q.ask) + q.iv;
+            oi_total += q.oi;
+        });
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    printf("%s: %.1f MB, %zu quotes, %zu groups, %zu days, %zu symbols, strike tick %g\n", path,
+        chain.file_size() / (1024.0 * 1024.0), chain.row_count(), chain.group_count(), chain.date_count(),
+        chain.symbol_count(), chain.strike_tick());
+    if (chain.date_count() > 0)
+        printf("Dates: %s .. %s\n", FormatDay(chain.dates()[0].day).c_str(), FormatDay(chain.dates()[chain.date_count() - 1].day).c_str());
+    for (std::uint32_t s = 0; s < chain.symbol_count() && s < 16; ++s)
+        printf("  symbol %u: %.*s\n", s, (int)chain.Symbol(s).size(), chain.Symbol(s).data());
+    printf("Open%s: %.3f ms, full scan: %.3f ms (checksum %.6g, total OI %llu)\n", verify ? " + verify" : "",
+        std::chrono::duration<double, std::milli>(t1 - t0).count(), std::chrono::duration<double, std::milli>(t2 - t1).count(),
+        sum, (unsigned long long)oi_total);
+    return 0;
+}
+
+static int Dump(const char* path, const char* date, const char* expiry, const char* symbol)
+{
+    OptionChainFile chain;
+    if (!chain.Open(path))
+        return -1;
+    std::int32_t day, expiry_day = 0;
+    if (!ParseDay(date, day) || (expiry && !ParseDay(expiry, expiry_day)))
+    {
+        printf("Error: bad date (expected YYYY-MM-DD)\n");
+        return -1;
+    }
+    int sym = -1;
+    if (symbol && (sym = chain.FindSymbol(symbol)) < 0)
+    {
+        printf("Error: symbol %s not in %s\n", symbol, path);
+        return -1;
+    }
+
+    const auto range = chain.GroupsOnDate(day);
+    std::size_t shown = 0;
+    for (const ChainGroup* g = range.first; g != range.second; ++g)
+    {
+        if ((expiry && g->expiry_day != expiry_day) || (sym >= 0 && g->underlying != (std::uint32_t)sym))
+            continue;
+        const std::string_view name = chain.Symbol(g->underlying);
+        printf("-- %.*s ts=%lld expiry=%s (%u quotes)\n", (int)name.size(), name.data(), (long long)g->timestamp,
+            FormatDay(g->expiry_day).c_str(), g->row_count);
+        if (!expiry)
+            continue;   // 沒指定到期日時只列群組
+        chain.ForEachQuote(*g, [&](const ChainQuote& q) {
+            printf("  %10.3f %c  bid %9.4f  ask %9.4f  iv %7.2f%%  oi %u\n", q.strike, q.type ? 'P' : 'C', q.bid, q.ask, q.iv * 100.0, q.oi);
+        });
+        ++shown;
+    }
+    if (range.first == range.second)
+        printf("No data on %s\n", date);
+    else if (expiry && shown == 0)
+        printf("No expiry %s on %s\n", expiry, date);
+    return 0;
+}
+
+// 每個交易日一份收盤鏈：週到期 + 月到期，履約價 spot ±40%，Black-Scholes 報價加上價差
+static int Generate(int days, const char* path, int n_symbols)
+{
+    ReportFile file(path);
+    if (!file.ok())
+        return -1;
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> N01(0.0, 1.0);
+    std::vector<double> spot(n_symbols, 100.0);
+    std::vector<std::string> names(n_symbols);
+    for (int s = 0; s < n_symbols; ++s)
+        names[s] = n_symbols == 1 ? "SPY" : "SYM" + std::to_string(s);
+
+    fmt::memory_buffer& buf = file.buffer();
+    auto out = std::back_inserter(buf);
+    fmt::format_to(out, "timestamp,underlying,expiry,strike,type,bid,ask,iv,oi\n");
+    const std::int64_t day0 = backtest_days_from_civil(2023, 1, 2);
+    std::uint64_t rows = 0;
+    for (std::int64_t day = day0, traded = 0; traded < days; ++day)
+    {
+        const int dow = (int)((day + 4) % 7);   // 0 = 週日
+        if (dow == 0 || dow == 6)
+            continue;
+        ++traded;
+        const std::string date = FormatDay(day);
+        for (int s = 0; s < n_symbols; ++s)
+        {
+            const double iv = 0.2;
+            spot[s] *= std::exp(-0.5 * iv * iv / 252.0 + iv / std::sqrt(252.0) * N01(rng));
+            // 未來 8 個週五 + 之後 4 個月的第三個週五 (近似為第 15-21 日的週五)
+            std::vector<std::int64_t> expiries;
+            std::int64_t fri = day + (5 - dow + 7) % 7;
+            for (int k = 0; k < 8; ++k)
+                expiries.push_back(fri + 7 * k);
+            for (std::int64_t e = fri + 56; (int)expiries.size() < 12; e += 7)
+            {
+                int y;
+                unsigned m, d;
+                chain_civil_from_days(e, y, m, d);
+                if (d >= 15 && d <= 21)
+                    expiries.push_back(e);
+            }
+            const double step = spot[s] < 50.0 ? 0.5 : spot[s] < 200.0 ? 1.0 : 5.0;
+            const double lo = std::ceil(spot[s] * 0.6 / step) * step;
+            const double hi = spot[s] * 1.4;
+            for (std::int64_t e : expiries)
+            {
+                const double T = std::max(1.0, (double)(e - day)) / 365.0;
+                const std::string exp = FormatDay(e);
+                // 同一到期日的所有履約價共用折現 / 遠期
+                const double df = std::exp(-0.04 * T);
+                const double F = spot[s] / df;
+                for (double k = lo; k <= hi; k += step)
+                {
+                    const double m = std::log(k / spot[s]);
+                    const double vol = iv + 0.3 * m * m - 0.1 * m;   // 簡單的 smile / skew
+                    const double call = black76_call(F, k, T, df, vol);
+                    const double put = call - df * (F - k);
+                    const std::uint32_t oi = (std::uint32_t)(5000.0 * std::exp(-8.0 * m * m) / (1.0 + 10.0 * T));
+                    for (int t = 0; t < 2; ++t)
+                    {
+                        const double mid = std::max(0.01, t == 0 ? call : put);
+                        const double half = std::max(0.01, mid * 0.01);
+                        fmt::format_to(out, FMT_COMPILE("{},{},{},{},{},{},{},{},{}\n"), date, names[s], exp, Fx4(k),
+                            t == 0 ? 'C' : 'P', Fx4(std::max(0.0, mid - half)), Fx4(mid + half), Fx6(vol), oi);
+                        file.Commit();
+                        ++rows;
+                    }
+                }
+            }
+        }
+    }
+    if (!file.Close())
+        return -1;
+    printf("Generated %llu quotes over %d trading days: %s\n", (unsigned long long)rows, days, path);
+    return 0;
+}
+
+// ----------------------------- Main -----------------------------
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "--info") == 0)
+        return Info(argv[2], argc >= 4 && strcmp(argv[3], "--verify") == 0);
+    if (argc >= 4 && strcmp(argv[1], "--dump") == 0)
+        return Dump(argv[2], argv[3], argc >= 5 ? argv[4] : nullptr, argc >= 6 ? argv[5] : nullptr);
+    if (argc >= 4 && strcmp(argv[1], "--generate") == 0)
+        return Generate(std::max(1, atoi(argv[2])), argv[3], argc >= 5 ? std::max(1, atoi(argv[4])) : 1);
+    if (argc == 3 && argv[1][0] != '-')
+        return Convert(argv[1], argv[2]);
+
+    printf("Usage: %s <chain.csv> <out.chain>\n", argv[0]);
+    printf("       %s --info <file.chain> [--verify]\n", argv[0]);
+    printf("       %s --dump <file.chain> <YYYY-MM-DD> [expiry YYYY-MM-DD] [symbol]\n", argv[0]);
+    printf("       %s --generate <days> <out.csv> [symbols]\n", argv[0]);
+    return -1;
+}
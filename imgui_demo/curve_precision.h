@@ -0,0 +1,184 @@
+// curve_precision.h - 顯示用曲線的精度策略 (float64 / float32)
+//
+// 只給「畫出來」的數值用：T+0 曲線、衰減曲面。成本 (entry_cost)、Greeks、報表仍走
+// OptionLegStore 的 double 路徑。
+//   - CurveMath<double> 直接用 std::log / erfc，結果與 OptionLegStore::price_curve 相同
+//   - CurveMath<float> 用無分支的多項式 log / exp / N(x)，內層迴圈可以自動向量化，
+//     一條 SIMD 暫存器裝得下兩倍的點 (GCC 需 -O3，即 CMake Release 預設；-O2 不會向量化這種迴圈)
+// 誤差界線由 precision_check CLI 以「圖上像素」驗證。
+#pragma once
+
+#include "butterfly_pricing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+enum class CurvePrecision : int
+{
+    Float64 = 0,
+    Float32 = 1,
+};
+
+template <typename Real>
+struct CurveMath;
+
+template <>
+struct CurveMath<double>
+{
+    static inline double Log(double x) { return std::log(x); }
+    static inline double NormCdf(double x) { return norm_cdf(x); }
+    static inline double IfPositive(double s, double v, double otherwise) { return s > 0.0 ? v : otherwise; }
+};
+
+// Cephes logf / expf 的多項式 + Abramowitz & Stegun 26.2.17 的 N(x) (|誤差| < 7.5e-8)。
+// 條件一律用整數位元運算做 select：預設 -ftrapping-math 下，浮點比較會讓 GCC 放棄 if-conversion，
+// 迴圈就無法向量化。
+template <>
+struct CurveMath<float>
+{
+    static inline float Log(float x)
+    {
+        const std::uint32_t bits = std::bit_cast<std::uint32_t>(x);
+        const std::int32_t e0 = (std::int32_t)(bits >> 23) - 126;
+        const std::uint32_t mbits = (bits & 0x007fffffu) | 0x3f000000u;   // [0.5, 1)
+        const std::int32_t small = -(std::int32_t)(mbits < 0x3f3504f3u);   // m < sqrt(0.5)：全 1
+        const float m0 = std::bit_cast<float>(mbits);
+        const float e = (float)(e0 + small);
+        const float m = m0 + std::bit_cast<float>(std::bit_cast<std::int32_t>(m0) & small) - 1.0f;
+        const float z = m * m;
+        float y = 7.0376836292e-2f;
+        y = y * m - 1.1514610310e-1f;
+        y = y * m + 1.1676998740e-1f;
+        y = y * m - 1.2420140846e-1f;
+        y = y * m + 1.4249322787e-1f;
+        y = y * m - 1.6668057665e-1f;
+        y = y * m + 2.0000714765e-1f;
+        y = y * m - 2.4999993993e-1f;
+        y = y * m + 3.3333331174e-1f;
+        y = y * m * z;
+        y += -2.12194440e-4f * e;
+        y += -0.5f * z;
+        return m + y + 0.693359375f * e;
+    }
+
+    // 只接受 x <= 0 (N(x) 的 exp(-x^2/2))；先在位元上夾到 -87 以免指數下溢
+    static inline float ExpNonPositive(float x)
+    {
+        const std::int32_t kMinBits = std::bit_cast<std::int32_t>(-87.0f);
+        x = std::bit_cast<float>(std::min(std::bit_cast<std::int32_t>(x), kMinBits));
+        // 加上 1.5 * 2^23 讓 FPU 直接四捨五入成整數
+        constexpr float kRound = 12582912.0f;
+        const float t = x * 1.44269504088896341f + kRound;
+        const std::int32_t n = std::bit_cast<std::int32_t>(t) - std::bit_cast<std::int32_t>(kRound);
+        const float fn = t - kRound;
+        x -= fn * 0.693359375f;
+        x -= fn * -2.12194440e-4f;
+        const float z = x * x;
+        float y = 1.9875691500e-4f;
+        y = y * x + 1.3981999507e-3f;
+        y = y * x + 8.3334519073e-3f;
+        y = y * x + 4.1665795894e-2f;
+        y = y * x + 1.6666665459e-1f;
+        y = y * x + 5.0000001201e-1f;
+        y = y * z + x + 1.0f;
+        return y * std::bit_cast<float>((std::uint32_t)(n + 127) << 23);
+    }
+
+    static inline float NormCdf(float x)
+    {
+        const float ax = std::fabs(x);
+        const float t = 1.0f / (1.0f + 0.2316419f * ax);
+        const float poly = t * (0.319381530f + t * (-0.356563782f + t * (1.781477937f + t * (-1.821255978f + t * 1.330274429f))));
+        const float tail = 0.3989422804014327f * ExpNonPositive(-0.5f * x * x) * poly;
+        const float upper = 1.0f - tail;
+        const std::int32_t neg = std::bit_cast<std::int32_t>(x) >> 31;   // x < 0：全 1
+        return std::bit_cast<float>((std::bit_cast<std::int32_t>(upper) & ~neg) | (std::bit_cast<std::int32_t>(tail) & neg));
+    }
+
+    static inline float IfPositive(float s, float v, float otherwise)
+    {
+        const std::int32_t pos = -(std::int32_t)(std::bit_cast<std::int32_t>(s) > 0);
+        return std::bit_cast<float>((std::bit_cast<std::int32_t>(v) & pos) | (std::bit_cast<std::int32_t>(otherwise) & ~pos));
+    }
+};
+
+// 與 OptionLegStore::price_curve 相同的計算，純量型別由 Real 決定。
+// 腿層級的分支 (已到期、Put) 提到內層迴圈外；float 版內層沒有分支，可以向量化。
+template <typename Real>
+static void price_curve_as(const OptionLegStore& legs, const Real* spots, int n_points, Real* ys)
+{
+    using M = CurveMath<Real>;
+    std::fill(ys, ys + n_points, Real(0));
+    for (std::size_t i = 0; i < legs.size(); ++i)
+    {
+        const Real k = (Real)legs.strike[i], q = (Real)legs.qty[i];
+        const Real vst = (Real)legs.vol_sqrt_t[i], dt = (Real)legs.drift_t[i], df = (Real)legs.discount[i];
+        const Real qdf = (Real)legs.div_discount[i], pv = (Real)legs.div_pv[i];
+        const bool is_put = legs.type[i] == static_cast<std::uint8_t>(OptionType::Put);
+        if (legs.sqrt_t[i] <= 0.0)
+        {
+            for (int j = 0; j < n_points; ++j)
+            {
+                const Real put = std::max(Real(0), k - spots[j]), call = std::max(Real(0), spots[j] - k);
+                ys[j] += q * (is_put ? put : call);
+            }
+            continue;
+        }
+        if (k <= Real(0) || vst <= Real(0))
+            continue;
+        if (is_put)
+        {
+            const Real floor_value = q * k * df;   // S - div_pv <= 0：put 為 K df
+            for (int j = 0; j < n_points; ++j)
+            {
+                const Real s = spots[j] - pv;
+                const Real d1 = (M::Log(s / k) + dt) / vst;
+                const Real d2 = d1 - vst;
+                const Real call = s * qdf * M::NormCdf(d1) - k * df * M::NormCdf(d2);
+                ys[j] += M::IfPositive(s, q * (call - s * qdf + k * df), floor_value);
+            }
+        }
+        else
+        {
+            for (int j = 0; j < n_points; ++j)
+            {
+                const Real s = spots[j] - pv;
+                const Real d1 = (M::Log(s / k) + dt) / vst;
+                const Real d2 = d1 - vst;
+                const Real call = s * qdf * M::NormCdf(d1) - k * df * M::NormCdf(d2);
+                ys[j] += M::IfPositive(s, q * call, Real(0));
+            }
+        }
+    }
+}
+
+// 顯示路徑的入口：輸入 / 輸出都是 double 陣列 (ImPlot、快照、共享記憶體都吃 double)，
+// Float32 時以 1024 點為一段轉成 float 計算再放寬回 double。
+static void price_curve_display(const OptionLegStore& legs, const double* spots, int n_points, double* ys, CurvePrecision precision)
+{
+    // 隨機波動率模型 (COS) 只有 double 版
+    if (legs.model())
+    {
+        legs.price_curve(spots, n_points, ys);
+        return;
+    }
+    if (precision == CurvePrecision::Float64)
+    {
+        price_curve_as<double>(legs, spots, n_points, ys);
+        return;
+    }
+    constexpr int kBlock = 1024;
+    alignas(64) float fs[kBlock];
+    alignas(64) float fy[kBlock];
+    for (int b = 0; b < n_points; b += kBlock)
+    {
+        const int m = std::min(kBlock, n_points - b);
+        for (int j = 0; j < m; ++j)
+            fs[j] = (float)spots[b + j];
+        price_curve_as<float>(legs, fs, m, fy);
+        for (int j = 0; j < m; ++j)
+            ys[b + j] = fy[j];
+    }
+}
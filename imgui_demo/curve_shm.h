@@ -0,0 +1,381 @@
+// curve_shm.h - 把損益曲線與 Greeks 發佈到共享記憶體，讓同機的其他程序 (風險彙總、logger) 直接讀
+//
+// 區段配置 (native endian，只給同一台機器)：
+//   CurveShmHeader (一個 cache line 的 seq + 固定欄位)
+//   xs[capacity], ys_exp[capacity], ys_cur[capacity] (double)
+//
+// 同步是 seqlock：寫入端先把 seq 設成奇數、寫資料、再設成下一個偶數；
+// 讀取端讀前後各看一次 seq，相同且為偶數才算一致的快照，否則重試。
+// 熱路徑 (Publish / Read) 只有記憶體存取，沒有 syscall、沒有鎖；寫入端永遠不會被讀取端擋住。
+// POSIX 用 shm_open + mmap，Windows 用具名的 page-file mapping。
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char kCurveShmMagic[8] = { 'B', 'F', 'L', 'Y', 'C', 'U', 'R', 'V' };
+static constexpr std::uint32_t kCurveShmVersion = 1;
+static constexpr const char* kCurveShmDefaultName = "/butterfly_curves";
+
+struct alignas(64) CurveShmHeader
+{
+    std::atomic<std::uint64_t> seq;   // 奇數 = 寫入中
+    char pad0[56];
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t capacity;           // 每條曲線的最大點數 (建立時決定)
+    std::uint64_t total_size;
+    std::atomic<std::uint32_t> closed; // 發佈端結束時設為 1
+
+    // 以下受 seq 保護
+    std::uint32_t n_points;
+    std::uint64_t publish_count;
+    std::uint64_t legs_generation;
+    double publish_time;              // Unix 秒
+    double spot;
+    double entry_cost;
+    double delta, gamma, theta, vega, rho;   // 部位 Greeks @ spot (theta 每年、vega / rho 每 1.00)
+    std::uint64_t checksum;           // 上面欄位與三條曲線的 FNV-1a，給測試 / 稽核用
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "seqlock needs a lock-free 64-bit atomic");
+
+// 一份曲線與 Greeks；發佈端用指標指向自己的陣列，讀取端拷貝到 vector
+struct CurveFrame
+{
+    const double* xs = nullptr;
+    const double* ys_exp = nullptr;
+    const double* ys_cur = nullptr;
+    std::uint32_t n_points = 0;
+    std::uint64_t legs_generation = 0;
+    double publish_time = 0.0;
+    double spot = 0.0;
+    double entry_cost = 0.0;
+    double delta = 0.0, gamma = 0.0, theta = 0.0, vega = 0.0, rho = 0.0;
+};
+
+struct CurveSnapshot
+{
+    std::uint64_t seq = 0;
+    std::uint64_t publish_count = 0;
+    std::uint64_t legs_generation = 0;
+    double publish_time = 0.0;
+    double spot = 0.0;
+    double entry_cost = 0.0;
+    double delta = 0.0, gamma = 0.0, theta = 0.0, vega = 0.0, rho = 0.0;
+    std::uint64_t checksum = 0;
+    std::vector<double> xs, ys_exp, ys_cur;
+};
+
+static inline std::uint64_t curve_shm_fnv(std::uint64_t h, const void* data, std::size_t n)
+{
+    const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+    for (std::size_t i = 0; i < n; ++i)
+        h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+static inline std::uint64_t curve_shm_checksum(std::uint64_t legs_generation, double spot, double entry_cost,
+    const double* xs, const double* ys_exp, const double* ys_cur, std::uint32_t n)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    h = curve_shm_fnv(h, &legs_generation, sizeof(legs_generation));
+    h = curve_shm_fnv(h, &spot, sizeof(spot));
+    h = curve_shm_fnv(h, &entry_cost, sizeof(entry_cost));
+    h = curve_shm_fnv(h, xs, n * sizeof(double));
+    h = curve_shm_fnv(h, ys_exp, n * sizeof(double));
+    h = curve_shm_fnv(h, ys_cur, n * sizeof(double));
+    return h;
+}
+
+static inline std::size_t curve_shm_size(std::uint32_t capacity)
+{
+    return sizeof(CurveShmHeader) + 3 * (std::size_t)capacity * sizeof(double);
+}
+
+// ----------------------------- 共享記憶體映射 -----------------------------
+class CurveShmMapping
+{
+public:
+    CurveShmMapping() = default;
+    ~CurveShmMapping() { Close(); }
+
+    CurveShmMapping(const CurveShmMapping&) = delete;
+    CurveShmMapping& operator=(const CurveShmMapping&) = delete;
+
+    // create = true：建立 (或覆蓋) 並設定大小；false：開啟既有區段，大小從 header 讀
+    bool Open(const char* name, bool create, std::size_t size)
+    {
+        Close();
+        name_ = name;
+#ifdef _WIN32
+        std::string win_name = std::string("Local\\") + (name[0] == '/' ? name + 1 : name);
+        if (create)
+            mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                (DWORD)((std::uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFFu), win_name.c_str());
+        else
+            mapping_ = OpenFileMappingA(FILE_MAP_READ, FALSE, win_name.c_str());
+        if (!mapping_)
+            return false;
+        data_ = MapViewOfFile(mapping_, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+        if (!data_) { Close(); return false; }
+        if (!create)
+        {
+            MEMORY_BASIC_INFORMATION info;
+            if (VirtualQuery(data_, &info, sizeof(info)) == 0) { Close(); return false; }
+            size = info.RegionSize;
+        }
+        size_ = size;
+        return true;
+#else
+        const int fd = create ? shm_open(name, O_CREAT | O_RDWR, 0600) : shm_open(name, O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+        if (create && ftruncate(fd, (off_t)size) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        if (!create)
+        {
+            struct stat st;
+            if (fstat(fd, &st) != 0) { close(fd); return false; }
+            size = (std::size_t)st.st_size;
+        }
+        void* p = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED)
+            return false;
+        data_ = p;
+        size_ = size;
+        owner_ = create;
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        mapping_ = NULL;
+#else
+        if (data_) munmap(data_, size_);
+        // 已開著的讀取端映射不受影響，新的讀取端則找不到區段
+        if (owner_) shm_unlink(name_.c_str());
+        owner_ = false;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    void* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    std::string name_;
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE mapping_ = NULL;
+#else
+    bool owner_ = false;
+#endif
+};
+
+// ----------------------------- 發佈端 -----------------------------
+class CurvePublisher
+{
+public:
+    bool Open(const char* name = kCurveShmDefaultName, std::uint32_t capacity = 4096)
+    {
+        if (!map_.Open(name, true, curve_shm_size(capacity)))
+        {
+            printf("Error: cannot create shared memory %s\n", name);
+            return false;
+        }
+        header_ = new (map_.data()) CurveShmHeader();
+        header_->seq.store(0, std::memory_order_relaxed);
+        header_->closed.store(0, std::memory_order_relaxed);
+        header_->version = kCurveShmVersion;
+        header_->capacity = capacity;
+        header_->total_size = map_.size();
+        // magic 最後寫，讀取端看到 magic 時其餘固定欄位已就緒
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(header_->magic, kCurveShmMagic, sizeof(kCurveShmMagic));
+        printf("Publishing curves to shared memory %s (%u points)\n", name, capacity);
+        return true;
+    }
+
+    ~CurvePublisher()
+    {
+        if (header_)
+            header_->closed.store(1, std::memory_order_release);
+    }
+
+    bool IsOpen() const { return header_ != nullptr; }
+    std::uint64_t PublishCount() const { return header_ ? header_->publish_count : 0; }
+
+    // 熱路徑：純記憶體寫入。超過容量的曲線截斷 (只警告一次)
+    void Publish(const CurveFrame& f)
+    {
+        if (!header_)
+            return;
+        std::uint32_t n = f.n_points;
+        if (n > header_->capacity)
+        {
+            if (!warned_capacity_)
+                printf("Warning: curve has %u points, shared memory holds %u; truncated.\n", n, header_->capacity);
+            warned_capacity_ = true;
+            n = header_->capacity;
+        }
+
+        CurveShmHeader& h = *header_;
+        const std::uint64_t s = h.seq.load(std::memory_order_relaxed);
+        h.seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        h.n_points = n;
+        h.publish_count = h.publish_count + 1;
+        h.legs_generation = f.legs_generation;
+        h.publish_time = f.publish_time;
+        h.spot = f.spot;
+        h.entry_cost = f.entry_cost;
+        h.delta = f.delta;
+        h.gamma = f.gamma;
+        h.theta = f.theta;
+        h.vega = f.vega;
+        h.rho = f.rho;
+        double* arrays = reinterpret_cast<double*>(&h + 1);
+        memcpy(arrays, f.xs, n * sizeof(double));
+        memcpy(arrays + h.capacity, f.ys_exp, n * sizeof(double));
+        memcpy(arrays + 2 * (std::size_t)h.capacity, f.ys_cur, n * sizeof(double));
+        h.checksum = curve_shm_checksum(f.legs_generation, f.spot, f.entry_cost, f.xs, f.ys_exp, f.ys_cur, n);
+
+        h.seq.store(s + 2, std::memory_order_release);
+    }
+
+private:
+    CurveShmMapping map_;
+    CurveShmHeader* header_ = nullptr;
+    bool warned_capacity_ = false;
+};
+
+// ----------------------------- 讀取端 -----------------------------
+class CurveShmReader
+{
+public:
+    bool Open(const char* name = kCurveShmDefaultName)
+    {
+        header_ = nullptr;
+        if (!map_.Open(name, false, 0))
+            return false;
+        if (map_.size() < sizeof(CurveShmHeader))
+            return Fail();
+        const CurveShmHeader* h = static_cast<const CurveShmHeader*>(map_.data());
+        if (memcmp(h->magic, kCurveShmMagic, sizeof(kCurveShmMagic)) != 0)
+            return Fail();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (h->version != kCurveShmVersion || map_.size() < curve_shm_size(h->capacity))
+            return Fail();
+        header_ = h;
+        return true;
+    }
+
+    bool IsOpen() const { return header_ != nullptr; }
+    // 發佈端已結束 (區段內容停在最後一次發佈)
+    bool PublisherClosed() const { return header_ && header_->closed.load(std::memory_order_acquire) != 0; }
+    // 不讀資料，只看有沒有新版本 (輪詢用)
+    std::uint64_t Sequence() const { return header_ ? header_->seq.load(std::memory_order_acquire) : 0; }
+    std::uint64_t Retries() const { return retries_; }
+
+    // 零拷貝讀取：visit(header, xs, ys_exp, ys_cur) 直接讀映射記憶體，結束後再確認 seq；
+    // 被寫入打斷時重試。visit 可能被呼叫多次，內容只有在回傳 true 時才算一致，
+    // 所以 visit 只能做可丟棄的計算 (例如彙總到區域變數)。
+    template <typename Visit>
+    bool TryVisit(Visit&& visit, int max_attempts = 64)
+    {
+        if (!header_)
+            return false;
+        const double* arrays = reinterpret_cast<const double*>(header_ + 1);
+        const std::uint32_t cap = header_->capacity;
+        for (int attempt = 0; attempt < max_attempts; ++attempt)
+        {
+            const std::uint64_t s0 = header_->seq.load(std::memory_order_acquire);
+            if (s0 & 1)
+            {
+                ++retries_;
+                continue;
+            }
+            if (s0 == 0)
+                return false;   // 還沒發佈過
+            const std::uint32_t n = std::min(header_->n_points, cap);
+            visit(*header_, n, arrays, arrays + cap, arrays + 2 * (std::size_t)cap);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header_->seq.load(std::memory_order_relaxed) == s0)
+                return true;
+            ++retries_;
+        }
+        return false;
+    }
+
+    // 拷貝一份一致的快照到 out (out 的 vector 容量重複使用)
+    bool Read(CurveSnapshot& out, int max_attempts = 64)
+    {
+        return TryVisit([&](const CurveShmHeader& h, std::uint32_t n, const double* xs, const double* ys_exp, const double* ys_cur) {
+            out.seq = h.seq.load(std::memory_order_relaxed);
+            out.publish_count = h.publish_count;
+            out.legs_generation = h.legs_generation;
+            out.publish_time = h.publish_time;
+            out.spot = h.spot;
+            out.entry_cost = h.entry_cost;
+            out.delta = h.delta;
+            out.gamma = h.gamma;
+            out.theta = h.theta;
+            out.vega = h.vega;
+            out.rho = h.rho;
+            out.checksum = h.checksum;
+            out.xs.assign(xs, xs + n);
+            out.ys_exp.assign(ys_exp, ys_exp + n);
+            out.ys_cur.assign(ys_cur, ys_cur + n);
+        }, max_attempts);
+    }
+
+    // 重新計算 checksum，驗證快照沒有被撕裂
+    static bool Verify(const CurveSnapshot& s)
+    {
+        return curve_shm_checksum(s.legs_generation, s.spot, s.entry_cost,
+            s.xs.data(), s.ys_exp.data(), s.ys_cur.data(), (std::uint32_t)s.xs.size()) == s.checksum;
+    }
+
+private:
+    CurveShmMapping map_;
+    const CurveShmHeader* header_ = nullptr;
+    std::uint64_t retries_ = 0;
+
+    bool Fail()
+    {
+        map_.Close();
+        return false;
+    }
+};
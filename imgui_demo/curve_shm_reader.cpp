@@ -0,0 +1,169 @@
+// curve_shm_reader.cpp - 讀取 GUI 發佈到共享記憶體的損益曲線 (curve_shm.h 的本機測試 consumer)
+//
+// 用法:
+//   curve_shm_reader [/name] [--count N] [--interval-ms N]   輪詢並印出每一份新快照
+//   curve_shm_reader --selftest [seconds] [readers]          程序內一個寫入端 + N 個讀取端壓力測試
+//
+// GUI 端以 --publish-curves[=/name] 啟動後才有區段可讀。每份快照都重算 checksum，
+// 不一致 (撕裂讀取) 時回報；selftest 結束時撕裂數應為 0。
+
+#include "curve_shm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+static void PrintSnapshot(const CurveSnapshot& s, bool ok)
+{
+    double t0_min = 0.0, t0_max = 0.0;
+    if (!s.ys_cur.empty())
+    {
+        const auto mm = std::minmax_element(s.ys_cur.begin(), s.ys_cur.end());
+        t0_min = *mm.first;
+        t0_max = *mm.second;
+    }
+    printf("#%llu gen=%llu spot=%.2f cost=%.4f delta=%.4f gamma=%.4f theta/day=%.4f vega/%%=%.4f points=%zu t0=[%.4f, %.4f]%s\n",
+        (unsigned long long)s.publish_count, (unsigned long long)s.legs_generation, s.spot, s.entry_cost,
+        s.delta, s.gamma, s.theta / 365.0, s.vega / 100.0, s.xs.size(), t0_min, t0_max, ok ? "" : "  ** CHECKSUM MISMATCH **");
+}
+
+static int Watch(const char* name, long long max_count, int interval_ms)
+{
+    CurveShmReader reader;
+    if (!reader.Open(name))
+    {
+        printf("Error: cannot open shared memory %s (is the GUI running with --publish-curves?)\n", name);
+        return -1;
+    }
+
+    CurveSnapshot snap;
+    std::uint64_t last_seq = 0;
+    long long shown = 0, bad = 0;
+    while (max_count <= 0 || shown < max_count)
+    {
+        // 先看 seq 有沒有變，沒變就不讀資料
+        const std::uint64_t seq = reader.Sequence();
+        if (seq != last_seq && !(seq & 1) && reader.Read(snap))
+        {
+            last_seq = snap.seq;
+            const bool ok = CurveShmReader::Verify(snap);
+            bad += ok ? 0 : 1;
+            PrintSnapshot(snap, ok);
+            ++shown;
+        }
+        else if (reader.PublisherClosed())
+        {
+            printf("Publisher closed.\n");
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+    printf("Snapshots: %lld  checksum errors: %lld  retries: %llu\n", shown, bad, (unsigned long long)reader.Retries());
+    return bad == 0 ? 0 : 1;
+}
+
+// 寫入端盡全力發佈、讀取端盡全力讀；每份讀到的快照都必須通過 checksum
+static int SelfTest(double seconds, int n_readers)
+{
+    const char* name = "/butterfly_curves_selftest";
+    const std::uint32_t n = 200;
+    CurvePublisher pub;
+    if (!pub.Open(name, n))
+        return -1;
+
+    std::atomic<bool> stop(false);
+    std::atomic<long long> reads(0), torn(0), retries(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < n_readers; ++r)
+    {
+        readers.emplace_back([&] {
+            CurveShmReader reader;
+            if (!reader.Open(name))
+            {
+                printf("Error: reader cannot open %s\n", name);
+                return;
+            }
+            CurveSnapshot snap;
+            long long local_reads = 0, local_torn = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (!reader.Read(snap))
+                {
+                    std::this_thread::yield();   // 寫入中，讓出 CPU 給寫入端
+                    continue;
+                }
+                ++local_reads;
+                if (!CurveShmReader::Verify(snap))
+                    ++local_torn;
+            }
+            reads += local_reads;
+            torn += local_torn;
+            retries += (long long)reader.Retries();
+        });
+    }
+
+    std::vector<double> xs(n), ys_exp(n), ys_cur(n);
+    const auto t_start = std::chrono::steady_clock::now();
+    std::uint64_t gen = 0;
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count() < seconds)
+    {
+        ++gen;
+        const double spot = 90.0 + (gen % 200) * 0.1;
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            xs[i] = spot * (0.75 + 0.5 * i / (n - 1));
+            ys_exp[i] = std::sin(xs[i] + gen);
+            ys_cur[i] = std::cos(xs[i] - gen);
+        }
+        CurveFrame f;
+        f.xs = xs.data();
+        f.ys_exp = ys_exp.data();
+        f.ys_cur = ys_cur.data();
+        f.n_points = n;
+        f.legs_generation = gen;
+        f.spot = spot;
+        f.entry_cost = gen * 0.001;
+        pub.Publish(f);
+    }
+    stop = true;
+    for (std::thread& t : readers)
+        t.join();
+
+    printf("Self-test: %llu publishes, %lld consistent reads, %lld retries, %lld torn\n",
+        (unsigned long long)pub.PublishCount(), reads.load(), retries.load(), torn.load());
+    return torn.load() == 0 ? 0 : 1;
+}
+
+// ----------------------------- Main -----------------------------
+int main(int argc, char** argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "--selftest") == 0)
+    {
+        const double seconds = argc >= 3 ? atof(argv[2]) : 2.0;
+        const int n_readers = argc >= 4 ? std::max(1, atoi(argv[3])) : 2;
+        return SelfTest(seconds, n_readers);
+    }
+
+    const char* name = kCurveShmDefaultName;
+    long long count = 0;
+    int interval_ms = 50;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--interval-ms") == 0 && i + 1 < argc) interval_ms = std::max(1, atoi(argv[++i]));
+        else if (argv[i][0] == '/') name = argv[i];
+        else
+        {
+            printf("Usage: %s [/name] [--count N] [--interval-ms N]\n", argv[0]);
+            printf("       %s --selftest [seconds] [readers]\n", argv[0]);
+            return -1;
+        }
+    }
+    return Watch(name, count, interval_ms);
+}
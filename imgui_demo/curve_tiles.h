@@ -0,0 +1,312 @@
+// curve_tiles.h - 可縮放 / 平移的損益曲線：只算可見範圍，解析度配合像素寬度，逐幀細化
+//
+// x 軸切成 2 的冪次層級：第 L 層每塊寬 base / 2^L (base = 不小於 spot 的 2 的冪次)、固定 kTileSamples 個點，再加上落在塊內的
+// 履約價 (到期損益的折角精確落在點上，放大到哪裡都不會被截角)。每幀：
+//   1. 依可見寬度 / 像素寬度挑目標層級 (約一像素一點)
+//   2. 缺的塊列成 TileRequest：粗略層 (目標 - kCoarseLevels) 在前、目標層在後，一批最多 kBatchTiles 塊
+//   3. 呼叫端把請求交給背景 worker (latest_wins.h) 以 BuildTiles 計算，完成的 TileBatch 再 Accept 回來；
+//      UI 執行緒只組曲線、不定價。目標層還沒算到的區段先用最細的已算祖先塊
+// 塊以 (層級, 索引) 快取；部位 / 精度改變時舊的一組留著繼續畫，新一組的粗略層蓋滿可見範圍才換上。
+// 平移回看過的地方直接命中。點都是直接定價 (不內插)，深度放大的結果與完整曲線相同。
+#pragma once
+
+#include "butterfly_pricing.h"
+#include "curve_precision.h"
+#include "latest_wins.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CurveTileCache
+{
+public:
+    static constexpr int kTileSamples = 64;
+    static constexpr int kCoarseLevels = 3;
+    static constexpr int kMinLevel = -16;   // 負層級 = 比 base 更寬的塊 (極度縮小時塊數不會爆掉)
+    static constexpr int kMaxLevel = 40;
+    static constexpr std::size_t kMaxTiles = 4096;
+    static constexpr int kBatchTiles = 16;  // 平移中新請求取代舊請求時，丟掉的工作最多這麼多塊
+
+    struct Key
+    {
+        int level;
+        std::int64_t index;
+        bool operator==(const Key&) const = default;
+    };
+
+    struct Tile
+    {
+        CurveVector xs, ys_cur, ys_exp;
+        std::uint64_t last_frame = 0;
+    };
+
+    // 塊的內容只由這幾個值決定
+    struct TileState
+    {
+        std::uint64_t generation = ~0ull;
+        CurvePrecision precision = CurvePrecision::Float64;
+        double entry_cost = 0.0;
+        double base_width = 128.0;
+        bool operator==(const TileState&) const = default;
+    };
+
+    struct TileRequest
+    {
+        TileState state;
+        std::vector<Key> keys;
+        bool operator==(const TileRequest&) const = default;
+    };
+
+    struct TileBatch
+    {
+        TileState state;
+        std::vector<std::pair<Key, Tile>> tiles;
+    };
+
+    struct Stats
+    {
+        int target_level = 0;
+        int tiles_visible = 0;
+        int tiles_missing = 0;      // 目標層還沒算到的可見塊
+        std::size_t tiles_cached = 0;
+        bool stale = false;         // 畫的是上一組 (部位 / 精度改變前) 的塊
+    };
+
+    void Invalidate()
+    {
+        current_ = TileSet();
+        previous_ = TileSet();
+        current_shown_ = false;
+        request_ = TileRequest();
+    }
+
+    // 組出 [x_min, x_max] 的曲線 (Xs / YsCur / YsExp，已扣 entry_cost) 並列出缺的塊 (PendingRequest)；
+    // 回傳 true 表示已是目前參數的目標解析度
+    bool Update(const OptionLegStore& legs, double entry_cost, CurvePrecision precision,
+                double x_min, double x_max, float pixel_width)
+    {
+        TileState state;
+        state.generation = legs.generation();
+        state.precision = precision;
+        state.entry_cost = entry_cost;
+        state.base_width = std::exp2(std::ceil(std::log2(std::max(1.0, legs.spot()))));
+        if (!(state == current_.state))
+        {
+            // 畫出來過的那組留作舊曲線；還沒畫過就被取代的直接丟掉，保留更早那組
+            if (current_shown_)
+                previous_ = std::move(current_);
+            current_ = TileSet();
+            current_.state = state;
+            current_shown_ = false;
+        }
+        ++frame_;
+        stats_ = Stats();
+        xs_.clear();
+        ys_cur_.clear();
+        ys_exp_.clear();
+        request_.state = state;
+        request_.keys.clear();
+
+        x_min = std::max(0.0, x_min);
+        if (!(x_max > x_min) || pixel_width < 1.0f)
+            return true;
+
+        const int target = TargetLevel(current_, x_min, x_max, pixel_width);
+        const int coarse = std::max(kMinLevel, target - kCoarseLevels);
+        stats_.target_level = target;
+
+        bool coarse_ready = true;
+        ForEachIndex(current_, coarse, x_min, x_max, [&](std::int64_t idx) {
+            if (Find(current_, coarse, idx))
+                return;
+            coarse_ready = false;
+            AddRequest(coarse, idx);
+        });
+        ForEachIndex(current_, target, x_min, x_max, [&](std::int64_t idx) {
+            ++stats_.tiles_visible;
+            if (Find(current_, target, idx))
+                return;
+            ++stats_.tiles_missing;
+            AddRequest(target, idx);
+        });
+
+        // 新一組還蓋不滿可見範圍時沿用舊的一組；蓋滿之後舊的就不再需要
+        if (!coarse_ready && !previous_.tiles.empty())
+        {
+            Assemble(previous_, x_min, x_max, pixel_width);
+            stats_.stale = true;
+        }
+        else
+        {
+            Assemble(current_, x_min, x_max, pixel_width);
+            current_shown_ = true;
+            if (coarse_ready)
+                previous_ = TileSet();
+        }
+
+        Evict();
+        stats_.tiles_cached = current_.tiles.size() + previous_.tiles.size();
+        return !stats_.stale && stats_.tiles_missing == 0;
+    }
+
+    // 這一幀還缺的塊 (粗略層在前)；keys 為空表示不需要再算
+    const TileRequest& PendingRequest() const { return request_; }
+
+    // 收下背景算好的塊；參數已經又改變的整批丟掉
+    void Accept(TileBatch& batch)
+    {
+        if (!(batch.state == current_.state))
+            return;
+        for (auto& kv : batch.tiles)
+            current_.tiles.insert_or_assign(kv.first, std::move(kv.second)).first->second.last_frame = frame_;
+        batch.tiles.clear();
+    }
+
+    // 背景執行緒：算出請求的每一塊；cancel 非空時每塊檢查一次，已過時就放棄並回傳 false
+    static bool BuildTiles(const OptionLegStore& legs, const TileRequest& req, TileBatch& out, const CancelToken* cancel)
+    {
+        out.state = req.state;
+        out.tiles.clear();
+        for (const Key& k : req.keys)
+        {
+            if (cancel && cancel->cancelled())
+                return false;
+            out.tiles.emplace_back(k, BuildTile(legs, req.state, k));
+        }
+        return true;
+    }
+
+    const CurveVector& Xs() const { return xs_; }
+    const CurveVector& YsCur() const { return ys_cur_; }
+    const CurveVector& YsExp() const { return ys_exp_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& k) const
+        {
+            return (std::size_t)((std::uint64_t)k.index * 1099511628211ull ^ (std::uint64_t)k.level);
+        }
+    };
+
+    struct TileSet
+    {
+        TileState state;
+        std::unordered_map<Key, Tile, KeyHash> tiles;
+    };
+
+    TileSet current_;             // 目前參數的塊
+    TileSet previous_;            // 上一組畫出來過的塊，新一組蓋滿前拿來畫
+    bool current_shown_ = false;
+    TileRequest request_;
+    std::uint64_t frame_ = 0;
+    Stats stats_;
+    CurveVector xs_, ys_cur_, ys_exp_;
+
+    static double TileWidth(const TileSet& set, int level) { return std::ldexp(set.state.base_width, -level); }
+
+    static int TargetLevel(const TileSet& set, double x_min, double x_max, float pixel_width)
+    {
+        const double wanted = (x_max - x_min) * kTileSamples / pixel_width;
+        return std::clamp((int)std::ceil(std::log2(set.state.base_width / wanted)), kMinLevel, kMaxLevel);
+    }
+
+    template <typename F>
+    static void ForEachIndex(const TileSet& set, int level, double x_min, double x_max, F&& f)
+    {
+        const double w = TileWidth(set, level);
+        const std::int64_t first = (std::int64_t)std::floor(x_min / w);
+        const std::int64_t last = (std::int64_t)std::floor(x_max / w);
+        for (std::int64_t i = first; i <= last; ++i)
+            f(i);
+    }
+
+    const Tile* Find(TileSet& set, int level, std::int64_t index)
+    {
+        const auto it = set.tiles.find(Key{ level, index });
+        if (it == set.tiles.end())
+            return nullptr;
+        it->second.last_frame = frame_;
+        return &it->second;
+    }
+
+    void AddRequest(int level, std::int64_t index)
+    {
+        if ((int)request_.keys.size() < kBatchTiles)
+            request_.keys.push_back(Key{ level, index });
+    }
+
+    // 每個目標層區段用最細的可用塊 (舊的一組可能是別的縮放層級算的，一路往粗找)，只取落在區段內的點
+    void Assemble(TileSet& set, double x_min, double x_max, float pixel_width)
+    {
+        const int target = TargetLevel(set, x_min, x_max, pixel_width);
+        const double w = TileWidth(set, target);
+        ForEachIndex(set, target, x_min, x_max, [&](std::int64_t idx) {
+            const Tile* t = nullptr;
+            for (int l = target; l >= kMinLevel && !t; --l)
+                t = Find(set, l, idx >> (target - l));
+            if (!t)
+                return;
+            const double seg0 = idx * w, seg1 = seg0 + w;
+            for (std::size_t j = 0; j < t->xs.size(); ++j)
+            {
+                const double x = t->xs[j];
+                if (x < seg0 || x >= seg1)
+                    continue;
+                xs_.push_back(x);
+                ys_cur_.push_back(t->ys_cur[j]);
+                ys_exp_.push_back(t->ys_exp[j]);
+            }
+        });
+    }
+
+    static Tile BuildTile(const OptionLegStore& legs, const TileState& state, const Key& key)
+    {
+        const double w = std::ldexp(state.base_width, -key.level);
+        const double x0 = key.index * w;
+        Tile t;
+        t.xs.reserve(kTileSamples + legs.size());
+        for (int j = 0; j < kTileSamples; ++j)
+            t.xs.push_back(x0 + w * j / kTileSamples);
+        for (std::size_t i = 0; i < legs.size(); ++i)
+            if (legs.strike[i] > x0 && legs.strike[i] < x0 + w)
+                t.xs.push_back(legs.strike[i]);
+        std::sort(t.xs.begin(), t.xs.end());
+        t.xs.erase(std::unique(t.xs.begin(), t.xs.end()), t.xs.end());
+
+        const int n = (int)t.xs.size();
+        t.ys_cur.resize(n);
+        t.ys_exp.resize(n);
+        price_curve_display(legs, t.xs.data(), n, t.ys_cur.data(), state.precision);
+        legs.payoff_curve(t.xs.data(), n, t.ys_exp.data());
+        for (int j = 0; j < n; ++j)
+        {
+            t.ys_cur[j] -= state.entry_cost;
+            t.ys_exp[j] -= state.entry_cost;
+        }
+        return t;
+    }
+
+    // 目前這組超過上限時丟掉最久沒用到的一半 (這一幀用到的不丟)
+    void Evict()
+    {
+        if (current_.tiles.size() <= kMaxTiles)
+            return;
+        std::vector<std::uint64_t> ages;
+        ages.reserve(current_.tiles.size());
+        for (const auto& kv : current_.tiles)
+            ages.push_back(kv.second.last_frame);
+        const std::size_t half = ages.size() / 2;
+        std::nth_element(ages.begin(), ages.begin() + half, ages.end());
+        const std::uint64_t cutoff = std::min(ages[half], frame_ - 1);
+        for (auto it = current_.tiles.begin(); it != current_.tiles.end();)
+            it = it->second.last_frame < cutoff ? current_.tiles.erase(it) : std::next(it);
+    }
+};
@@ -0,0 +1,170 @@
+// dashboard.h - 多標的儀表板：每個標的 / 策略一個 ImGui 視窗，共用一個 PricingService
+// 收合、關閉、拖出畫面或被其他視窗完全蓋住的面板不送定價請求；可見的面板依焦點 / 滑鼠停留決定排程優先權。
+// PricingService 的 worker 在第一次開啟儀表板時才建立。
+#pragma once
+
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "implot.h"
+#include "butterfly_app.h"
+#include "pricing_service.h"
+
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+struct DashboardPanel
+{
+    char name[32] = "";
+    int id = 0;                                   // 穩定的視窗 ID (刪除其他面板時不變)
+    Scenario sc = { 100.0, 20.0, 30.0, 4.0, 100.0, 5.0 };
+    bool open = true;
+    std::shared_ptr<const PricingResult> shown;   // 最後一份完成的結果 (新結果到之前繼續顯示)
+};
+
+struct Dashboard
+{
+    int n_points = 200;
+    std::vector<DashboardPanel> panels;
+    int next_panel_id = 0;
+    std::unique_ptr<PricingService> service;     // 第一次開啟儀表板時建立
+
+    Dashboard()
+    {
+        static const char* symbols[] = { "SPY", "QQQ", "IWM", "AAPL", "MSFT", "NVDA", "TSLA", "AMZN" };
+        for (int i = 0; i < IM_ARRAYSIZE(symbols); ++i)
+            AddPanel(symbols[i], 50.0 + 25.0 * i);
+    }
+
+    void AddPanel(const char* name, double spot)
+    {
+        DashboardPanel p;
+        snprintf(p.name, sizeof(p.name), "%s", name);
+        p.id = next_panel_id++;
+        p.sc.spot = spot;
+        p.sc.strike_atm = std::round(spot);
+        p.sc.width = std::max(1.0, std::round(spot * 0.05));
+        panels.push_back(p);
+    }
+};
+
+// 目前視窗中從游標起 size 大小的區域是否真的看得到：
+// 先裁到視窗 (捲動) 與主 viewport (拖出畫面)，再看是否被顯示順序在上面的視窗整個蓋住
+static bool DashboardRegionVisible(const ImVec2& size)
+{
+    ImGuiContext& g = *GImGui;
+    ImGuiWindow* window = g.CurrentWindow;
+    const ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImRect r(pos, ImVec2(pos.x + std::max(size.x, 1.0f), pos.y + std::max(size.y, 1.0f)));
+    r.ClipWith(window->ClipRect);
+    const ImGuiViewport* vp = ImGui::GetMainViewport();
+    r.ClipWith(ImRect(vp->Pos, ImVec2(vp->Pos.x + vp->Size.x, vp->Pos.y + vp->Size.y)));
+    if (r.GetWidth() <= 0.0f || r.GetHeight() <= 0.0f)
+        return false;
+
+    // g.Windows 依顯示順序排列 (後面的在上層)
+    bool above = false;
+    for (ImGuiWindow* w : g.Windows)
+    {
+        if (w == window->RootWindow)
+        {
+            above = true;
+            continue;
+        }
+        if (!above || !w->WasActive || w->Hidden || (w->Flags & ImGuiWindowFlags_ChildWindow))
+            continue;
+        if (w->Rect().Contains(r))
+            return false;
+    }
+    return true;
+}
+
+static void DrawDashboardPanel(Dashboard& dash, DashboardPanel& p)
+{
+    char title[64];
+    snprintf(title, sizeof(title), "%s##Dashboard%d", p.name, p.id);
+    const int index = p.id;
+    ImGui::SetNextWindowSize(ImVec2(420, 320), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos(ImVec2(620.0f + 30.0f * (index % 10), 60.0f + 30.0f * (index % 10)), ImGuiCond_FirstUseEver);
+
+    // Begin 回傳 false = 收合或被裁切：不請求、不計算
+    if (!ImGui::Begin(title, &p.open) || ImGui::GetCurrentWindow()->Hidden)
+    {
+        ImGui::End();
+        return;
+    }
+
+    InputDouble("現價", &p.sc.spot, 1.0, 5.0, "%.2f");
+    if (p.sc.spot < 0.01) p.sc.spot = 0.01;
+    SliderDouble("IV %", &p.sc.iv_pct, 1.0, 150.0, "%.0f");
+    SliderDouble("天數", &p.sc.days, 0.0, 90.0, "%.0f");
+    InputDouble("ATM", &p.sc.strike_atm, 1.0, 5.0, "%.2f");
+    InputDouble("間距", &p.sc.width, 0.5, 1.0, "%.2f");
+    p.sc.days = std::round(p.sc.days);
+
+    int priority = PricingPriority_Visible;
+    if (ImGui::IsWindowHovered()) priority = PricingPriority_Hovered;
+    if (ImGui::IsWindowFocused()) priority = PricingPriority_Focused;
+
+    // 曲線區看不到就不請求 (worker 會丟掉沒人要的排隊工作)，沿用上次的結果
+    std::shared_ptr<const PricingResult> res;
+    if (DashboardRegionVisible(ImGui::GetContentRegionAvail()))
+        res = dash.service->Request(p.sc, dash.n_points, priority);
+    if (res)
+        p.shown = res;
+
+    if (p.shown)
+    {
+        const PricingResult& r = *p.shown;
+        ImGui::Text("成本: $%.2f%s", r.entry_cost, res ? "" : " (計算中...)");
+        if (ImPlot::BeginPlot("##DashPlot", ImVec2(-1, -1), ImPlotFlags_NoLegend))
+        {
+            MemTagScope implot_scope(MemTag_ImPlot);
+            ImPlot::SetupAxes(nullptr, nullptr);
+            ImPlot::SetupAxisLimits(ImAxis_X1, r.xs.front(), r.xs.back(), ImGuiCond_Always);
+            ImPlot::SetNextLineStyle(ImVec4(0.9f, 0.2f, 0.2f, 1.0f), 1.5f);
+            ImPlot::PlotLine("到期", r.xs.data(), r.ys_exp.data(), (int)r.xs.size());
+            ImPlot::SetNextLineStyle(ImVec4(0.2f, 0.4f, 0.9f, 1.0f), 2.0f);
+            ImPlot::PlotLine("T+0", r.xs.data(), r.ys_cur.data(), (int)r.xs.size());
+            ImPlot::EndPlot();
+        }
+    }
+    else
+    {
+        ImGui::TextDisabled("計算中...");
+    }
+    ImGui::End();
+}
+
+// enabled 對應側欄的「儀表板模式」勾選框；從沒開過就不建立 worker，關閉時 worker 只是睡著
+static void DrawDashboard(Dashboard& dash, bool* enabled)
+{
+    if (!*enabled)
+        return;
+    if (!dash.service)
+        dash.service = std::make_unique<PricingService>((int)std::max(1u, std::thread::hardware_concurrency() / 2));
+    dash.service->BeginFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(620, 20), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("儀表板控制", enabled, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        static char new_name[32] = "NEW";
+        ImGui::SetNextItemWidth(120.0f);
+        ImGui::InputText("##NewSymbol", new_name, IM_ARRAYSIZE(new_name));
+        ImGui::SameLine();
+        if (ImGui::Button("新增標的"))
+            dash.AddPanel(new_name, 100.0);
+
+        const PricingService::Stats st = dash.service->GetStats();
+        ImGui::Text("面板: %d  快取: %zu  排隊: %zu", (int)dash.panels.size(), st.entries, st.queued);
+        ImGui::Text("請求: %llu  去重命中: %llu  實際定價: %llu",
+            (unsigned long long)st.requests, (unsigned long long)st.dedup_hits, (unsigned long long)st.computed);
+    }
+    ImGui::End();
+
+    for (int i = 0; i < (int)dash.panels.size(); ++i)
+        DrawDashboardPanel(dash, dash.panels[i]);
+
+    dash.panels.erase(std::remove_if(dash.panels.begin(), dash.panels.end(),
+        [](const DashboardPanel& p) { return !p.open; }), dash.panels.end());
+}
@@ -0,0 +1,333 @@
+// fast_startup.h - 快速啟動：延後子系統初始化、背景載入字型、記住 GPU 裝置選擇、啟動階段計時
+//
+// 原本的啟動是一條直線：SDL_Init(VIDEO | GAMEPAD) -> 建視窗 -> 建 GPU 裝置 -> LoadChineseFont
+// (整個中文字集點陣化) -> backend init。--fast-startup 時改成：
+//   - 字型在 main 一開始就丟給背景執行緒 (AsyncFontLoader)，和建視窗 / 建裝置同時進行
+//   - 第一幀先用 ImGui 內建字型畫出來，字型好了再換上 (中文字在那之前顯示成 ?)
+//   - 手把子系統在第一幀上屏後才初始化 (列舉 HID 裝置在某些平台要上百 ms)
+//   - SDL_GPU：記住上次成功的 driver，下次直接指定，省掉逐一探測各 backend
+// 兩種模式都會在字型就緒後印出各階段耗時 (StartupTimer)，方便對照。
+#pragma once
+
+#include "imgui.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// ----------------------------- 階段計時 -----------------------------
+class StartupTimer
+{
+public:
+    StartupTimer() : start_(std::chrono::steady_clock::now()), last_(start_) {}
+
+    // 記錄「上一個標記到現在」為一個階段；name 需為字串常值
+    void Mark(const char* name)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (count_ < kMaxPhases)
+        {
+            phases_[count_].name = name;
+            phases_[count_].ms = std::chrono::duration<double, std::milli>(now - last_).count();
+            phases_[count_].at_ms = std::chrono::duration<double, std::milli>(now - start_).count();
+            ++count_;
+        }
+        last_ = now;
+    }
+
+    // 背景執行緒的耗時 (不在主執行緒的時間軸上)，只列出不累加
+    void Note(const char* name, double ms)
+    {
+        if (count_ < kMaxPhases)
+            phases_[count_++] = { name, ms, -1.0 };
+    }
+
+    void Report(const char* mode) const
+    {
+        printf("Startup (%s):\n", mode);
+        for (int i = 0; i < count_; ++i)
+        {
+            if (phases_[i].at_ms < 0.0)
+                printf("  %-16s %8.1f ms  (background)\n", phases_[i].name, phases_[i].ms);
+            else
+                printf("  %-16s %8.1f ms  @ %8.1f ms\n", phases_[i].name, phases_[i].ms, phases_[i].at_ms);
+        }
+    }
+
+private:
+    static constexpr int kMaxPhases = 16;
+    struct Phase
+    {
+        const char* name;
+        double ms;
+        double at_ms;   // 從 main 開始算；< 0 表示背景執行緒
+    };
+    std::chrono::steady_clock::time_point start_, last_;
+    Phase phases_[kMaxPhases] = {};
+    int count_ = 0;
+};
+
+// ----------------------------- 背景字型 -----------------------------
+// 候選中文字型 (與各 demo 的 LoadChineseFont 相同順序)
+static const char* const kChineseFontPaths[] = {
+    "msyh.ttc",
+    "c:\\Windows\\Fonts\\msyh.ttc",
+    "c:\\Windows\\Fonts\\simhei.ttf",
+    "/System/Library/Fonts/PingFang.ttc",
+    "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc"
+};
+
+// 背景執行緒讀檔並建好 atlas，主執行緒在兩幀之間 Install。
+//   - IMGUI_VERSION_NUM < 19200：在背景建一份完整的 ImFontAtlas (點陣化整個中文字集 + 轉 RGBA32)，
+//     Install 時直接換掉 io.Fonts；呼叫端要在前後銷毀 / 重建 backend 的字型貼圖
+//   - 1.92 起 atlas 是動態的 (用到的字才點陣化)，背景只負責讀檔，Install 時從記憶體加入字型
+// 背景建 atlas 時 ImGui context 可能已存在，共用的只有 MemAlloc 的 debug 配置計數。
+class AsyncFontLoader
+{
+public:
+    AsyncFontLoader() = default;
+    AsyncFontLoader(const AsyncFontLoader&) = delete;
+    AsyncFontLoader& operator=(const AsyncFontLoader&) = delete;
+
+    ~AsyncFontLoader()
+    {
+        if (worker_.joinable())
+            worker_.join();
+#if IMGUI_VERSION_NUM < 19200
+        if (atlas_)
+            IM_DELETE(atlas_);
+#else
+        if (data_)
+            IM_FREE(data_);
+#endif
+    }
+
+    void Start(float size_px)
+    {
+        size_px_ = size_px;
+        worker_ = std::thread([this] { WorkerMain(); });
+    }
+
+    // 背景工作已結束 (成功或找不到字型) 且尚未 Install
+    bool Ready() const { return ready_.load(std::memory_order_acquire) && !installed_; }
+
+    // 換上中文字型；只能在兩幀之間呼叫 (NewFrame 之前)。找不到字型時保留內建字型並回傳 false
+    bool Install(ImGuiIO& io)
+    {
+        worker_.join();
+        installed_ = true;
+        if (!path_)
+        {
+            printf("Warning: No Chinese font found.\n");
+            return false;
+        }
+#if IMGUI_VERSION_NUM < 19200
+        // context 擁有 io.Fonts，結束時會 IM_DELETE 新的這份；舊的由這裡釋放
+        ImFontAtlas* old = io.Fonts;
+        io.Fonts = atlas_;
+        atlas_ = nullptr;
+        IM_DELETE(old);
+#else
+        io.FontDefault = io.Fonts->AddFontFromMemoryTTF(data_, data_size_, size_px_, nullptr, io.Fonts->GetGlyphRangesChineseFull());
+        data_ = nullptr;   // 交給 atlas 釋放
+#endif
+        printf("Loaded font: %s (background, %.1f ms)\n", path_, load_ms_);
+        return true;
+    }
+
+    double LoadMs() const { return load_ms_; }
+
+private:
+    void WorkerMain()
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (const char* path : kChineseFontPaths)
+        {
+            FILE* f = fopen(path, "rb");
+            if (!f)
+                continue;
+            fseek(f, 0, SEEK_END);
+            const long size = ftell(f);
+            fseek(f, 0, SEEK_SET);
+            void* data = size > 0 ? IM_ALLOC((size_t)size) : nullptr;
+            const bool ok = data && fread(data, 1, (size_t)size, f) == (size_t)size;
+            fclose(f);
+            if (!ok)
+            {
+                if (data)
+                    IM_FREE(data);
+                continue;
+            }
+#if IMGUI_VERSION_NUM < 19200
+            atlas_ = IM_NEW(ImFontAtlas)();
+            atlas_->AddFontFromMemoryTTF(data, (int)size, size_px_, nullptr, atlas_->GetGlyphRangesChineseFull());
+            // backend 建貼圖時用 RGBA32；在這裡先轉好，主執行緒只剩上傳
+            unsigned char* pixels = nullptr;
+            int w = 0, h = 0;
+            atlas_->GetTexDataAsRGBA32(&pixels, &w, &h);
+#else
+            data_ = data;
+            data_size_ = (int)size;
+#endif
+            path_ = path;
+            break;
+        }
+        load_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        ready_.store(true, std::memory_order_release);
+    }
+
+    std::thread worker_;
+    std::atomic<bool> ready_{ false };
+    bool installed_ = false;
+    float size_px_ = 22.0f;
+    const char* path_ = nullptr;
+    double load_ms_ = 0.0;
+#if IMGUI_VERSION_NUM < 19200
+    ImFontAtlas* atlas_ = nullptr;
+#else
+    void* data_ = nullptr;
+    int data_size_ = 0;
+#endif
+};
+
+// ----------------------------- 延後的手把初始化 -----------------------------
+// 第一幀上屏後才開手把子系統；已連接的手把會送出 SDL_EVENT_GAMEPAD_ADDED，
+// imgui_impl_sdl3 收到後自己重新列舉，不需要其他處理。
+static bool InitGamepadDeferred(StartupTimer& timer)
+{
+    if (SDL_WasInit(SDL_INIT_GAMEPAD))
+        return true;
+    const bool ok = SDL_InitSubSystem(SDL_INIT_GAMEPAD);
+    if (!ok)
+        printf("Warning: SDL_InitSubSystem(GAMEPAD): %s\n", SDL_GetError());
+    timer.Mark("gamepad init");
+    return ok;
+}
+
+// ----------------------------- SDL_GPU 裝置快取 -----------------------------
+// SDL_CreateGPUDevice(name = NULL) 會逐一探測 Vulkan / D3D12 / Metal (各建一次暫時的 instance)。
+// 把上次成功的 driver 名稱寫在小檔案裡，下次直接指定；指定的 driver 失敗就退回自動探測並更新快取。
+// SDL3 沒有公開 pipeline cache；ImGui 的 shader 是內嵌的 bytecode，pipeline 編譯結果由驅動程式自己的
+// 磁碟快取保存，這裡能省的是探測與 instance 建立。
+static SDL_GPUDevice* CreateGpuDeviceCached(const char* cache_path, SDL_GPUShaderFormat formats, bool debug_mode)
+{
+    char cached[32] = {};
+    if (FILE* f = fopen(cache_path, "r"))
+    {
+        if (!fgets(cached, sizeof(cached), f))
+            cached[0] = 0;
+        fclose(f);
+        cached[strcspn(cached, "\r\n")] = 0;
+    }
+
+    SDL_GPUDevice* device = nullptr;
+    if (cached[0])
+    {
+        SDL_PropertiesID props = SDL_CreateProperties();
+        SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_DEBUGMODE_BOOLEAN, debug_mode);
+        SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_SHADERS_SPIRV_BOOLEAN, (formats & SDL_GPU_SHADERFORMAT_SPIRV) != 0);
+        SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_SHADERS_DXIL_BOOLEAN, (formats & SDL_GPU_SHADERFORMAT_DXIL) != 0);
+        SDL_SetBooleanProperty(props, SDL_PROP_GPU_DEVICE_CREATE_SHADERS_METALLIB_BOOLEAN, (formats & SDL_GPU_SHADERFORMAT_METALLIB) != 0);
+        SDL_SetStringProperty(props, SDL_PROP_GPU_DEVICE_CREATE_NAME_STRING, cached);
+        device = SDL_CreateGPUDeviceWithProperties(props);
+        SDL_DestroyProperties(props);
+        if (!device)
+            printf("Warning: cached GPU driver '%s' failed (%s), probing.\n", cached, SDL_GetError());
+    }
+    if (!device)
+        device = SDL_CreateGPUDevice(formats, debug_mode, nullptr);
+    if (!device)
+        return nullptr;
+
+    const char* driver = SDL_GetGPUDeviceDriver(device);
+    if (driver && strcmp(driver, cached) != 0)
+    {
+        if (FILE* f = fopen(cache_path, "w"))
+        {
+            fprintf(f, "%s\n", driver);
+            fclose(f);
+        }
+    }
+    return device;
+}
+
+// ----------------------------- 啟動流程 -----------------------------
+// 各 demo 的 main 共用：解析 --fast-startup、決定 SDL_Init 旗標、處理字型與第一幀之後的工作。
+class StartupSequence
+{
+public:
+    StartupSequence(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; ++i)
+            if (strcmp(argv[i], "--fast-startup") == 0)
+                fast_ = true;
+        if (fast_)
+            font_.Start(22.0f);
+    }
+
+    bool Fast() const { return fast_; }
+    void Mark(const char* name) { timer_.Mark(name); }
+
+    SDL_InitFlags InitFlags() const { return fast_ ? SDL_INIT_VIDEO : (SDL_INIT_VIDEO | SDL_INIT_GAMEPAD); }
+
+    // backend init 之前呼叫：一般模式同步載入；快速模式背景已完成就直接用，否則先放內建字型
+    void LoadFonts(ImGuiIO& io, void (*load_sync)(ImGuiIO&))
+    {
+        if (!fast_)
+            load_sync(io);
+        else if (font_.Ready())
+            font_.Install(io);
+        else
+        {
+            io.Fonts->AddFontDefault();
+            font_pending_ = true;
+        }
+        timer_.Mark("font");
+    }
+
+    // 第一幀之後背景字型好了：呼叫端在 InstallFont 前後重建 backend 字型貼圖 (1.92 之前)
+    bool FontReady() const { return font_pending_ && font_.Ready(); }
+
+    void InstallFont(ImGuiIO& io)
+    {
+        font_.Install(io);
+        font_pending_ = false;
+        timer_.Mark("font swap");
+        MaybeReport();
+    }
+
+    // 每幀 present 之後呼叫
+    void OnFramePresented()
+    {
+        if (first_frame_)
+            return;
+        first_frame_ = true;
+        timer_.Mark("first frame");
+        if (fast_)
+            InitGamepadDeferred(timer_);
+        MaybeReport();
+    }
+
+private:
+    void MaybeReport()
+    {
+        if (reported_ || !first_frame_ || font_pending_)
+            return;
+        reported_ = true;
+        if (fast_)
+            timer_.Note("font load", font_.LoadMs());
+        timer_.Report(fast_ ? "fast" : "serial");
+    }
+
+    StartupTimer timer_;
+    AsyncFontLoader font_;
+    bool fast_ = false;
+    bool font_pending_ = false;
+    bool first_frame_ = false;
+    bool reported_ = false;
+};
@@ -0,0 +1,353 @@
+// frame_pacer.h - 依互動狀態 / 電源 / 實測幀時間決定 present 模式與目標幀率
+//
+// 三種狀態：
+//   Interactive : 滑鼠 / 手把按住或 0.5 秒內有輸入 -> 最低延遲 (MAILBOX，不支援時 IMMEDIATE)，
+//                 目標 2x 螢幕更新率；用電池時維持 VSYNC
+//   Active      : 2 秒內有輸入或動畫播放中 -> VSYNC，螢幕更新率 (做不完時退到整數分頻，保持穩定節奏)
+//   Idle        : 其他 -> VSYNC，低而穩定的幀率 (預設 10 Hz，電池 4 Hz)，有事件立即喚醒
+//
+// Late-latch：在 poll event 之前先睡到「下一個 present 時間點 - 預估工作時間」，
+// 讓這一幀讀到的輸入盡量新。backend 相關的套用方式在檔案最後 (SDL_GPU / OpenGL / SDL_Renderer)。
+#pragma once
+
+#include "imgui.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+enum PresentPolicy
+{
+    PresentPolicy_Vsync = 0,
+    PresentPolicy_Mailbox,
+    PresentPolicy_Immediate,
+    PresentPolicy_COUNT
+};
+
+enum PacingState
+{
+    PacingState_Interactive = 0,
+    PacingState_Active,
+    PacingState_Idle,
+    PacingState_COUNT
+};
+
+static const char* PresentPolicyName(PresentPolicy p)
+{
+    static const char* names[PresentPolicy_COUNT] = { "VSYNC", "MAILBOX", "IMMEDIATE" };
+    return names[p];
+}
+
+class FramePacer
+{
+public:
+    // 可調參數 (面板可改)
+    int override_policy = -1;            // -1 = 自動
+    float idle_hz = 10.0f;
+    float battery_idle_hz = 4.0f;
+    bool late_latch = true;
+
+    // supported_mask：bit (1 << PresentPolicy_X) 表示 backend 支援該模式；VSYNC 一定支援
+    FramePacer(SDL_Window* window, unsigned supported_mask)
+        : window_(window), supported_mask_(supported_mask | (1u << PresentPolicy_Vsync))
+    {
+        RefreshDisplayRate();
+        on_battery_ = QueryOnBattery();
+        const Uint64 now = SDL_GetTicksNS();
+        last_input_ns_ = now;
+        last_power_poll_ns_ = now;
+        frame_start_ns_ = now;
+        last_present_ns_ = now;
+        Update(now);
+    }
+
+    void OnEvent(const SDL_Event& event)
+    {
+        switch (event.type)
+        {
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            buttons_held_ |= 1u << event.button.button;
+            last_input_ns_ = SDL_GetTicksNS();
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            buttons_held_ &= ~(1u << event.button.button);
+            last_input_ns_ = SDL_GetTicksNS();
+            break;
+        case SDL_EVENT_FINGER_DOWN:
+        case SDL_EVENT_FINGER_UP:
+        case SDL_EVENT_MOUSE_MOTION:
+        case SDL_EVENT_MOUSE_WHEEL:
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+        case SDL_EVENT_TEXT_EDITING:
+        case SDL_EVENT_TEXT_INPUT:
+        case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+            last_input_ns_ = SDL_GetTicksNS();
+            break;
+        case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+            gamepad_buttons_held_ |= 1u << (event.gbutton.button & 31);
+            last_input_ns_ = SDL_GetTicksNS();
+            break;
+        case SDL_EVENT_GAMEPAD_BUTTON_UP:
+            gamepad_buttons_held_ &= ~(1u << (event.gbutton.button & 31));
+            last_input_ns_ = SDL_GetTicksNS();
+            break;
+        case SDL_EVENT_WINDOW_DISPLAY_CHANGED:
+            RefreshDisplayRate();
+            break;
+        case SDL_EVENT_WINDOW_FOCUS_LOST:
+            buttons_held_ = 0;   // 拖曳到視窗外放開時收不到 button up
+            gamepad_buttons_held_ = 0;
+            break;
+        }
+    }
+
+    // 有持續變化的內容 (動畫、背景計算) 時，每幀呼叫
+    void SetAnimating(bool animating) { animating_ = animating; }
+
+    // 迴圈開頭、poll event 之前呼叫：睡到 late-latch 時間點 (Idle 時有事件就提早醒來)
+    void WaitForNextFrame()
+    {
+        if (target_hz_ > 0.0)
+        {
+            const Uint64 period_ns = (Uint64)(1e9 / target_hz_);
+            const Uint64 margin_ns = 1000000;   // 1 ms 給排程誤差
+            Uint64 budget_ns = margin_ns;
+            if (late_latch)
+                budget_ns += (Uint64)(work_ms_ema_ * 1e6);
+            const Uint64 deadline = last_present_ns_ + period_ns;
+            const Uint64 wake = deadline > budget_ns ? deadline - budget_ns : 0;
+
+            Uint64 now = SDL_GetTicksNS();
+            if (state_ == PacingState_Idle)
+            {
+                // 閒置時可被輸入喚醒，回應不用等到下一個 tick
+                while (now + 2000000 < wake)
+                {
+                    if (SDL_WaitEventTimeout(nullptr, (Sint32)((wake - now) / 1000000)))
+                        break;
+                    now = SDL_GetTicksNS();
+                }
+            }
+            else if (now < wake)
+            {
+                SDL_DelayPrecise(wake - now);
+            }
+        }
+        frame_start_ns_ = SDL_GetTicksNS();
+    }
+
+    // 送出繪圖指令後 (Swap / Present 之前) 呼叫
+    void MarkSubmitted()
+    {
+        const double work_ms = (SDL_GetTicksNS() - frame_start_ns_) / 1e6;
+        work_ms_ema_ += 0.1 * (work_ms - work_ms_ema_);
+    }
+
+    // Swap / Present 回傳後呼叫
+    void EndFrame()
+    {
+        const Uint64 now = SDL_GetTicksNS();
+        frame_ms_ema_ += 0.1 * ((now - last_present_ns_) / 1e6 - frame_ms_ema_);
+        last_present_ns_ = now;
+
+        if (now - last_power_poll_ns_ > 5000000000ull)   // SDL_GetPowerInfo 不便宜，5 秒查一次
+        {
+            on_battery_ = QueryOnBattery();
+            last_power_poll_ns_ = now;
+        }
+        Update(now);
+    }
+
+    // 模式改變時回傳 true (backend 需要重新設定 swapchain / swap interval)
+    bool ConsumePolicyChange(PresentPolicy* out)
+    {
+        if (policy_ == applied_policy_)
+            return false;
+        applied_policy_ = policy_;
+        *out = policy_;
+        return true;
+    }
+
+    // backend 套用失敗時回報，之後不再選這個模式
+    void MarkUnsupported(PresentPolicy p)
+    {
+        if (p == PresentPolicy_Vsync)
+            return;
+        supported_mask_ &= ~(1u << p);
+        Update(SDL_GetTicksNS());
+    }
+
+    bool Supports(PresentPolicy p) const { return (supported_mask_ >> p) & 1u; }
+    PresentPolicy Policy() const { return policy_; }
+    PacingState State() const { return state_; }
+    double TargetHz() const { return target_hz_; }
+    double DisplayHz() const { return display_hz_; }
+    double FrameMsEma() const { return frame_ms_ema_; }
+    double WorkMsEma() const { return work_ms_ema_; }
+    bool OnBattery() const { return on_battery_; }
+
+private:
+    SDL_Window* window_;
+    unsigned supported_mask_;
+    unsigned buttons_held_ = 0;
+    unsigned gamepad_buttons_held_ = 0;   // 手把按鍵與滑鼠按鍵一樣，按住期間維持 Interactive
+    bool animating_ = false;
+    bool on_battery_ = false;
+    double display_hz_ = 60.0;
+    double target_hz_ = 60.0;            // 0 = 不限制
+    double work_ms_ema_ = 0.0;           // 事件處理 + UI 建構 + 送出
+    double frame_ms_ema_ = 16.7;         // 相鄰兩次 present 的間隔
+    Uint64 last_input_ns_ = 0;
+    Uint64 last_power_poll_ns_ = 0;
+    Uint64 frame_start_ns_ = 0;
+    Uint64 last_present_ns_ = 0;
+    PacingState state_ = PacingState_Active;
+    PresentPolicy policy_ = PresentPolicy_Vsync;
+    PresentPolicy applied_policy_ = PresentPolicy_Vsync;   // 各 backend 起始都是 vsync
+
+    static bool QueryOnBattery()
+    {
+        return SDL_GetPowerInfo(nullptr, nullptr) == SDL_POWERSTATE_ON_BATTERY;
+    }
+
+    void RefreshDisplayRate()
+    {
+        const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window_));
+        display_hz_ = (mode && mode->refresh_rate > 0.0f) ? mode->refresh_rate : 60.0;
+    }
+
+    void Update(Uint64 now)
+    {
+        const double since_input_ms = (now - last_input_ns_) / 1e6;
+        if (buttons_held_ != 0 || gamepad_buttons_held_ != 0 || since_input_ms < 500.0)
+            state_ = PacingState_Interactive;
+        else if (animating_ || since_input_ms < 2000.0)
+            state_ = PacingState_Active;
+        else
+            state_ = PacingState_Idle;
+
+        PresentPolicy policy = PresentPolicy_Vsync;
+        double hz = display_hz_;
+        switch (state_)
+        {
+        case PacingState_Interactive:
+            if (!on_battery_)
+            {
+                if (Supports(PresentPolicy_Mailbox))
+                    policy = PresentPolicy_Mailbox;
+                else if (Supports(PresentPolicy_Immediate))
+                    policy = PresentPolicy_Immediate;
+            }
+            if (policy != PresentPolicy_Vsync)
+                hz = display_hz_ * 2.0;
+            break;
+        case PacingState_Active:
+            break;
+        case PacingState_Idle:
+            hz = on_battery_ ? battery_idle_hz : idle_hz;
+            break;
+        default:
+            break;
+        }
+
+        if (override_policy >= 0 && Supports((PresentPolicy)override_policy))
+            policy = (PresentPolicy)override_policy;
+
+        // VSYNC 下做不完一個 refresh 週期：用整數分頻 (60 -> 30 -> 20) 保持穩定節奏
+        if (policy == PresentPolicy_Vsync && hz >= display_hz_)
+        {
+            const double period_ms = 1000.0 / display_hz_;
+            const double divisor = std::max(1.0, std::ceil(work_ms_ema_ / period_ms - 0.1));
+            hz = display_hz_ / divisor;
+        }
+
+        policy_ = policy;
+        target_hz_ = hz;
+    }
+};
+
+// ----------------------------- Backend 套用 -----------------------------
+static SDL_GPUPresentMode ToGpuPresentMode(PresentPolicy p)
+{
+    switch (p)
+    {
+    case PresentPolicy_Mailbox: return SDL_GPU_PRESENTMODE_MAILBOX;
+    case PresentPolicy_Immediate: return SDL_GPU_PRESENTMODE_IMMEDIATE;
+    default: return SDL_GPU_PRESENTMODE_VSYNC;
+    }
+}
+
+static unsigned QueryGpuPresentSupport(SDL_GPUDevice* device, SDL_Window* window)
+{
+    unsigned mask = 0;
+    for (int p = 0; p < PresentPolicy_COUNT; ++p)
+        if (SDL_WindowSupportsGPUPresentMode(device, window, ToGpuPresentMode((PresentPolicy)p)))
+            mask |= 1u << p;
+    return mask;
+}
+
+static bool ApplyGpuPresentPolicy(SDL_GPUDevice* device, SDL_Window* window, PresentPolicy p)
+{
+    if (!SDL_SetGPUSwapchainParameters(device, window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, ToGpuPresentMode(p)))
+    {
+        printf("Error: SDL_SetGPUSwapchainParameters(%s): %s\n", PresentPolicyName(p), SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// OpenGL 沒有 mailbox；swap interval 只有 vsync / immediate (-1 adaptive 仍會撕裂，不視為 mailbox)
+static bool ApplyGLPresentPolicy(PresentPolicy p)
+{
+    if (!SDL_GL_SetSwapInterval(p == PresentPolicy_Immediate ? 0 : 1))
+    {
+        printf("Error: SDL_GL_SetSwapInterval(%s): %s\n", PresentPolicyName(p), SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+static bool ApplyRendererPresentPolicy(SDL_Renderer* renderer, PresentPolicy p)
+{
+    if (!SDL_SetRenderVSync(renderer, p == PresentPolicy_Immediate ? SDL_RENDERER_VSYNC_DISABLED : 1))
+    {
+        printf("Error: SDL_SetRenderVSync(%s): %s\n", PresentPolicyName(p), SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------- UI -----------------------------
+static void DrawFramePacerPanel(FramePacer& pacer, bool* open)
+{
+    if (!*open)
+        return;
+    ImGui::SetNextWindowSize(ImVec2(420, 0), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("畫面節奏", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    static const char* state_names[PacingState_COUNT] = { "互動中", "活躍", "閒置" };
+    ImGui::Text("狀態: %s%s", state_names[pacer.State()], pacer.OnBattery() ? " (電池)" : "");
+    ImGui::Text("Present: %s  目標: %.1f Hz  螢幕: %.0f Hz",
+        PresentPolicyName(pacer.Policy()), pacer.TargetHz(), pacer.DisplayHz());
+    ImGui::Text("幀間隔: %.2f ms  工作: %.2f ms", pacer.FrameMsEma(), pacer.WorkMsEma());
+
+    const char* items[] = { "自動", "VSYNC", "MAILBOX", "IMMEDIATE" };
+    int sel = pacer.override_policy + 1;
+    if (ImGui::Combo("模式", &sel, items, IM_ARRAYSIZE(items)))
+        pacer.override_policy = sel - 1;
+    if (pacer.override_policy >= 0 && !pacer.Supports((PresentPolicy)pacer.override_policy))
+        ImGui::TextColored(ImVec4(0.8f, 0.2f, 0.2f, 1), "此 backend 不支援 %s", PresentPolicyName((PresentPolicy)pacer.override_policy));
+    ImGui::SliderFloat("閒置 Hz", &pacer.idle_hz, 1.0f, 30.0f, "%.0f");
+    ImGui::SliderFloat("電池閒置 Hz", &pacer.battery_idle_hz, 1.0f, 30.0f, "%.0f");
+    ImGui::Checkbox("Late-latch 輸入", &pacer.late_latch);
+    ImGui::End();
+}
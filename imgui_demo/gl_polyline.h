@@ -0,0 +1,424 @@
+// gl_polyline.h - OpenGL3 的 GpuPolylineBackend：instanced 粗線 / 填色
+//
+// 每份資料 (series) 一個 VBO，存 (x - x0, y - y0) 的 float2 (先減掉第一點避免 float 失準)；
+// 同一份資料的線與填色共用同一個 VBO，只上傳一次。
+// 畫的時候每一段 (i, i+1) 是一個 instance：同一個 VBO 綁兩次 (位移 0 / 8 bytes，divisor 1)，
+// 4 個頂點的 triangle strip 在 vertex shader 裡依 gl_VertexID 展開成：
+//   Line : 沿法向量加寬 thickness (+1 px 反鋸齒邊)
+//   Fill : 從曲線到 fill_ref 的四邊形
+// 透過 ImDrawList callback 在 ImPlot 的 plot draw list 中插入，之後接 ImDrawCallback_ResetRenderState
+// 讓 imgui_impl_opengl3 恢復自己的狀態。需要 GL 3.0 + instancing (GL 3.3 或 ARB_instanced_arrays)，
+// 不支援時 Init() 回傳 false，PolylineRenderer 自動退回 CPU 抽樣。
+#pragma once
+
+#include "polyline_renderer.h"
+
+#include <SDL3/SDL.h>
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+#include <SDL3/SDL_opengles2.h>
+#else
+#include <SDL3/SDL_opengl.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#ifndef APIENTRY
+#define APIENTRY GL_APIENTRY
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER 0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_TRIANGLE_STRIP
+#define GL_TRIANGLE_STRIP 0x0005
+#endif
+#ifndef GL_FLOAT
+#define GL_FLOAT 0x1406
+#endif
+
+class GLPolylineBackend : public GpuPolylineBackend
+{
+public:
+    // 在 GL context current 的狀態下呼叫 (ImGui_ImplOpenGL3_Init 之後)
+    bool Init(const char* glsl_version)
+    {
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+        (void)glsl_version;
+        printf("GPU polyline: OpenGL ES 2 has no instancing, using CPU decimation.\n");
+        return false;
+#else
+        if (!LoadFunctions())
+        {
+            printf("GPU polyline: instanced drawing not available, using CPU decimation.\n");
+            return false;
+        }
+
+        static const char* vs_body =
+            "in vec2 a_p0;\n"
+            "in vec2 a_p1;\n"
+            "uniform vec4 u_data_rect;\n"    // x_min, y_min, x_max, y_max (已減 x0 / y0)
+            "uniform vec4 u_pixel_rect;\n"   // left, top, width, height (framebuffer px，y 向下)
+            "uniform vec2 u_fb_size;\n"
+            "uniform float u_thickness;\n"
+            "uniform float u_fill_ref;\n"
+            "uniform int u_mode;\n"
+            "out float v_edge;\n"
+            "vec2 ToPixel(vec2 p)\n"
+            "{\n"
+            "    vec2 t = (p - u_data_rect.xy) / (u_data_rect.zw - u_data_rect.xy);\n"
+            "    return vec2(u_pixel_rect.x + t.x * u_pixel_rect.z, u_pixel_rect.y + (1.0 - t.y) * u_pixel_rect.w);\n"
+            "}\n"
+            "void main()\n"
+            "{\n"
+            "    int v = gl_VertexID;\n"
+            "    vec2 px;\n"
+            "    if (u_mode == 0)\n"
+            "    {\n"
+            "        vec2 s0 = ToPixel(a_p0);\n"
+            "        vec2 s1 = ToPixel(a_p1);\n"
+            "        vec2 d = s1 - s0;\n"
+            "        float len = length(d);\n"
+            "        vec2 dir = len > 1e-4 ? d / len : vec2(1.0, 0.0);\n"
+            "        vec2 nrm = vec2(-dir.y, dir.x);\n"
+            "        float half_w = 0.5 * u_thickness + 1.0;\n"
+            "        float side = (v == 0 || v == 2) ? 1.0 : -1.0;\n"
+            "        vec2 base = v < 2 ? s0 - dir * 0.5 * u_thickness : s1 + dir * 0.5 * u_thickness;\n"
+            "        px = base + nrm * side * half_w;\n"
+            "        v_edge = side * half_w;\n"
+            "    }\n"
+            "    else\n"
+            "    {\n"
+            "        vec2 p = v < 2 ? a_p0 : a_p1;\n"
+            "        px = ToPixel(vec2(p.x, (v == 0 || v == 2) ? p.y : u_fill_ref));\n"
+            "        v_edge = 0.0;\n"
+            "    }\n"
+            "    gl_Position = vec4(px.x / u_fb_size.x * 2.0 - 1.0, 1.0 - px.y / u_fb_size.y * 2.0, 0.0, 1.0);\n"
+            "}\n";
+        static const char* fs_body =
+            "in float v_edge;\n"
+            "uniform vec4 u_color;\n"
+            "uniform float u_thickness;\n"
+            "uniform int u_mode;\n"
+            "out vec4 o_color;\n"
+            "void main()\n"
+            "{\n"
+            "    float a = u_mode == 0 ? clamp(0.5 * u_thickness + 0.5 - abs(v_edge), 0.0, 1.0) : 1.0;\n"
+            "    o_color = vec4(u_color.rgb, u_color.a * a);\n"
+            "}\n";
+
+        const GLuint vs = Compile(GL_VERTEX_SHADER, glsl_version, vs_body);
+        const GLuint fs = Compile(GL_FRAGMENT_SHADER, glsl_version, fs_body);
+        if (!vs || !fs)
+            return false;
+        program_ = gl_.CreateProgram();
+        gl_.AttachShader(program_, vs);
+        gl_.AttachShader(program_, fs);
+        gl_.BindAttribLocation(program_, 0, "a_p0");
+        gl_.BindAttribLocation(program_, 1, "a_p1");
+        gl_.LinkProgram(program_);
+        gl_.DeleteShader(vs);
+        gl_.DeleteShader(fs);
+        GLint ok = 0;
+        gl_.GetProgramiv(program_, GL_LINK_STATUS, &ok);
+        if (!ok)
+        {
+            char log[1024] = "";
+            gl_.GetProgramInfoLog(program_, sizeof(log), nullptr, log);
+            printf("GPU polyline: link failed: %s\n", log);
+            gl_.DeleteProgram(program_);
+            program_ = 0;
+            return false;
+        }
+        loc_data_rect_ = gl_.GetUniformLocation(program_, "u_data_rect");
+        loc_pixel_rect_ = gl_.GetUniformLocation(program_, "u_pixel_rect");
+        loc_fb_size_ = gl_.GetUniformLocation(program_, "u_fb_size");
+        loc_thickness_ = gl_.GetUniformLocation(program_, "u_thickness");
+        loc_fill_ref_ = gl_.GetUniformLocation(program_, "u_fill_ref");
+        loc_mode_ = gl_.GetUniformLocation(program_, "u_mode");
+        loc_color_ = gl_.GetUniformLocation(program_, "u_color");
+        gl_.GenVertexArrays(1, &vao_);
+        return true;
+#endif
+    }
+
+    void Shutdown()
+    {
+        if (!program_)
+            return;
+        for (auto& kv : series_)
+            gl_.DeleteBuffers(1, &kv.second.vbo);
+        series_.clear();
+        gl_.DeleteVertexArrays(1, &vao_);
+        gl_.DeleteProgram(program_);
+        program_ = 0;
+        vao_ = 0;
+    }
+
+    void BeginFrame() override
+    {
+        draws_.clear();
+        ++frame_;
+        // 一段時間沒被畫的 series 釋放 VBO
+        for (auto it = series_.begin(); it != series_.end();)
+        {
+            if (frame_ - it->second.last_frame > 600)
+            {
+                gl_.DeleteBuffers(1, &it->second.vbo);
+                it = series_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    bool Upload(ImGuiID series, std::uint64_t version, const double* xs, const double* ys, int n) override
+    {
+        if (!program_ || n < 2)
+            return false;
+        Series& s = series_[series];
+        s.last_frame = frame_;
+        if (s.vbo && s.version == version && s.n == n)
+            return true;
+
+        s.x0 = xs[0];
+        s.y0 = ys[0];
+        scratch_.resize((std::size_t)n * 2);
+        for (int i = 0; i < n; ++i)
+        {
+            scratch_[2 * i + 0] = (float)(xs[i] - s.x0);
+            scratch_[2 * i + 1] = (float)(ys[i] - s.y0);
+        }
+        if (!s.vbo)
+            gl_.GenBuffers(1, &s.vbo);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, s.vbo);
+        const GLsizeiptr bytes = (GLsizeiptr)(scratch_.size() * sizeof(float));
+        if (n > s.capacity)
+        {
+            gl_.BufferData(GL_ARRAY_BUFFER, bytes, scratch_.data(), GL_STATIC_DRAW);
+            s.capacity = n;
+        }
+        else
+        {
+            gl_.BufferSubData(GL_ARRAY_BUFFER, 0, bytes, scratch_.data());
+        }
+        gl_.BindBuffer(GL_ARRAY_BUFFER, 0);
+        s.version = version;
+        s.n = n;
+        return true;
+    }
+
+    void AddDraw(ImDrawList* draw_list, ImGuiID series, const PolylineDraw& draw) override
+    {
+        draws_.push_back({ this, series, draw });
+        draw_list->AddCallback(&GLPolylineBackend::DrawCallback, &draws_.back());
+        draw_list->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    }
+
+private:
+    struct Series
+    {
+        GLuint vbo = 0;
+        std::uint64_t version = ~0ull;
+        int n = 0;
+        int capacity = 0;
+        double x0 = 0.0, y0 = 0.0;
+        std::uint64_t last_frame = 0;
+    };
+
+    struct PendingDraw
+    {
+        GLPolylineBackend* self;
+        ImGuiID series;
+        PolylineDraw draw;
+    };
+
+    // 透過 SDL_GL_GetProcAddress 載入 (imgui_impl_opengl3 的 loader 是內部的，不能共用)
+    struct Functions
+    {
+        void (APIENTRY* GenBuffers)(GLsizei, GLuint*);
+        void (APIENTRY* DeleteBuffers)(GLsizei, const GLuint*);
+        void (APIENTRY* BindBuffer)(GLenum, GLuint);
+        void (APIENTRY* BufferData)(GLenum, GLsizeiptr, const void*, GLenum);
+        void (APIENTRY* BufferSubData)(GLenum, GLintptr, GLsizeiptr, const void*);
+        void (APIENTRY* GenVertexArrays)(GLsizei, GLuint*);
+        void (APIENTRY* DeleteVertexArrays)(GLsizei, const GLuint*);
+        void (APIENTRY* BindVertexArray)(GLuint);
+        void (APIENTRY* EnableVertexAttribArray)(GLuint);
+        void (APIENTRY* VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
+        void (APIENTRY* VertexAttribDivisor)(GLuint, GLuint);
+        void (APIENTRY* DrawArraysInstanced)(GLenum, GLint, GLsizei, GLsizei);
+        GLuint (APIENTRY* CreateShader)(GLenum);
+        void (APIENTRY* DeleteShader)(GLuint);
+        void (APIENTRY* ShaderSource)(GLuint, GLsizei, const GLchar* const*, const GLint*);
+        void (APIENTRY* CompileShader)(GLuint);
+        void (APIENTRY* GetShaderiv)(GLuint, GLenum, GLint*);
+        void (APIENTRY* GetShaderInfoLog)(GLuint, GLsizei, GLsizei*, GLchar*);
+        GLuint (APIENTRY* CreateProgram)();
+        void (APIENTRY* DeleteProgram)(GLuint);
+        void (APIENTRY* AttachShader)(GLuint, GLuint);
+        void (APIENTRY* BindAttribLocation)(GLuint, GLuint, const GLchar*);
+        void (APIENTRY* LinkProgram)(GLuint);
+        void (APIENTRY* GetProgramiv)(GLuint, GLenum, GLint*);
+        void (APIENTRY* GetProgramInfoLog)(GLuint, GLsizei, GLsizei*, GLchar*);
+        void (APIENTRY* UseProgram)(GLuint);
+        GLint (APIENTRY* GetUniformLocation)(GLuint, const GLchar*);
+        void (APIENTRY* Uniform1i)(GLint, GLint);
+        void (APIENTRY* Uniform1f)(GLint, GLfloat);
+        void (APIENTRY* Uniform2f)(GLint, GLfloat, GLfloat);
+        void (APIENTRY* Uniform4f)(GLint, GLfloat, GLfloat, GLfloat, GLfloat);
+    };
+
+    Functions gl_ = {};
+    GLuint program_ = 0;
+    GLuint vao_ = 0;
+    GLint loc_data_rect_ = -1, loc_pixel_rect_ = -1, loc_fb_size_ = -1, loc_thickness_ = -1;
+    GLint loc_fill_ref_ = -1, loc_mode_ = -1, loc_color_ = -1;
+    std::unordered_map<ImGuiID, Series> series_;
+    std::deque<PendingDraw> draws_;    // callback 的 user data，指標在這一幀內要穩定 (deque push_back 不搬移)
+    std::vector<float> scratch_;
+    std::uint64_t frame_ = 0;
+
+    template <typename F>
+    static bool Load(F& fn, const char* name, const char* alt = nullptr)
+    {
+        fn = reinterpret_cast<F>(SDL_GL_GetProcAddress(name));
+        if (!fn && alt)
+            fn = reinterpret_cast<F>(SDL_GL_GetProcAddress(alt));
+        return fn != nullptr;
+    }
+
+    bool LoadFunctions()
+    {
+        bool ok = true;
+        ok &= Load(gl_.GenBuffers, "glGenBuffers");
+        ok &= Load(gl_.DeleteBuffers, "glDeleteBuffers");
+        ok &= Load(gl_.BindBuffer, "glBindBuffer");
+        ok &= Load(gl_.BufferData, "glBufferData");
+        ok &= Load(gl_.BufferSubData, "glBufferSubData");
+        ok &= Load(gl_.GenVertexArrays, "glGenVertexArrays");
+        ok &= Load(gl_.DeleteVertexArrays, "glDeleteVertexArrays");
+        ok &= Load(gl_.BindVertexArray, "glBindVertexArray");
+        ok &= Load(gl_.EnableVertexAttribArray, "glEnableVertexAttribArray");
+        ok &= Load(gl_.VertexAttribPointer, "glVertexAttribPointer");
+        ok &= Load(gl_.VertexAttribDivisor, "glVertexAttribDivisor", "glVertexAttribDivisorARB");
+        ok &= Load(gl_.DrawArraysInstanced, "glDrawArraysInstanced", "glDrawArraysInstancedARB");
+        ok &= Load(gl_.CreateShader, "glCreateShader");
+        ok &= Load(gl_.DeleteShader, "glDeleteShader");
+        ok &= Load(gl_.ShaderSource, "glShaderSource");
+        ok &= Load(gl_.CompileShader, "glCompileShader");
+        ok &= Load(gl_.GetShaderiv, "glGetShaderiv");
+        ok &= Load(gl_.GetShaderInfoLog, "glGetShaderInfoLog");
+        ok &= Load(gl_.CreateProgram, "glCreateProgram");
+        ok &= Load(gl_.DeleteProgram, "glDeleteProgram");
+        ok &= Load(gl_.AttachShader, "glAttachShader");
+        ok &= Load(gl_.BindAttribLocation, "glBindAttribLocation");
+        ok &= Load(gl_.LinkProgram, "glLinkProgram");
+        ok &= Load(gl_.GetProgramiv, "glGetProgramiv");
+        ok &= Load(gl_.GetProgramInfoLog, "glGetProgramInfoLog");
+        ok &= Load(gl_.UseProgram, "glUseProgram");
+        ok &= Load(gl_.GetUniformLocation, "glGetUniformLocation");
+        ok &= Load(gl_.Uniform1i, "glUniform1i");
+        ok &= Load(gl_.Uniform1f, "glUniform1f");
+        ok &= Load(gl_.Uniform2f, "glUniform2f");
+        ok &= Load(gl_.Uniform4f, "glUniform4f");
+        return ok;
+    }
+
+    GLuint Compile(GLenum type, const char* glsl_version, const char* body)
+    {
+        const GLuint sh = gl_.CreateShader(type);
+        // GLSL ES 3.00 沒有預設的 float 精度
+        const char* precision = strstr(glsl_version, " es") ? "precision highp float;\n" : "";
+        const GLchar* src[4] = { glsl_version, "\n", precision, body };
+        gl_.ShaderSource(sh, 4, src, nullptr);
+        gl_.CompileShader(sh);
+        GLint ok = 0;
+        gl_.GetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+        if (!ok)
+        {
+            char log[1024] = "";
+            gl_.GetShaderInfoLog(sh, sizeof(log), nullptr, log);
+            printf("GPU polyline: shader compile failed: %s\n", log);
+            gl_.DeleteShader(sh);
+            return 0;
+        }
+        return sh;
+    }
+
+    static void DrawCallback(const ImDrawList*, const ImDrawCmd* cmd)
+    {
+        const PendingDraw* p = static_cast<const PendingDraw*>(cmd->UserCallbackData);
+        p->self->Draw(*p, cmd->ClipRect);
+    }
+
+    void Draw(const PendingDraw& p, const ImVec4& clip_rect)
+    {
+        auto it = series_.find(p.series);
+        if (it == series_.end())
+            return;
+        const Series& s = it->second;
+        const PolylineDraw& d = p.draw;
+
+        // 與 imgui_impl_opengl3 相同的座標換算：display 座標 -> framebuffer 像素
+        const ImDrawData* dd = ImGui::GetDrawData();
+        const ImVec2 off = dd->DisplayPos;
+        const ImVec2 scale = dd->FramebufferScale;
+        const float fb_w = dd->DisplaySize.x * scale.x;
+        const float fb_h = dd->DisplaySize.y * scale.y;
+        if (fb_w <= 0.0f || fb_h <= 0.0f)
+            return;
+
+        const float cx0 = (clip_rect.x - off.x) * scale.x, cy0 = (clip_rect.y - off.y) * scale.y;
+        const float cx1 = (clip_rect.z - off.x) * scale.x, cy1 = (clip_rect.w - off.y) * scale.y;
+        if (cx1 <= cx0 || cy1 <= cy0)
+            return;
+        glScissor((GLint)cx0, (GLint)(fb_h - cy1), (GLsizei)(cx1 - cx0), (GLsizei)(cy1 - cy0));
+
+        gl_.UseProgram(program_);
+        gl_.BindVertexArray(vao_);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, s.vbo);
+        const std::size_t base = (std::size_t)d.first * 2 * sizeof(float);
+        gl_.EnableVertexAttribArray(0);
+        gl_.EnableVertexAttribArray(1);
+        gl_.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (const void*)base);
+        gl_.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (const void*)(base + 2 * sizeof(float)));
+        gl_.VertexAttribDivisor(0, 1);
+        gl_.VertexAttribDivisor(1, 1);
+
+        gl_.Uniform4f(loc_data_rect_, (float)(d.x_min - s.x0), (float)(d.y_min - s.y0), (float)(d.x_max - s.x0), (float)(d.y_max - s.y0));
+        gl_.Uniform4f(loc_pixel_rect_, (d.plot_pos.x - off.x) * scale.x, (d.plot_pos.y - off.y) * scale.y,
+            d.plot_size.x * scale.x, d.plot_size.y * scale.y);
+        gl_.Uniform2f(loc_fb_size_, fb_w, fb_h);
+        gl_.Uniform1f(loc_thickness_, d.thickness * scale.x);
+        gl_.Uniform1f(loc_fill_ref_, (float)(d.fill_ref - s.y0));
+        gl_.Uniform1i(loc_mode_, d.mode);
+        gl_.Uniform4f(loc_color_, d.color.x, d.color.y, d.color.z, d.color.w);
+
+        gl_.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, d.count - 1);
+
+        gl_.VertexAttribDivisor(0, 0);
+        gl_.VertexAttribDivisor(1, 0);
+        gl_.BindVertexArray(0);
+    }
+};
@@ -0,0 +1,250 @@
+// latency_probe.h - Input-to-photon 延遲量測
+//
+// 每幀記錄「這一幀裡最早的輸入事件」的 SDL timestamp，接著標記：
+//   Process  : 呼叫 ImGui_ImplSDL3_ProcessEvent 的時間
+//   UI       : ImGui::Render() 完成 (UI build 結束)
+//   Submit   : backend 送出繪圖指令 (RenderDrawData / SubmitGPUCommandBuffer)
+//   Present  : SwapWindow / RenderPresent 回傳；SDL_GPU 則是送出後 SDL_WaitForGPUSwapchain 回傳
+//              (swapchain 又有空位 = 這一幀已排進 present，等同 vsync/mailbox 的真實節奏)
+// 每個階段累積直方圖，報告 p50 / p95 / p99。
+#pragma once
+
+#include "imgui.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <cstdint>
+
+enum LatencyStage
+{
+    LatencyStage_Queue = 0,     // 事件產生 -> ProcessEvent
+    LatencyStage_Build,         // ProcessEvent -> UI build 完成
+    LatencyStage_Submit,        // UI build -> 送出 GPU 指令
+    LatencyStage_Present,       // 送出 -> present / SDL_WaitForGPUSwapchain 回傳
+    LatencyStage_Total,         // 事件產生 -> present
+    LatencyStage_COUNT
+};
+
+// 0.1 ms 一格，最多 100 ms；超過的算在最後一格
+struct LatencyHistogram
+{
+    static constexpr int kBuckets = 1000;
+    static constexpr double kBucketMs = 0.1;
+
+    std::uint32_t counts[kBuckets] = {};
+    std::uint64_t total = 0;
+    double sum_ms = 0.0;
+    double max_ms = 0.0;
+
+    void Add(double ms)
+    {
+        const int b = std::clamp((int)(ms / kBucketMs), 0, kBuckets - 1);
+        ++counts[b];
+        ++total;
+        sum_ms += ms;
+        max_ms = std::max(max_ms, ms);
+    }
+
+    double Percentile(double p) const
+    {
+        if (total == 0) return 0.0;
+        const std::uint64_t target = (std::uint64_t)(p * (total - 1)) + 1;
+        std::uint64_t acc = 0;
+        for (int b = 0; b < kBuckets; ++b)
+        {
+            acc += counts[b];
+            if (acc >= target)
+                return (b + 0.5) * kBucketMs;
+        }
+        return max_ms;
+    }
+
+    double Mean() const { return total ? sum_ms / total : 0.0; }
+};
+
+class LatencyProbe
+{
+public:
+    explicit LatencyProbe(const char* backend_name) : backend_name_(backend_name) {}
+
+    const char* BackendName() const { return backend_name_; }
+    const LatencyHistogram& Histogram(LatencyStage s) const { return hist_[s]; }
+
+    // 在 ImGui_ImplSDL3_ProcessEvent 之前呼叫
+    void OnEvent(const SDL_Event& event)
+    {
+        if (!IsInputEvent(event.type))
+            return;
+        const Uint64 now = SDL_GetTicksNS();
+        const Uint64 ts = event.common.timestamp ? event.common.timestamp : now;
+        if (!frame_has_input_ || ts < frame_.event_ns)
+        {
+            frame_.event_ns = ts;
+            frame_.process_ns = now;
+        }
+        frame_has_input_ = true;
+    }
+
+    void MarkUiBuilt() { if (frame_has_input_) frame_.ui_ns = SDL_GetTicksNS(); }
+    void MarkSubmitted() { if (frame_has_input_) frame_.submit_ns = SDL_GetTicksNS(); }
+
+    // OpenGL / SDL_Renderer：Swap / Present 回傳即視為上屏
+    void MarkPresented()
+    {
+        if (frame_has_input_)
+            Record(frame_, SDL_GetTicksNS());
+        frame_has_input_ = false;
+    }
+
+    // SDL_GPU (同步繪製)：SDL_SubmitGPUCommandBuffer 之後、SDL_WaitForGPUSwapchain 回傳時呼叫
+    void MarkSwapchainPresented(Uint64 wait_ns)
+    {
+        swapchain_wait_.Add(wait_ns / 1e6);
+        MarkPresented();
+    }
+
+    // SDL_GPU (管線化)：主執行緒把第 frame_id 幀交給 render thread 後呼叫
+    void EndGpuFrame(std::uint64_t frame_id)
+    {
+        if (frame_has_input_)
+        {
+            in_flight_ = frame_;
+            in_flight_id_ = frame_id;
+            in_flight_valid_ = true;
+        }
+        frame_has_input_ = false;
+    }
+
+    // render thread 回報第 frame_id 幀在 present_ns 上屏 (送出後 SDL_WaitForGPUSwapchain 回傳)。
+    // 含輸入的幀若被較新的幀取代而沒畫，輸入的效果由較新的幀呈現，一併以這個時間記錄。
+    void MarkPipelinePresented(std::uint64_t frame_id, Uint64 present_ns, Uint64 wait_ns)
+    {
+        swapchain_wait_.Add(wait_ns / 1e6);
+        if (in_flight_valid_ && frame_id >= in_flight_id_)
+        {
+            Record(in_flight_, present_ns);
+            in_flight_valid_ = false;
+        }
+    }
+
+    const LatencyHistogram& SwapchainWait() const { return swapchain_wait_; }
+
+    void Reset()
+    {
+        for (LatencyHistogram& h : hist_) h = LatencyHistogram();
+        swapchain_wait_ = LatencyHistogram();
+    }
+
+    void PrintReport() const
+    {
+        static const char* names[LatencyStage_COUNT] = { "queue", "build", "submit", "present", "total" };
+        printf("[Latency] backend: %s, samples: %llu\n", backend_name_, (unsigned long long)hist_[LatencyStage_Total].total);
+        for (int s = 0; s < LatencyStage_COUNT; ++s)
+        {
+            const LatencyHistogram& h = hist_[s];
+            printf("  %-8s mean %6.2f  p50 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f ms\n",
+                names[s], h.Mean(), h.Percentile(0.50), h.Percentile(0.95), h.Percentile(0.99), h.max_ms);
+        }
+        if (swapchain_wait_.total)
+            printf("  swapwait mean %6.2f  p50 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f ms\n",
+                swapchain_wait_.Mean(), swapchain_wait_.Percentile(0.50), swapchain_wait_.Percentile(0.95),
+                swapchain_wait_.Percentile(0.99), swapchain_wait_.max_ms);
+    }
+
+private:
+    struct FrameStamps
+    {
+        Uint64 event_ns = 0;
+        Uint64 process_ns = 0;
+        Uint64 ui_ns = 0;
+        Uint64 submit_ns = 0;
+    };
+
+    const char* backend_name_;
+    LatencyHistogram hist_[LatencyStage_COUNT];
+    LatencyHistogram swapchain_wait_;
+    FrameStamps frame_, in_flight_;
+    std::uint64_t in_flight_id_ = 0;
+    bool frame_has_input_ = false;
+    bool in_flight_valid_ = false;
+
+    static bool IsInputEvent(Uint32 type)
+    {
+        switch (type)
+        {
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+        case SDL_EVENT_TEXT_EDITING:
+        case SDL_EVENT_TEXT_INPUT:
+        case SDL_EVENT_MOUSE_MOTION:
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+        case SDL_EVENT_MOUSE_WHEEL:
+        case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+        case SDL_EVENT_GAMEPAD_BUTTON_UP:
+        case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+            return true;
+        }
+        return false;
+    }
+
+    static double Ms(Uint64 from, Uint64 to) { return to > from ? (to - from) / 1e6 : 0.0; }
+
+    void Record(const FrameStamps& f, Uint64 present_ns)
+    {
+        const Uint64 ui = f.ui_ns ? f.ui_ns : f.process_ns;
+        const Uint64 submit = f.submit_ns ? f.submit_ns : ui;
+        hist_[LatencyStage_Queue].Add(Ms(f.event_ns, f.process_ns));
+        hist_[LatencyStage_Build].Add(Ms(f.process_ns, ui));
+        hist_[LatencyStage_Submit].Add(Ms(ui, submit));
+        hist_[LatencyStage_Present].Add(Ms(submit, present_ns));
+        hist_[LatencyStage_Total].Add(Ms(f.event_ns, present_ns));
+    }
+};
+
+// ----------------------------- UI -----------------------------
+static void DrawLatencyPanel(LatencyProbe& probe, bool* open)
+{
+    if (!*open)
+        return;
+    ImGui::SetNextWindowSize(ImVec2(560, 0), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("延遲量測 (Input-to-Photon)", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Backend: %s", probe.BackendName());
+    ImGui::SameLine();
+    if (ImGui::SmallButton("重設"))
+        probe.Reset();
+
+    static const char* names[LatencyStage_COUNT] = { "事件佇列", "UI 建構", "送出指令", "上屏", "總延遲" };
+    if (ImGui::BeginTable("##Latency", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("階段");
+        ImGui::TableSetupColumn("樣本");
+        ImGui::TableSetupColumn("p50 ms");
+        ImGui::TableSetupColumn("p95 ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableSetupColumn("max ms");
+        ImGui::TableHeadersRow();
+        auto row = [](const char* name, const LatencyHistogram& h) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", name);
+            ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)h.total);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", h.Percentile(0.50));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", h.Percentile(0.95));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", h.Percentile(0.99));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", h.max_ms);
+        };
+        for (int s = 0; s < LatencyStage_COUNT; ++s)
+            row(names[s], probe.Histogram((LatencyStage)s));
+        if (probe.SwapchainWait().total)
+            row("Swapchain 等待", probe.SwapchainWait());
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
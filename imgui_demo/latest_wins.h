@@ -0,0 +1,167 @@
+// latest_wins.h - 「只算最新一筆」的背景工作槽
+//
+// 拖拉滑桿時每一幀都會送出新的定價請求，但只有最後一筆有意義：
+//   - 還沒開始的請求被新請求直接覆蓋 (superseded)，不會被執行
+//   - 執行中的工作透過 CancelToken 定期檢查自己是否已過時，過時就提早放棄 (cancelled)
+//   - UI 一直顯示「最後一份完成的結果」，新結果完成後才換上
+// 結果緩衝區在 worker / ready / UI 之間以 swap 輪替，穩定狀態下不配置記憶體。
+// 一個 LatestWinsJob 一條 worker 執行緒；Submit / TakeLatest 只短暫持鎖，不會卡住 UI。
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// 工作用來檢查「是否已有更新的請求」；只讀一個 atomic，可以在內層迴圈頻繁呼叫
+class CancelToken
+{
+public:
+    CancelToken(const std::atomic<std::uint64_t>* latest, std::uint64_t ticket)
+        : latest_(latest), ticket_(ticket) {}
+
+    bool cancelled() const { return latest_->load(std::memory_order_relaxed) != ticket_; }
+
+private:
+    const std::atomic<std::uint64_t>* latest_;
+    std::uint64_t ticket_;
+};
+
+// 與結果型別無關，metrics 等外部統計可以直接收
+struct LatestWinsStats
+{
+    std::uint64_t submitted = 0;
+    std::uint64_t superseded = 0;   // 還沒開始就被新請求覆蓋
+    std::uint64_t cancelled = 0;    // 執行到一半放棄
+    std::uint64_t completed = 0;
+    double last_ms = 0.0;           // 最後一份完成結果的計算時間
+};
+
+template <typename Result>
+class LatestWinsJob
+{
+public:
+    // 回傳 false 表示中途被取消 (結果不完整，丟棄)
+    using Job = std::function<bool(Result& out, const CancelToken& cancel)>;
+    using Stats = LatestWinsStats;
+
+    LatestWinsJob()
+    {
+        worker_ = std::thread([this] { WorkerMain(); });
+    }
+
+    ~LatestWinsJob()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            ticket_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    LatestWinsJob(const LatestWinsJob&) = delete;
+    LatestWinsJob& operator=(const LatestWinsJob&) = delete;
+
+    // 送出新請求；之前排隊中的直接作廢，執行中的會在下一次檢查 CancelToken 時放棄
+    void Submit(Job job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_)
+                ++stats_.superseded;
+            pending_ = std::move(job);
+            ++stats_.submitted;
+            ticket_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cv_.notify_one();
+    }
+
+    // 作廢所有尚未交付的工作與結果 (例如 UI 執行緒自己同步算好了)
+    void Cancel()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_)
+            ++stats_.superseded;
+        pending_ = nullptr;
+        fresh_ = false;
+        ticket_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 有新完成的結果就與 out 交換並回傳 true；out 原本的緩衝區交回給 worker 重複使用
+    bool TakeLatest(Result& out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!fresh_)
+            return false;
+        std::swap(out, ready_);
+        fresh_ = false;
+        return true;
+    }
+
+    // 還有排隊或執行中的工作
+    bool Busy() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_ != nullptr || running_;
+    }
+
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    void WorkerMain()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            cv_.wait(lock, [&] { return stop_ || pending_ != nullptr; });
+            if (stop_)
+                return;
+            Job job = std::move(pending_);
+            pending_ = nullptr;
+            const CancelToken token(&ticket_, ticket_.load(std::memory_order_relaxed));
+            running_ = true;
+            lock.unlock();
+
+            const auto t0 = std::chrono::steady_clock::now();
+            const bool done = job(back_, token);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+            lock.lock();
+            running_ = false;
+            // ticket 只在持鎖時遞增，這裡的判斷與 Submit / Cancel 不會交錯
+            if (done && !token.cancelled())
+            {
+                std::swap(back_, ready_);
+                fresh_ = true;
+                ++stats_.completed;
+                stats_.last_ms = ms;
+            }
+            else
+            {
+                ++stats_.cancelled;
+            }
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread worker_;
+    std::atomic<std::uint64_t> ticket_{ 0 };
+    Job pending_;
+    bool running_ = false;
+    bool fresh_ = false;
+    bool stop_ = false;
+    Result back_;    // worker 正在寫
+    Result ready_;   // 已完成、等 UI 取走
+    Stats stats_;
+};
@@ -0,0 +1,366 @@
+// live_config.h - 策略 / 行情 / 版面設定檔，檔案變動時即時重新載入 (--config <path>)
+//
+// 格式 (INI 風格，# 或 ; 開頭為註解)：
+//   [market]    spot / iv_pct / days / rate_pct / yield_pct / term_structure (0 / 1)
+//   [strategy]  strike_atm / width
+//   [model]     type (0 = Black-Scholes、1 = Heston、2 = Bates) / v0_vol_pct / theta_vol_pct / kappa / xi / rho /
+//               jump_lambda / jump_mu_pct / jump_sigma_pct
+//   [layout]    show_dashboard / show_ladder / show_latency / show_pacing / show_memory / show_explain /
+//               dense_curve / async_pricing (0 / 1)
+//   [panel SPY] spot / iv_pct / days / rate_pct / strike_atm / width   (儀表板面板，依名稱對應)
+//
+// 重新載入時跟上一份設定比對，只套用「值有變的欄位」：
+//   - 主畫面欄位：只改那個欄位，SyncButterflyLegs 的逐腿 setter 只重算輸入真的變了的腿；
+//     設定檔沒改到的欄位保留使用者在介面上的修改
+//   - 儀表板：依名稱比對情境，沒變的面板不動 (PricingService 的快取繼續命中)，變了的只換情境，
+//     新名稱新增面板、從設定檔移除的面板關閉
+// Linux 用 inotify 監看所在目錄 (編輯器多半是寫暫存檔再 rename，監看檔案本身會漏)，
+// 只收寫完關檔 / rename 進來兩種事件，避免讀到寫一半的檔案；
+// 其他平台每 0.5 秒比對一次修改時間。解析失敗時保留目前設定並在側欄顯示錯誤。
+#pragma once
+
+#include "butterfly_app.h"
+#include "dashboard.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <charconv>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+struct LiveConfig
+{
+    std::map<std::string, double> values;                   // "section.key" -> 值 (面板以外)
+    std::vector<std::pair<std::string, Scenario>> panels;   // 依檔案順序
+};
+
+// 主畫面可由設定檔控制的欄位
+struct LiveConfigBinding
+{
+    const char* key;
+    void (*apply)(ButterflyApp& app, double v);
+};
+
+static const LiveConfigBinding kLiveConfigBindings[] = {
+    { "market.spot", [](ButterflyApp& a, double v) { a.current_price = std::max(0.01, v); } },
+    { "market.iv_pct", [](ButterflyApp& a, double v) { a.iv_pct = v; } },
+    { "market.days", [](ButterflyApp& a, double v) { a.days_to_expiry = std::max(0, (int)std::lround(v)); } },
+    { "market.rate_pct", [](ButterflyApp& a, double v) { a.risk_free_pct = v; } },
+    // 股利率只在期限結構模式下生效；模式由 term_structure 明確切換，設股利率不會改掉利率模型
+    { "market.yield_pct", [](ButterflyApp& a, double v) { a.term_structure.yield_pct = v; } },
+    { "market.term_structure", [](ButterflyApp& a, double v) { a.use_term_structure = v != 0.0; } },
+    { "strategy.strike_atm", [](ButterflyApp& a, double v) { a.strike_atm = v; } },
+    { "strategy.width", [](ButterflyApp& a, double v) { a.width = std::max(0.1, v); } },
+    { "model.type", [](ButterflyApp& a, double v) { a.stoch_vol.model = std::clamp((int)std::lround(v), 0, (int)PricingModel_Bates); } },
+    { "model.v0_vol_pct", [](ButterflyApp& a, double v) { a.stoch_vol.v0_vol_pct = v; } },
+    { "model.theta_vol_pct", [](ButterflyApp& a, double v) { a.stoch_vol.theta_vol_pct = v; } },
+    { "model.kappa", [](ButterflyApp& a, double v) { a.stoch_vol.kappa = v; } },
+    { "model.xi", [](ButterflyApp& a, double v) { a.stoch_vol.xi = v; } },
+    { "model.rho", [](ButterflyApp& a, double v) { a.stoch_vol.rho = std::clamp(v, -0.999, 0.999); } },
+    { "model.jump_lambda", [](ButterflyApp& a, double v) { a.stoch_vol.jump_lambda = v; } },
+    { "model.jump_mu_pct", [](ButterflyApp& a, double v) { a.stoch_vol.jump_mu_pct = v; } },
+    { "model.jump_sigma_pct", [](ButterflyApp& a, double v) { a.stoch_vol.jump_sigma_pct = v; } },
+    { "layout.show_dashboard", [](ButterflyApp& a, double v) { a.show_dashboard = v != 0.0; } },
+    { "layout.show_ladder", [](ButterflyApp& a, double v) { a.show_ladder = v != 0.0; } },
+    { "layout.show_latency", [](ButterflyApp& a, double v) { a.show_latency = v != 0.0; } },
+    { "layout.show_pacing", [](ButterflyApp& a, double v) { a.show_pacing = v != 0.0; } },
+    { "layout.show_memory", [](ButterflyApp& a, double v) { a.show_memory = v != 0.0; } },
+    { "layout.show_explain", [](ButterflyApp& a, double v) { a.show_explain = v != 0.0; } },
+    { "layout.dense_curve", [](ButterflyApp& a, double v) { a.dense_curve = v != 0.0; } },
+    { "layout.async_pricing", [](ButterflyApp& a, double v) { a.async_pricing = v != 0.0; } },
+};
+
+static const LiveConfigBinding* FindLiveConfigBinding(const std::string& key)
+{
+    for (const LiveConfigBinding& b : kLiveConfigBindings)
+        if (key == b.key)
+            return &b;
+    return nullptr;
+}
+
+static bool SetScenarioField(Scenario& sc, const std::string& key, double v)
+{
+    if (key == "spot") sc.spot = v;
+    else if (key == "iv_pct") sc.iv_pct = v;
+    else if (key == "days") sc.days = v;
+    else if (key == "rate_pct") sc.rate_pct = v;
+    else if (key == "strike_atm") sc.strike_atm = v;
+    else if (key == "width") sc.width = v;
+    else return false;
+    return true;
+}
+
+static std::string TrimConfigToken(const char* b, const char* e)
+{
+    while (b < e && (*b == ' ' || *b == '\t')) ++b;
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r' || e[-1] == '\n')) --e;
+    return std::string(b, e);
+}
+
+// 解析失敗回傳 false，error 寫入行號與原因
+static bool ParseLiveConfig(const char* path, LiveConfig& out, char* error, std::size_t error_size)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        snprintf(error, error_size, "無法開啟 %s", path);
+        return false;
+    }
+    out = LiveConfig();
+    std::string section;
+    Scenario* panel = nullptr;
+    char line[512];
+    int line_no = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f))
+    {
+        ++line_no;
+        const std::string s = TrimConfigToken(line, line + strlen(line));
+        if (s.empty() || s[0] == '#' || s[0] == ';')
+            continue;
+        if (s[0] == '[')
+        {
+            const std::size_t close = s.find(']');
+            if (close == std::string::npos)
+            {
+                snprintf(error, error_size, "第 %d 行: 缺少 ]", line_no);
+                ok = false;
+                break;
+            }
+            section = TrimConfigToken(s.data() + 1, s.data() + close);
+            panel = nullptr;
+            if (section.compare(0, 6, "panel ") == 0)
+            {
+                // 預設值同 DashboardPanel；同名面板以最後一段為準
+                const std::string name = TrimConfigToken(section.data() + 6, section.data() + section.size());
+                out.panels.push_back({ name.substr(0, sizeof(DashboardPanel::name) - 1), DashboardPanel().sc });
+                panel = &out.panels.back().second;
+            }
+            continue;
+        }
+        const std::size_t eq = s.find('=');
+        double v = 0.0;
+        const std::string key = eq == std::string::npos ? s : TrimConfigToken(s.data(), s.data() + eq);
+        const std::string text = eq == std::string::npos ? std::string() : TrimConfigToken(s.data() + eq + 1, s.data() + s.size());
+        const char* vb = text.data() + (!text.empty() && text[0] == '+' ? 1 : 0);
+        const auto res = std::from_chars(vb, text.data() + text.size(), v);
+        if (eq == std::string::npos || res.ec != std::errc() || res.ptr != text.data() + text.size())
+        {
+            snprintf(error, error_size, "第 %d 行: 需要 key = 數值", line_no);
+            ok = false;
+        }
+        else if (panel)
+        {
+            if (!SetScenarioField(*panel, key, v))
+            {
+                snprintf(error, error_size, "第 %d 行: 面板沒有欄位 %s", line_no, key.c_str());
+                ok = false;
+            }
+        }
+        else if (!FindLiveConfigBinding(section + "." + key))
+        {
+            snprintf(error, error_size, "第 %d 行: 未知的設定 %s.%s", line_no, section.c_str(), key.c_str());
+            ok = false;
+        }
+        else
+            out.values[section + "." + key] = v;
+    }
+    fclose(f);
+    return ok;
+}
+
+static bool SameScenario(const Scenario& a, const Scenario& b)
+{
+    return a.spot == b.spot && a.iv_pct == b.iv_pct && a.days == b.days && a.rate_pct == b.rate_pct &&
+           a.strike_atm == b.strike_atm && a.width == b.width;
+}
+
+class LiveConfigWatcher
+{
+public:
+    LiveConfigWatcher() = default;
+    ~LiveConfigWatcher() { Close(); }
+
+    LiveConfigWatcher(const LiveConfigWatcher&) = delete;
+    LiveConfigWatcher& operator=(const LiveConfigWatcher&) = delete;
+
+    // 開始監看；第一次 Poll 會完整套用一次
+    bool Open(const char* path)
+    {
+        Close();
+        path_ = path;
+        pending_ = true;
+        std::error_code ec;
+        const std::filesystem::path p(path_);
+        file_name_ = p.filename().string();
+        last_write_ = std::filesystem::last_write_time(p, ec);
+#ifdef __linux__
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ >= 0)
+        {
+            const std::string dir = p.has_parent_path() ? p.parent_path().string() : std::string(".");
+            if (inotify_add_watch(inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+            {
+                close(inotify_fd_);
+                inotify_fd_ = -1;
+            }
+        }
+        if (inotify_fd_ < 0)
+            printf("[config] inotify 不可用，改為輪詢 %s\n", path_.c_str());
+#endif
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef __linux__
+        if (inotify_fd_ >= 0)
+            close(inotify_fd_);
+        inotify_fd_ = -1;
+#endif
+        path_.clear();
+    }
+
+    bool IsOpen() const { return !path_.empty(); }
+
+    // 每幀呼叫 (DrawButterflyApp 之前)；檔案有變才解析、比對、套用
+    void Poll(ButterflyApp& app, Dashboard& dash)
+    {
+        if (!IsOpen())
+            return;
+        if (!pending_ && !CheckChanged())
+            return;
+        pending_ = false;
+
+        LiveConfig next;
+        char error[160] = "";
+        if (!ParseLiveConfig(path_.c_str(), next, error, sizeof(error)))
+        {
+            snprintf(app.config_status, sizeof(app.config_status), "設定檔錯誤 (保留目前設定): %s", error);
+            return;
+        }
+        Apply(next, app, dash);
+        current_ = std::move(next);
+        loaded_ = true;
+    }
+
+private:
+    std::string path_;
+    std::string file_name_;
+    std::filesystem::file_time_type last_write_{};
+    std::chrono::steady_clock::time_point last_check_{};
+    LiveConfig current_;
+    bool loaded_ = false;
+    bool pending_ = false;
+#ifdef __linux__
+    int inotify_fd_ = -1;
+#endif
+
+    bool CheckChanged()
+    {
+#ifdef __linux__
+        if (inotify_fd_ >= 0)
+        {
+            alignas(inotify_event) char buf[4096];
+            bool changed = false;
+            for (;;)
+            {
+                const ssize_t n = read(inotify_fd_, buf, sizeof(buf));
+                if (n <= 0)
+                    break;
+                for (ssize_t off = 0; off < n;)
+                {
+                    const inotify_event* ev = (const inotify_event*)(buf + off);
+                    if (ev->len > 0 && file_name_ == ev->name)
+                        changed = true;
+                    off += sizeof(inotify_event) + ev->len;
+                }
+            }
+            return changed;
+        }
+#endif
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_check_ < std::chrono::milliseconds(500))
+            return false;
+        last_check_ = now;
+        std::error_code ec;
+        const auto t = std::filesystem::last_write_time(path_, ec);
+        if (ec || t == last_write_)
+            return false;
+        last_write_ = t;
+        return true;
+    }
+
+    void Apply(const LiveConfig& next, ButterflyApp& app, Dashboard& dash)
+    {
+        int fields = 0, panels_changed = 0, panels_added = 0, panels_removed = 0;
+        for (const auto& kv : next.values)
+        {
+            const auto old = current_.values.find(kv.first);
+            if (loaded_ && old != current_.values.end() && old->second == kv.second)
+                continue;
+            FindLiveConfigBinding(kv.first)->apply(app, kv.second);
+            ++fields;
+        }
+
+        for (const auto& [name, sc] : next.panels)
+        {
+            const Scenario* old = FindPanelConfig(current_, name);
+            if (loaded_ && old && SameScenario(*old, sc))
+                continue;
+            DashboardPanel* p = FindPanel(dash, name);
+            if (!p)
+            {
+                dash.AddPanel(name.c_str(), sc.spot);
+                p = &dash.panels.back();
+                ++panels_added;
+            }
+            else
+                ++panels_changed;
+            p->sc = sc;
+            p->open = true;
+        }
+        // 上一份設定有、這一份沒有的面板：關閉 (DrawDashboard 會移除)
+        for (const auto& [name, sc] : current_.panels)
+        {
+            if (FindPanelConfig(next, name))
+                continue;
+            if (DashboardPanel* p = FindPanel(dash, name))
+            {
+                p->open = false;
+                ++panels_removed;
+            }
+        }
+
+        snprintf(app.config_status, sizeof(app.config_status), "已載入 %s: 欄位 %d、面板 +%d / ~%d / -%d",
+            file_name_.c_str(), fields, panels_added, panels_changed, panels_removed);
+        printf("[config] %s\n", app.config_status);
+    }
+
+    static const Scenario* FindPanelConfig(const LiveConfig& cfg, const std::string& name)
+    {
+        const Scenario* found = nullptr;
+        for (const auto& [n, sc] : cfg.panels)
+            if (n == name)
+                found = &sc;
+        return found;
+    }
+
+    static DashboardPanel* FindPanel(Dashboard& dash, const std::string& name)
+    {
+        for (DashboardPanel& p : dash.panels)
+            if (p.open && name == p.name)
+                return &p;
+        return nullptr;
+    }
+};
@@ -0,0 +1,75 @@
+// mapped_file.h - 唯讀記憶體映射檔案
+//
+// Windows 用 CreateFileMapping / MapViewOfFile，其他平台用 mmap。開啟後 data / size
+// 直接指向檔案內容，讀取端不必再拷貝或解析；解構時自動解除映射。
+// session_snapshot.h 與 option_chain.h 共用。
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct MappedFile
+{
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+
+    bool Open(const char* path)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file, &sz) || sz.QuadPart == 0) { Close(); return false; }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping) { Close(); return false; }
+        data = (const std::uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        size = (std::size_t)sz.QuadPart;
+        if (!data) { Close(); return false; }
+        return true;
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+        void* p = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return false;
+        data = (const std::uint8_t*)p;
+        size = (std::size_t)st.st_size;
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap((void*)data, size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    ~MappedFile() { Close(); }
+};
@@ -0,0 +1,141 @@
+// market_curves.h - 零息利率期限結構 + 股利 (連續殖利率 / 離散現金股利)
+//
+// 每個到期日只需要三個數：
+//   df     = exp(-r(T) T)                 折現因子 (零息曲線)
+//   div_df = exp(-q T)                    連續股利折現
+//   div_pv = sum_{0 < t_i <= T} D_i df(t_i)   現金股利現值 (escrowed dividend：從 spot 扣掉)
+// 遠期價 F = (S - div_pv) * div_df / df，選擇權價 = df * Black76(F, K, sigma, T) (butterfly_pricing.h)。
+// 這些因子在行情 (曲線 / 股利) 更新時每個到期日算一次 (OptionLegStore 內以到期日快取)，
+// 所有腿、所有 spot 格點共用；逐點只剩 log / N(x)，不再有 exp。
+// 情境往後推 dt 年 (風險階梯、到期衰減) 用 rolled(dt)：折現改成從 dt 起算的遠期，已除息的股利不再扣。
+// 只依賴標準函式庫 (CLI 工具也可以用)。
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// 零息利率曲線：節點 (t 年, 連續複利零息利率)，在 r*t (= -ln DF) 上線性內插，兩端平外插利率
+struct ZeroCurve
+{
+    std::vector<double> times;   // 遞增
+    std::vector<double> rates;
+    double origin = 0.0;         // 起算時間 (年)；> 0 時 rate_at(t) 是 [origin, origin + t] 的遠期利率
+
+    void add_pillar(double t, double r)
+    {
+        const auto it = std::upper_bound(times.begin(), times.end(), t);
+        const std::size_t i = (std::size_t)(it - times.begin());
+        times.insert(it, t);
+        rates.insert(rates.begin() + (std::ptrdiff_t)i, r);
+    }
+
+    double rate_at(double t) const
+    {
+        if (origin <= 0.0)
+            return spot_rate(t);
+        if (t <= 0.0)
+            return spot_rate(origin);
+        return (spot_rate(origin + t) * (origin + t) - spot_rate(origin) * origin) / t;
+    }
+
+    double discount(double t) const { return t > 0.0 ? std::exp(-rate_at(t) * t) : 1.0; }
+
+private:
+    double spot_rate(double t) const
+    {
+        if (times.empty())
+            return 0.0;
+        if (t <= times.front())
+            return rates.front();
+        if (t >= times.back())
+            return rates.back();
+        const std::size_t i = (std::size_t)(std::upper_bound(times.begin(), times.end(), t) - times.begin());
+        const double t0 = times[i - 1], t1 = times[i];
+        const double rt0 = rates[i - 1] * t0, rt1 = rates[i] * t1;
+        return (rt0 + (rt1 - rt0) * (t - t0) / (t1 - t0)) / t;
+    }
+};
+
+struct CashDividend
+{
+    double time;     // 除息時間 (年，從現在起算)
+    double amount;   // 每股金額
+};
+
+struct DividendSchedule
+{
+    double yield = 0.0;               // 連續股利率 (小數)
+    std::vector<CashDividend> cash;   // 依時間排序
+};
+
+// 一個到期日的折現 / 遠期因子
+struct ExpiryFactors
+{
+    double T = 0.0;
+    double df = 1.0;
+    double div_df = 1.0;
+    double div_pv = 0.0;
+    double carry_t = 0.0;   // (r(T) - q) T = ln(F / (S - div_pv))
+
+    double forward(double S) const { return (S - div_pv) * div_df / df; }
+};
+
+class MarketCurves
+{
+public:
+    ZeroCurve rates;
+    DividendSchedule dividends;
+
+    static std::shared_ptr<const MarketCurves> Flat(double r, double q = 0.0)
+    {
+        auto c = std::make_shared<MarketCurves>();
+        c->rates.add_pillar(1.0, r);
+        c->dividends.yield = q;
+        return c;
+    }
+
+    void add_cash_dividend(double t, double amount)
+    {
+        auto& cash = dividends.cash;
+        const auto it = std::upper_bound(cash.begin(), cash.end(), t, [](double v, const CashDividend& d) { return v < d.time; });
+        cash.insert(it, { t, amount });
+    }
+
+    // dt 年後看到的曲線：零息曲線從 dt 起算，dt 之前 (含) 除息的現金股利丟掉、其餘除息時間減 dt
+    std::shared_ptr<const MarketCurves> rolled(double dt) const
+    {
+        auto c = std::make_shared<MarketCurves>(*this);
+        if (dt <= 0.0)
+            return c;
+        c->rates.origin += dt;
+        c->dividends.cash.clear();
+        for (const CashDividend& d : dividends.cash)
+            if (d.time > dt)
+                c->dividends.cash.push_back({ d.time - dt, d.amount });
+        return c;
+    }
+
+    ExpiryFactors factors(double T) const
+    {
+        ExpiryFactors f;
+        f.T = T;
+        if (T <= 0.0)
+            return f;
+        const double rt = rates.rate_at(T) * T;
+        const double qt = dividends.yield * T;
+        f.df = std::exp(-rt);
+        f.div_df = std::exp(-qt);
+        f.carry_t = rt - qt;
+        for (const CashDividend& d : dividends.cash)
+        {
+            if (d.time > T)
+                break;
+            if (d.time > 0.0)
+                f.div_pv += d.amount * rates.discount(d.time);
+        }
+        return f;
+    }
+};
@@ -0,0 +1,368 @@
+// memory_tracker.h - 依子系統 (tag) 統計記憶體：ImGui / ImPlot / SDL 的配置 hook + app 緩衝區的 tagged allocator
+//
+// 每塊配置前面多 16 bytes 標頭記下大小與 tag，free / realloc 時不需要查表。
+// 計數器放在每個執行緒自己的 slot (cache line 對齊)，只做 relaxed fetch_add，不會和其他執行緒搶同一條
+// cache line；讀取端 (面板、dump、/metrics) 把所有 slot 加總。跨執行緒釋放時單一 slot 的 live 可能為負，
+// 加總後正確。峰值是取樣值：每幀 (MemoryPanel::Sample) 與每次讀取時更新。
+//   - ImGui：ImGui::SetAllocatorFunctions；ImPlot 沒有自己的 hook，走 ImGui 的配置器，
+//     在 MemTagScope(MemTag_ImPlot) 範圍內的配置 (BeginPlot..EndPlot、CreateContext) 記到 ImPlot
+//   - SDL：SDL_SetMemoryFunctions，只看得到 SDL 自己的 CPU 端配置，驅動程式 / VRAM 不在內
+//   - App：TaggedVector<T, Tag> 取代 std::vector
+// InstallMemoryTracking() 必須在任何 SDL / ImGui 配置之前呼叫 (main 第一行)。
+#pragma once
+
+#include "imgui.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+enum MemTag : int
+{
+    MemTag_ImGui = 0,
+    MemTag_ImPlot,
+    MemTag_SDL,
+    MemTag_Curves,     // T+0 / 到期曲線、高解析曲線
+    MemTag_Surfaces,   // 衰減曲面、風險階梯矩陣
+    MemTag_Pricing,    // 儀表板定價服務的結果
+    MemTag_Snapshot,   // session 快照映像
+    MemTag_COUNT
+};
+
+static const char* MemTagName(MemTag tag)
+{
+    static const char* names[MemTag_COUNT] = { "imgui", "implot", "sdl", "curves", "surfaces", "pricing", "snapshot" };
+    return (tag >= 0 && tag < MemTag_COUNT) ? names[tag] : "?";
+}
+
+// ----------------------------- 每執行緒計數器 -----------------------------
+struct alignas(64) MemCounterSlot
+{
+    std::atomic<bool> owned{ false };
+    std::atomic<std::int64_t> live_bytes[MemTag_COUNT] = {};
+    std::atomic<std::uint64_t> alloc_count[MemTag_COUNT] = {};
+    std::atomic<std::uint64_t> alloc_bytes[MemTag_COUNT] = {};
+};
+
+struct MemTrackerState
+{
+    // slot 0 共用：執行緒超過 kSlots 或已在結束中時使用 (fetch_add 一樣正確，只是會互搶)
+    static constexpr int kSlots = 64;
+    MemCounterSlot slots[kSlots];
+    std::atomic<int> used_slots{ 1 };
+    std::atomic<std::int64_t> peak_bytes[MemTag_COUNT] = {};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+// 刻意不釋放：程式結束時 SDL / ImGui 仍可能透過 hook 釋放記憶體
+inline MemTrackerState& GetMemTrackerState()
+{
+    static MemTrackerState* state = new MemTrackerState;
+    return *state;
+}
+
+inline thread_local MemCounterSlot* t_mem_slot = nullptr;
+inline thread_local MemTag t_mem_scope_tag = MemTag_ImGui;
+
+// 執行緒結束時把 slot 還回去 (計數是累計值，下一個執行緒接著用不影響加總)
+struct MemSlotReleaser
+{
+    ~MemSlotReleaser()
+    {
+        MemTrackerState& s = GetMemTrackerState();
+        if (t_mem_slot && t_mem_slot != &s.slots[0])
+            t_mem_slot->owned.store(false, std::memory_order_release);
+        t_mem_slot = &s.slots[0];
+    }
+};
+
+inline MemCounterSlot& AcquireMemSlot()
+{
+    MemTrackerState& s = GetMemTrackerState();
+    static thread_local MemSlotReleaser releaser;
+    (void)releaser;
+    for (int i = 1; i < MemTrackerState::kSlots; ++i)
+    {
+        bool expected = false;
+        if (!s.slots[i].owned.load(std::memory_order_relaxed) &&
+            s.slots[i].owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            int used = s.used_slots.load(std::memory_order_relaxed);
+            while (used < i + 1 && !s.used_slots.compare_exchange_weak(used, i + 1, std::memory_order_relaxed)) {}
+            return *(t_mem_slot = &s.slots[i]);
+        }
+    }
+    return *(t_mem_slot = &s.slots[0]);
+}
+
+inline MemCounterSlot& LocalMemSlot()
+{
+    MemCounterSlot* slot = t_mem_slot;
+    return slot ? *slot : AcquireMemSlot();
+}
+
+// ----------------------------- 配置 / 釋放 -----------------------------
+struct MemBlockHeader
+{
+    std::uint64_t size;
+    std::uint32_t tag;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(MemBlockHeader) == 16, "標頭必須維持 malloc 的 16-byte 對齊");
+
+inline void* TrackedAlloc(std::size_t size, MemTag tag)
+{
+    MemBlockHeader* h = (MemBlockHeader*)malloc(size + sizeof(MemBlockHeader));
+    if (!h)
+        return nullptr;
+    h->size = size;
+    h->tag = (std::uint32_t)tag;
+    MemCounterSlot& slot = LocalMemSlot();
+    slot.live_bytes[tag].fetch_add((std::int64_t)size, std::memory_order_relaxed);
+    slot.alloc_count[tag].fetch_add(1, std::memory_order_relaxed);
+    slot.alloc_bytes[tag].fetch_add(size, std::memory_order_relaxed);
+    return h + 1;
+}
+
+inline void TrackedFree(void* ptr)
+{
+    if (!ptr)
+        return;
+    MemBlockHeader* h = (MemBlockHeader*)ptr - 1;
+    LocalMemSlot().live_bytes[h->tag].fetch_sub((std::int64_t)h->size, std::memory_order_relaxed);
+    free(h);
+}
+
+// 大小變化算一次配置；tag 沿用原本那塊的
+inline void* TrackedRealloc(void* ptr, std::size_t size, MemTag tag)
+{
+    if (!ptr)
+        return TrackedAlloc(size, tag);
+    MemBlockHeader* h = (MemBlockHeader*)ptr - 1;
+    const std::uint64_t old_size = h->size;
+    const std::uint32_t old_tag = h->tag;
+    MemBlockHeader* n = (MemBlockHeader*)realloc(h, size + sizeof(MemBlockHeader));
+    if (!n)
+        return nullptr;
+    n->size = size;
+    MemCounterSlot& slot = LocalMemSlot();
+    slot.live_bytes[old_tag].fetch_add((std::int64_t)size - (std::int64_t)old_size, std::memory_order_relaxed);
+    slot.alloc_count[old_tag].fetch_add(1, std::memory_order_relaxed);
+    slot.alloc_bytes[old_tag].fetch_add(size, std::memory_order_relaxed);
+    return n + 1;
+}
+
+// 範圍內經 ImGui 配置器的配置記到指定 tag (例如 ImPlot)
+class MemTagScope
+{
+public:
+    explicit MemTagScope(MemTag tag) : prev_(t_mem_scope_tag) { t_mem_scope_tag = tag; }
+    ~MemTagScope() { t_mem_scope_tag = prev_; }
+    MemTagScope(const MemTagScope&) = delete;
+    MemTagScope& operator=(const MemTagScope&) = delete;
+
+private:
+    MemTag prev_;
+};
+
+// ----------------------------- 安裝 hook -----------------------------
+static void* ImGuiTrackedAlloc(size_t size, void*) { return TrackedAlloc(size, t_mem_scope_tag); }
+static void ImGuiTrackedFree(void* ptr, void*) { TrackedFree(ptr); }
+
+static void* SDLCALL SdlTrackedMalloc(size_t size) { return TrackedAlloc(size, MemTag_SDL); }
+static void* SDLCALL SdlTrackedCalloc(size_t count, size_t size)
+{
+    void* p = TrackedAlloc(count * size, MemTag_SDL);
+    if (p)
+        memset(p, 0, count * size);
+    return p;
+}
+static void* SDLCALL SdlTrackedRealloc(void* ptr, size_t size) { return TrackedRealloc(ptr, size, MemTag_SDL); }
+static void SDLCALL SdlTrackedFree(void* ptr) { TrackedFree(ptr); }
+
+static bool InstallMemoryTracking()
+{
+    ImGui::SetAllocatorFunctions(ImGuiTrackedAlloc, ImGuiTrackedFree, nullptr);
+    if (!SDL_SetMemoryFunctions(SdlTrackedMalloc, SdlTrackedCalloc, SdlTrackedRealloc, SdlTrackedFree))
+    {
+        printf("Warning: SDL_SetMemoryFunctions(): %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------- Tagged std allocator -----------------------------
+template <typename T, MemTag Tag>
+struct TaggedAllocator
+{
+    static_assert(alignof(T) <= 16, "TaggedAllocator 只保證 16-byte 對齊");
+    using value_type = T;
+    template <typename U>
+    struct rebind { using other = TaggedAllocator<U, Tag>; };
+
+    TaggedAllocator() noexcept = default;
+    template <typename U>
+    TaggedAllocator(const TaggedAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        void* p = TrackedAlloc(n * sizeof(T), Tag);
+        if (!p)
+            throw std::bad_alloc();
+        return (T*)p;
+    }
+    void deallocate(T* p, std::size_t) noexcept { TrackedFree(p); }
+
+    template <typename U>
+    bool operator==(const TaggedAllocator<U, Tag>&) const noexcept { return true; }
+};
+
+template <typename T, MemTag Tag>
+using TaggedVector = std::vector<T, TaggedAllocator<T, Tag>>;
+
+// 曲線座標 / 損益 (ImPlot、快照、共享記憶體都吃 .data())
+using CurveVector = TaggedVector<double, MemTag_Curves>;
+
+// ----------------------------- 讀取 -----------------------------
+struct MemTagStats
+{
+    std::int64_t live_bytes = 0;
+    std::int64_t peak_bytes = 0;
+    std::uint64_t alloc_count = 0;   // 累計
+    std::uint64_t alloc_bytes = 0;   // 累計
+};
+
+// 加總所有 slot，順便更新峰值；任何執行緒都可以呼叫
+static void ReadMemoryStats(MemTagStats out[MemTag_COUNT])
+{
+    MemTrackerState& s = GetMemTrackerState();
+    const int used = s.used_slots.load(std::memory_order_relaxed);
+    for (int t = 0; t < MemTag_COUNT; ++t)
+    {
+        MemTagStats st;
+        for (int i = 0; i < used; ++i)
+        {
+            st.live_bytes += s.slots[i].live_bytes[t].load(std::memory_order_relaxed);
+            st.alloc_count += s.slots[i].alloc_count[t].load(std::memory_order_relaxed);
+            st.alloc_bytes += s.slots[i].alloc_bytes[t].load(std::memory_order_relaxed);
+        }
+        std::int64_t peak = s.peak_bytes[t].load(std::memory_order_relaxed);
+        while (st.live_bytes > peak && !s.peak_bytes[t].compare_exchange_weak(peak, st.live_bytes, std::memory_order_relaxed)) {}
+        st.peak_bytes = std::max(peak, st.live_bytes);
+        out[t] = st;
+    }
+}
+
+// Dump API：目前值 + 從啟動到現在的平均配置率
+static void DumpMemoryStats(FILE* out)
+{
+    MemTagStats st[MemTag_COUNT];
+    ReadMemoryStats(st);
+    const double sec = std::max(1e-3, std::chrono::duration<double>(std::chrono::steady_clock::now() - GetMemTrackerState().start).count());
+    fprintf(out, "%-10s %14s %14s %14s %12s\n", "tag", "live bytes", "peak bytes", "allocs", "allocs/s");
+    for (int t = 0; t < MemTag_COUNT; ++t)
+        fprintf(out, "%-10s %14lld %14lld %14llu %12.1f\n", MemTagName((MemTag)t),
+            (long long)st[t].live_bytes, (long long)st[t].peak_bytes, (unsigned long long)st[t].alloc_count, st[t].alloc_count / sec);
+}
+
+// ----------------------------- 面板 -----------------------------
+class MemoryPanel
+{
+public:
+    // 每幀呼叫 (面板關閉時也要，峰值才不會漏)；配置率每秒更新一次
+    void Sample()
+    {
+        ReadMemoryStats(stats_);
+        const auto now = std::chrono::steady_clock::now();
+        const double dt = std::chrono::duration<double>(now - rate_time_).count();
+        if (dt < 1.0)
+            return;
+        for (int t = 0; t < MemTag_COUNT; ++t)
+        {
+            allocs_per_sec_[t] = (stats_[t].alloc_count - rate_count_[t]) / dt;
+            bytes_per_sec_[t] = (stats_[t].alloc_bytes - rate_bytes_[t]) / dt;
+            rate_count_[t] = stats_[t].alloc_count;
+            rate_bytes_[t] = stats_[t].alloc_bytes;
+        }
+        rate_time_ = now;
+    }
+
+    const MemTagStats& Stats(MemTag tag) const { return stats_[tag]; }
+    double AllocsPerSec(MemTag tag) const { return allocs_per_sec_[tag]; }
+    double BytesPerSec(MemTag tag) const { return bytes_per_sec_[tag]; }
+
+private:
+    MemTagStats stats_[MemTag_COUNT];
+    double allocs_per_sec_[MemTag_COUNT] = {};
+    double bytes_per_sec_[MemTag_COUNT] = {};
+    std::uint64_t rate_count_[MemTag_COUNT] = {};
+    std::uint64_t rate_bytes_[MemTag_COUNT] = {};
+    std::chrono::steady_clock::time_point rate_time_ = std::chrono::steady_clock::now();
+};
+
+static void FormatBytes(char* buf, std::size_t size, double bytes)
+{
+    if (bytes >= 1024.0 * 1024.0) snprintf(buf, size, "%.2f MB", bytes / (1024.0 * 1024.0));
+    else if (bytes >= 1024.0) snprintf(buf, size, "%.1f KB", bytes / 1024.0);
+    else snprintf(buf, size, "%.0f B", bytes);
+}
+
+static void DrawMemoryPanel(MemoryPanel& panel, bool* open)
+{
+    panel.Sample();
+    if (!*open)
+        return;
+    ImGui::SetNextWindowSize(ImVec2(560, 0), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("記憶體", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::BeginTable("##Memory", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("子系統");
+        ImGui::TableSetupColumn("使用中");
+        ImGui::TableSetupColumn("峰值");
+        ImGui::TableSetupColumn("配置/s");
+        ImGui::TableSetupColumn("配置量/s");
+        ImGui::TableHeadersRow();
+        std::int64_t total_live = 0, total_peak = 0;
+        char live[32], peak[32], rate[32];
+        for (int t = 0; t < MemTag_COUNT; ++t)
+        {
+            const MemTagStats& st = panel.Stats((MemTag)t);
+            total_live += st.live_bytes;
+            total_peak += st.peak_bytes;
+            FormatBytes(live, sizeof(live), (double)st.live_bytes);
+            FormatBytes(peak, sizeof(peak), (double)st.peak_bytes);
+            FormatBytes(rate, sizeof(rate), panel.BytesPerSec((MemTag)t));
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", MemTagName((MemTag)t));
+            ImGui::TableNextColumn(); ImGui::Text("%s", live);
+            ImGui::TableNextColumn(); ImGui::Text("%s", peak);
+            ImGui::TableNextColumn(); ImGui::Text("%.0f", panel.AllocsPerSec((MemTag)t));
+            ImGui::TableNextColumn(); ImGui::Text("%s", rate);
+        }
+        FormatBytes(live, sizeof(live), (double)total_live);
+        FormatBytes(peak, sizeof(peak), (double)total_peak);
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("合計");
+        ImGui::TableNextColumn(); ImGui::Text("%s", live);
+        ImGui::TableNextColumn(); ImGui::Text("(%s)", peak);
+        ImGui::EndTable();
+    }
+    ImGui::TextDisabled("峰值為每幀取樣；合計峰值是各子系統峰值相加。SDL 只含 CPU 端配置，不含 VRAM。");
+    if (ImGui::Button("輸出到 console"))
+        DumpMemoryStats(stdout);
+    ImGui::End();
+}
@@ -0,0 +1,441 @@
+// metrics_server.h - 內嵌的 localhost Prometheus metrics endpoint
+//
+// MetricsRegistry 全部是 atomic，render loop 每幀用 relaxed store / fetch_add 更新；
+// MetricsServer 在自己的執行緒 accept + 回應 GET /metrics，只讀這些 atomic，
+// 不碰 ImGui / SDL / 任何鎖，所以被 scrape 時 render loop 完全不受影響。
+// 只綁 127.0.0.1，由 --metrics-port N 開啟。
+//
+// Windows 上 winsock2.h 必須比 Windows.h 先 include，所以這個檔案要放在 session_snapshot.h /
+// curve_shm.h 之前。
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "imgui.h"
+#include "latest_wins.h"
+#include "pricing_service.h"
+#include "memory_tracker.h"
+
+#include <fmt/format.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+
+// ----------------------------- Registry (render loop 寫) -----------------------------
+// 主圖的背景定價工作 (ButterflyApp::curve_job / dense_job)
+enum MetricsJob
+{
+    MetricsJob_Curve = 0,
+    MetricsJob_Dense,
+    MetricsJob_COUNT
+};
+
+static inline const char* MetricsJobName(int job)
+{
+    return job == MetricsJob_Curve ? "curve" : "dense";
+}
+
+struct MetricsRegistry
+{
+    // frame time：0.25 ms 一格，最多 100 ms (最後一格含以上)
+    static constexpr int kFrameBuckets = 400;
+    static constexpr double kFrameBucketMs = 0.25;
+
+    const char* backend_name;
+    std::atomic<std::uint32_t> frame_buckets[kFrameBuckets] = {};
+    std::atomic<std::uint64_t> frames_total{ 0 };
+    std::atomic<std::uint64_t> frame_time_us_sum{ 0 };
+
+    std::atomic<std::uint64_t> pricing_requests{ 0 };
+    std::atomic<std::uint64_t> pricing_dedup_hits{ 0 };
+    std::atomic<std::uint64_t> pricing_computed{ 0 };
+    std::atomic<std::uint64_t> pricing_cache_entries{ 0 };
+    std::atomic<std::uint64_t> pricing_queued{ 0 };
+
+    struct JobCounters
+    {
+        std::atomic<std::uint64_t> submitted{ 0 };
+        std::atomic<std::uint64_t> completed{ 0 };
+        std::atomic<std::uint64_t> superseded{ 0 };
+        std::atomic<std::uint64_t> cancelled{ 0 };
+        std::atomic<std::uint64_t> last_us{ 0 };
+    };
+    JobCounters jobs[MetricsJob_COUNT];
+
+    std::atomic<std::int32_t> font_atlas_width{ 0 };
+    std::atomic<std::int32_t> font_atlas_height{ 0 };
+    std::atomic<std::int32_t> event_queue_depth{ 0 };
+
+    explicit MetricsRegistry(const char* backend) : backend_name(backend) {}
+
+    void RecordFrame(double frame_ms)
+    {
+        const int b = std::clamp((int)(frame_ms / kFrameBucketMs), 0, kFrameBuckets - 1);
+        frame_buckets[b].fetch_add(1, std::memory_order_relaxed);
+        frames_total.fetch_add(1, std::memory_order_relaxed);
+        frame_time_us_sum.fetch_add((std::uint64_t)(std::max(0.0, frame_ms) * 1000.0), std::memory_order_relaxed);
+    }
+
+    void SetPricingStats(const PricingService::Stats& st)
+    {
+        pricing_requests.store(st.requests, std::memory_order_relaxed);
+        pricing_dedup_hits.store(st.dedup_hits, std::memory_order_relaxed);
+        pricing_computed.store(st.computed, std::memory_order_relaxed);
+        pricing_cache_entries.store(st.entries, std::memory_order_relaxed);
+        pricing_queued.store(st.queued, std::memory_order_relaxed);
+    }
+
+    void SetJobStats(MetricsJob job, const LatestWinsStats& st)
+    {
+        JobCounters& c = jobs[job];
+        c.submitted.store(st.submitted, std::memory_order_relaxed);
+        c.completed.store(st.completed, std::memory_order_relaxed);
+        c.superseded.store(st.superseded, std::memory_order_relaxed);
+        c.cancelled.store(st.cancelled, std::memory_order_relaxed);
+        c.last_us.store((std::uint64_t)(st.last_ms * 1000.0), std::memory_order_relaxed);
+    }
+};
+
+// 每幀在 ImGui::NewFrame() 之後呼叫；event_queue_depth 由呼叫端在 poll 之前取得。
+// pricing 只有儀表板開著時才有；主圖的背景定價 (curve / dense) 一律收
+static inline void CollectFrameMetrics(MetricsRegistry& m, const ImGuiIO& io, int event_queue_depth, const PricingService* pricing,
+                                       const LatestWinsStats& curve_job, const LatestWinsStats& dense_job)
+{
+    m.RecordFrame(io.DeltaTime * 1000.0);
+#if IMGUI_VERSION_NUM >= 19200
+    // 1.92 起 atlas 尺寸在 TexData (動態 atlas 會長大)
+    const ImTextureData* tex = io.Fonts->TexData;
+    m.font_atlas_width.store(tex ? tex->Width : 0, std::memory_order_relaxed);
+    m.font_atlas_height.store(tex ? tex->Height : 0, std::memory_order_relaxed);
+#else
+    m.font_atlas_width.store(io.Fonts->TexWidth, std::memory_order_relaxed);
+    m.font_atlas_height.store(io.Fonts->TexHeight, std::memory_order_relaxed);
+#endif
+    m.event_queue_depth.store(event_queue_depth, std::memory_order_relaxed);
+    if (pricing)
+        m.SetPricingStats(pricing->GetStats());
+    m.SetJobStats(MetricsJob_Curve, curve_job);
+    m.SetJobStats(MetricsJob_Dense, dense_job);
+}
+
+// ----------------------------- HTTP server (自己的執行緒) -----------------------------
+class MetricsServer
+{
+public:
+    explicit MetricsServer(const MetricsRegistry& registry) : registry_(registry) {}
+    ~MetricsServer() { Stop(); }
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool Start(int port)
+    {
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        {
+            printf("Error: WSAStartup failed\n");
+            return false;
+        }
+        wsa_started_ = true;
+#endif
+        listen_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listen_ == kInvalidSocket)
+        {
+            printf("Error: metrics socket() failed\n");
+            return false;
+        }
+        int yes = 1;
+        setsockopt(listen_, SOL_SOCKET, SO_REUSEADDR, (const char*)&yes, sizeof(yes));
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((unsigned short)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listen_, (const sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_, 8) != 0)
+        {
+            printf("Error: cannot listen on 127.0.0.1:%d for metrics\n", port);
+            CloseSocket(listen_);
+            listen_ = kInvalidSocket;
+            return false;
+        }
+
+        stop_.store(false, std::memory_order_relaxed);
+        thread_ = std::thread([this] { ServeMain(); });
+        printf("Metrics: http://127.0.0.1:%d/metrics\n", port);
+        return true;
+    }
+
+    void Stop()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        if (thread_.joinable())
+            thread_.join();
+        if (listen_ != kInvalidSocket)
+            CloseSocket(listen_);
+        listen_ = kInvalidSocket;
+#ifdef _WIN32
+        if (wsa_started_)
+            WSACleanup();
+        wsa_started_ = false;
+#endif
+    }
+
+    bool Running() const { return thread_.joinable(); }
+    std::uint64_t Scrapes() const { return scrapes_.load(std::memory_order_relaxed); }
+
+private:
+#ifdef _WIN32
+    using Socket = SOCKET;
+    static constexpr Socket kInvalidSocket = INVALID_SOCKET;
+    static void CloseSocket(Socket s) { closesocket(s); }
+    static int PollOne(Socket s, int timeout_ms)
+    {
+        WSAPOLLFD p = { s, POLLRDNORM, 0 };
+        return WSAPoll(&p, 1, timeout_ms);
+    }
+    bool wsa_started_ = false;
+#else
+    using Socket = int;
+    static constexpr Socket kInvalidSocket = -1;
+    static void CloseSocket(Socket s) { close(s); }
+    static int PollOne(Socket s, int timeout_ms)
+    {
+        pollfd p = { s, POLLIN, 0 };
+        return poll(&p, 1, timeout_ms);
+    }
+#endif
+
+    const MetricsRegistry& registry_;
+    Socket listen_ = kInvalidSocket;
+    std::thread thread_;
+    std::atomic<bool> stop_{ false };
+    std::atomic<std::uint64_t> scrapes_{ 0 };
+
+    // 上一次 scrape 時的 frame 直方圖，用來算「兩次 scrape 之間」的百分位數
+    std::uint32_t last_buckets_[MetricsRegistry::kFrameBuckets] = {};
+    fmt::memory_buffer body_;
+
+    void ServeMain()
+    {
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            // 每 200 ms 醒來檢查一次 stop，不需要額外的喚醒機制
+            if (PollOne(listen_, 200) <= 0)
+                continue;
+            const Socket client = accept(listen_, nullptr, nullptr);
+            if (client == kInvalidSocket)
+                continue;
+            HandleClient(client);
+            CloseSocket(client);
+        }
+    }
+
+    void HandleClient(Socket client)
+    {
+        char req[1024];
+        int len = 0;
+        // 只需要 request line；讀到第一個換行或 buffer 滿就停
+        while (len < (int)sizeof(req) - 1 && PollOne(client, 1000) > 0)
+        {
+            const int n = (int)recv(client, req + len, (int)sizeof(req) - 1 - len, 0);
+            if (n <= 0)
+                break;
+            len += n;
+            req[len] = '\0';
+            if (strchr(req, '\n'))
+                break;
+        }
+        req[len] = '\0';
+
+        const bool is_get = strncmp(req, "GET ", 4) == 0;
+        const bool is_metrics = is_get && (strncmp(req + 4, "/metrics ", 9) == 0 || strncmp(req + 4, "/metrics?", 9) == 0);
+        if (is_metrics)
+        {
+            BuildMetrics();
+            scrapes_.fetch_add(1, std::memory_order_relaxed);
+            SendResponse(client, "200 OK", "text/plain; version=0.0.4; charset=utf-8", body_.data(), body_.size());
+        }
+        else
+        {
+            static const char kNotFound[] = "only /metrics is served\n";
+            SendResponse(client, is_get ? "404 Not Found" : "405 Method Not Allowed", "text/plain", kNotFound, sizeof(kNotFound) - 1);
+        }
+    }
+
+    static void SendAll(Socket s, const char* data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            const int n = (int)send(s, data, (int)std::min<std::size_t>(size, 1 << 20), 0);
+            if (n <= 0)
+                return;
+            data += n;
+            size -= (std::size_t)n;
+        }
+    }
+
+    static void SendResponse(Socket s, const char* status, const char* content_type, const char* body, std::size_t size)
+    {
+        char header[256];
+        const int n = snprintf(header, sizeof(header),
+            "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", status, content_type, size);
+        SendAll(s, header, (std::size_t)n);
+        SendAll(s, body, size);
+    }
+
+    void BuildMetrics()
+    {
+        const MetricsRegistry& m = registry_;
+        auto out = std::back_inserter(body_);
+        body_.clear();
+
+        fmt::format_to(out, "# HELP butterfly_backend_info Rendering backend of this visualizer.\n"
+            "# TYPE butterfly_backend_info gauge\nbutterfly_backend_info{{backend=\"{}\"}} 1\n", m.backend_name);
+
+        // frame time：累計直方圖 (Prometheus histogram) + 兩次 scrape 間的百分位數
+        std::uint32_t counts[MetricsRegistry::kFrameBuckets];
+        std::uint64_t window_total = 0;
+        for (int b = 0; b < MetricsRegistry::kFrameBuckets; ++b)
+        {
+            counts[b] = m.frame_buckets[b].load(std::memory_order_relaxed);
+            window_total += counts[b] - last_buckets_[b];
+        }
+        const std::uint64_t frames = m.frames_total.load(std::memory_order_relaxed);
+        const double sum_sec = m.frame_time_us_sum.load(std::memory_order_relaxed) / 1e6;
+
+        fmt::format_to(out, "# HELP butterfly_frame_time_seconds Frame time (ImGui DeltaTime).\n"
+            "# TYPE butterfly_frame_time_seconds histogram\n");
+        // le 只取內部格子的邊界 (以邊界索引表示，le = 索引 * 0.25 ms)，累計值才精確；
+        // 幀率門檻 8.33 / 11.1 / 16.7 / 33.3 ms 取其上方最近的邊界。
+        // 最後一格 (>= 99.75 ms) 沒有上界，只算進 +Inf
+        static constexpr int kLeEdges[] = { 4, 8, 16, 34, 45, 67, 80, 134, 200, MetricsRegistry::kFrameBuckets - 1 };
+        std::uint64_t cumulative = 0;
+        int b = 0;
+        for (int edge : kLeEdges)
+        {
+            for (; b < edge; ++b)
+                cumulative += counts[b];
+            fmt::format_to(out, "butterfly_frame_time_seconds_bucket{{le=\"{:g}\"}} {}\n",
+                edge * MetricsRegistry::kFrameBucketMs / 1000.0, cumulative);
+        }
+        // frames_total 比格子晚加一，relaxed 讀取時可能少算；+Inf 不能小於任何有限的 le
+        for (; b < MetricsRegistry::kFrameBuckets; ++b)
+            cumulative += counts[b];
+        const std::uint64_t count = std::max<std::uint64_t>(frames, cumulative);
+        fmt::format_to(out, "butterfly_frame_time_seconds_bucket{{le=\"+Inf\"}} {}\n"
+            "butterfly_frame_time_seconds_sum {}\nbutterfly_frame_time_seconds_count {}\n", count, sum_sec, count);
+
+        fmt::format_to(out, "# HELP butterfly_frame_time_ms_window Frame time percentiles since the previous scrape.\n"
+            "# TYPE butterfly_frame_time_ms_window gauge\n");
+        for (double q : { 0.5, 0.95, 0.99 })
+            fmt::format_to(out, "butterfly_frame_time_ms_window{{quantile=\"{}\"}} {}\n", q, WindowPercentile(counts, window_total, q));
+        memcpy(last_buckets_, counts, sizeof(counts));
+
+        const std::uint64_t requests = m.pricing_requests.load(std::memory_order_relaxed);
+        const std::uint64_t hits = m.pricing_dedup_hits.load(std::memory_order_relaxed);
+        fmt::format_to(out,
+            "# HELP butterfly_pricing_computed_total Curves priced by the shared pricing service (rate() = pricing calls/s).\n"
+            "# TYPE butterfly_pricing_computed_total counter\nbutterfly_pricing_computed_total {}\n"
+            "# HELP butterfly_pricing_requests_total Pricing requests from visible panels.\n"
+            "# TYPE butterfly_pricing_requests_total counter\nbutterfly_pricing_requests_total {}\n"
+            "# HELP butterfly_pricing_cache_hits_total Requests served from cache or an in-flight job.\n"
+            "# TYPE butterfly_pricing_cache_hits_total counter\nbutterfly_pricing_cache_hits_total {}\n"
+            "# HELP butterfly_pricing_cache_hit_ratio Cache hits / requests since start.\n"
+            "# TYPE butterfly_pricing_cache_hit_ratio gauge\nbutterfly_pricing_cache_hit_ratio {}\n"
+            "# HELP butterfly_pricing_cache_entries Cached pricing results.\n"
+            "# TYPE butterfly_pricing_cache_entries gauge\nbutterfly_pricing_cache_entries {}\n"
+            "# HELP butterfly_pricing_queue_depth Pricing jobs waiting for a worker.\n"
+            "# TYPE butterfly_pricing_queue_depth gauge\nbutterfly_pricing_queue_depth {}\n",
+            m.pricing_computed.load(std::memory_order_relaxed), requests, hits,
+            requests ? (double)hits / requests : 0.0,
+            m.pricing_cache_entries.load(std::memory_order_relaxed), m.pricing_queued.load(std::memory_order_relaxed));
+
+        // 主圖背景定價：rate(completed) = 實際上屏的定價次數，superseded / cancelled = 拖拉中省下的工作
+        static const char* const kJobCounters[][2] = {
+            { "submitted", "Main-chart pricing requests submitted to the latest-wins worker." },
+            { "completed", "Main-chart pricing jobs that finished and were delivered." },
+            { "superseded", "Main-chart pricing requests replaced before they started." },
+            { "cancelled", "Main-chart pricing jobs abandoned mid-run by a newer request." },
+        };
+        for (int c = 0; c < 4; ++c)
+        {
+            fmt::format_to(out, "# HELP butterfly_curve_jobs_{}_total {}\n# TYPE butterfly_curve_jobs_{}_total counter\n",
+                kJobCounters[c][0], kJobCounters[c][1], kJobCounters[c][0]);
+            for (int j = 0; j < MetricsJob_COUNT; ++j)
+            {
+                const MetricsRegistry::JobCounters& jc = m.jobs[j];
+                const std::atomic<std::uint64_t>* values[4] = { &jc.submitted, &jc.completed, &jc.superseded, &jc.cancelled };
+                fmt::format_to(out, "butterfly_curve_jobs_{}_total{{job=\"{}\"}} {}\n",
+                    kJobCounters[c][0], MetricsJobName(j), values[c]->load(std::memory_order_relaxed));
+            }
+        }
+        fmt::format_to(out, "# HELP butterfly_curve_job_last_seconds Compute time of the last delivered main-chart pricing job.\n"
+            "# TYPE butterfly_curve_job_last_seconds gauge\n");
+        for (int j = 0; j < MetricsJob_COUNT; ++j)
+            fmt::format_to(out, "butterfly_curve_job_last_seconds{{job=\"{}\"}} {}\n",
+                MetricsJobName(j), m.jobs[j].last_us.load(std::memory_order_relaxed) / 1e6);
+
+        // 各子系統記憶體 (memory_tracker.h)；rate(butterfly_memory_allocations_total) = 配置率
+        MemTagStats mem[MemTag_COUNT];
+        ReadMemoryStats(mem);
+        fmt::format_to(out, "# HELP butterfly_memory_live_bytes Live heap bytes per subsystem.\n# TYPE butterfly_memory_live_bytes gauge\n");
+        for (int t = 0; t < MemTag_COUNT; ++t)
+            fmt::format_to(out, "butterfly_memory_live_bytes{{tag=\"{}\"}} {}\n", MemTagName((MemTag)t), mem[t].live_bytes);
+        fmt::format_to(out, "# HELP butterfly_memory_peak_bytes Sampled peak of live heap bytes per subsystem.\n# TYPE butterfly_memory_peak_bytes gauge\n");
+        for (int t = 0; t < MemTag_COUNT; ++t)
+            fmt::format_to(out, "butterfly_memory_peak_bytes{{tag=\"{}\"}} {}\n", MemTagName((MemTag)t), mem[t].peak_bytes);
+        fmt::format_to(out, "# HELP butterfly_memory_allocations_total Heap allocations per subsystem.\n# TYPE butterfly_memory_allocations_total counter\n");
+        for (int t = 0; t < MemTag_COUNT; ++t)
+            fmt::format_to(out, "butterfly_memory_allocations_total{{tag=\"{}\"}} {}\n", MemTagName((MemTag)t), mem[t].alloc_count);
+        fmt::format_to(out, "# HELP butterfly_memory_allocated_bytes_total Heap bytes allocated per subsystem.\n# TYPE butterfly_memory_allocated_bytes_total counter\n");
+        for (int t = 0; t < MemTag_COUNT; ++t)
+            fmt::format_to(out, "butterfly_memory_allocated_bytes_total{{tag=\"{}\"}} {}\n", MemTagName((MemTag)t), mem[t].alloc_bytes);
+
+        const std::int32_t fw = m.font_atlas_width.load(std::memory_order_relaxed);
+        const std::int32_t fh = m.font_atlas_height.load(std::memory_order_relaxed);
+        fmt::format_to(out,
+            "# HELP butterfly_font_atlas_pixels Font atlas texture size.\n# TYPE butterfly_font_atlas_pixels gauge\n"
+            "butterfly_font_atlas_pixels{{dim=\"width\"}} {}\nbutterfly_font_atlas_pixels{{dim=\"height\"}} {}\n"
+            "# HELP butterfly_font_atlas_bytes Font atlas texture size in bytes (RGBA32).\n# TYPE butterfly_font_atlas_bytes gauge\n"
+            "butterfly_font_atlas_bytes {}\n"
+            "# HELP butterfly_event_queue_depth SDL events queued at the start of the last frame.\n"
+            "# TYPE butterfly_event_queue_depth gauge\nbutterfly_event_queue_depth {}\n"
+            "# HELP butterfly_metrics_scrapes_total Scrapes served.\n# TYPE butterfly_metrics_scrapes_total counter\n"
+            "butterfly_metrics_scrapes_total {}\n",
+            fw, fh, (std::int64_t)fw * fh * 4, m.event_queue_depth.load(std::memory_order_relaxed),
+            scrapes_.load(std::memory_order_relaxed) + 1);
+    }
+
+    double WindowPercentile(const std::uint32_t* counts, std::uint64_t total, double p) const
+    {
+        if (total == 0)
+            return 0.0;
+        const std::uint64_t target = (std::uint64_t)(p * (total - 1)) + 1;
+        std::uint64_t acc = 0;
+        for (int b = 0; b < MetricsRegistry::kFrameBuckets; ++b)
+        {
+            acc += counts[b] - last_buckets_[b];
+            if (acc >= target)
+                return (b + 0.5) * MetricsRegistry::kFrameBucketMs;
+        }
+        return MetricsRegistry::kFrameBuckets * MetricsRegistry::kFrameBucketMs;
+    }
+};
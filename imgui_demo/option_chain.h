@@ -0,0 +1,563 @@
+// option_chain.h - 欄式選擇權鏈二進位檔 (mmap 讀取，零反序列化)
+//
+// 檔案格式 (native endian)：
+//   ChainFileHeader
+//   ChainSection[ChainSection_COUNT]
+//   各 section 資料 (每段 8-byte 對齊)
+//
+// 報價依 (timestamp, underlying, expiry, strike, type) 排序，同一個 (timestamp, underlying, expiry)
+// 為一個 ChainGroup。逐列欄位各自連續存放：
+//   StrikeDelta  u16  與同組前一列的履約價差 (單位 strike_tick)；每組第一列為 0，基準在 ChainGroup。
+//                     差距放不進 u16 時寫 kChainStrikeEscape，該列的履約價 (絕對 tick) 依序放在 StrikeEscape
+//                     (i64)；ChainGroup::first_escape 是該組第一筆 escape 的位置
+//   Type         u8   0 = Call, 1 = Put (與 OptionType 相同)
+//   Bid/Ask/IV   f32  IV 為小數
+//   OI           u32
+// 標的代號存成字典 (Symbols)，群組只記編號；Dates 是「日期 -> 群組範圍」的索引，
+// 群組本身依 key 排序，可以二分搜尋到某日某到期日。
+// 開檔只做 mmap + 檢查 header / section table / 索引範圍，欄位指標直接指進映射記憶體；checksum 驗證是選擇性的。
+#pragma once
+
+#include "mapped_file.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+static constexpr char kChainMagic[8] = { 'B', 'F', 'L', 'Y', 'C', 'H', 'N', '1' };
+static constexpr std::uint32_t kChainVersion = 2;
+static constexpr std::uint16_t kChainStrikeEscape = 0xFFFF;
+static constexpr double kChainStrikeResolution = 0.001;   // 履約價先量化到 0.001，再取所有履約價的最大公因數當 tick
+
+enum ChainSectionId : std::uint32_t
+{
+    ChainSection_Symbols = 0,      // u32 count, u32 offsets[count + 1], 字元
+    ChainSection_Dates = 1,        // ChainDateEntry[date_count]
+    ChainSection_Groups = 2,       // ChainGroup[group_count]
+    ChainSection_StrikeDelta = 3,
+    ChainSection_Type = 4,
+    ChainSection_Bid = 5,
+    ChainSection_Ask = 6,
+    ChainSection_IV = 7,
+    ChainSection_OI = 8,
+    ChainSection_StrikeEscape = 9, // i64[escape_count]，履約價 (絕對 tick)
+    ChainSection_COUNT = 10
+};
+
+struct ChainFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t section_count;
+    std::uint64_t file_size;
+    std::uint64_t row_count;
+    std::uint32_t group_count;
+    std::uint32_t date_count;
+    std::uint32_t symbol_count;
+    std::uint32_t escape_count;  // StrikeEscape 筆數
+    double strike_tick;
+};
+
+struct ChainSection
+{
+    std::uint32_t id;
+    std::uint32_t checksum;   // FNV-1a，涵蓋 [offset, offset + size)
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+struct ChainGroup
+{
+    std::int64_t timestamp;      // Unix 秒 (UTC)
+    std::int32_t expiry_day;     // 1970-01-01 起的天數
+    std::uint32_t underlying;    // Symbols 編號
+    std::uint64_t first_row;
+    std::uint32_t row_count;
+    std::uint32_t first_escape;  // 該組第一筆 StrikeEscape 的位置
+    std::int64_t base_strike;    // 第一列履約價 (單位 strike_tick)
+};
+
+struct ChainDateEntry
+{
+    std::int32_t day;            // timestamp 所在的 UTC 日
+    std::uint32_t first_group;
+    std::uint32_t group_count;
+    std::uint32_t reserved;
+};
+
+// 一列報價 (寫入端輸入，也是讀取端逐列解碼的結果)
+struct ChainQuote
+{
+    std::int64_t timestamp = 0;
+    std::int32_t expiry_day = 0;
+    std::uint32_t underlying = 0;
+    double strike = 0.0;
+    std::uint8_t type = 0;
+    float bid = 0.0f;
+    float ask = 0.0f;
+    float iv = 0.0f;
+    std::uint32_t oi = 0;
+};
+
+static inline std::uint32_t chain_checksum(const std::uint8_t* p, std::size_t n)
+{
+    std::uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline std::size_t chain_align8(std::size_t n)
+{
+    return (n + 7) & ~(std::size_t)7;
+}
+
+static inline std::int32_t chain_day_of(std::int64_t timestamp)
+{
+    return (std::int32_t)(timestamp >= 0 ? timestamp / 86400 : (timestamp - 86399) / 86400);
+}
+
+// 1970-01-01 起的天數 -> 公曆日期 (Howard Hinnant 的 civil_from_days)
+static inline void chain_civil_from_days(std::int64_t z, int& y, unsigned& m, unsigned& d)
+{
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)(yoe + era * 400 + (m <= 2));
+}
+
+// ----------------------------- Writer -----------------------------
+// 收集報價後一次排序、分組、編碼並寫檔。轉檔用，不追求增量寫入。
+class OptionChainBuilder
+{
+public:
+    std::uint32_t SymbolId(std::string_view symbol)
+    {
+        auto it = symbol_ids_.find(std::string(symbol));
+        if (it != symbol_ids_.end())
+            return it->second;
+        const std::uint32_t id = (std::uint32_t)symbols_.size();
+        symbols_.emplace_back(symbol);
+        symbol_ids_.emplace(symbols_.back(), id);
+        return id;
+    }
+
+    void Add(const ChainQuote& q) { quotes_.push_back(q); }
+    std::size_t size() const { return quotes_.size(); }
+    void reserve(std::size_t n) { quotes_.reserve(n); }
+
+    bool Write(const char* path)
+    {
+        // 1. 履約價量化；tick = 所有履約價的最大公因數
+        std::vector<std::int64_t> q_strike(quotes_.size());
+        std::int64_t g = 0;
+        for (std::size_t i = 0; i < quotes_.size(); ++i)
+        {
+            q_strike[i] = std::llround(quotes_[i].strike / kChainStrikeResolution);
+            g = std::gcd(g, q_strike[i]);
+        }
+        if (g == 0) g = 1;
+
+        // 2. 排序 (只排索引，報價本身不搬)
+        std::vector<std::uint32_t> order(quotes_.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            const ChainQuote& x = quotes_[a];
+            const ChainQuote& y = quotes_[b];
+            if (x.timestamp != y.timestamp) return x.timestamp < y.timestamp;
+            if (x.underlying != y.underlying) return symbols_[x.underlying] < symbols_[y.underlying];
+            if (x.expiry_day != y.expiry_day) return x.expiry_day < y.expiry_day;
+            if (q_strike[a] != q_strike[b]) return q_strike[a] < q_strike[b];
+            return x.type < y.type;
+        });
+
+        // 3. 分組 + 逐列欄位
+        const std::size_t n = order.size();
+        std::vector<ChainGroup> groups;
+        std::vector<ChainDateEntry> dates;
+        std::vector<std::uint16_t> strike_delta(n);
+        std::vector<std::int64_t> strike_escape;
+        std::vector<std::uint8_t> type(n);
+        std::vector<float> bid(n), ask(n), iv(n);
+        std::vector<std::uint32_t> oi(n);
+        std::int64_t prev_ticks = 0;
+        for (std::size_t r = 0; r < n; ++r)
+        {
+            const std::uint32_t i = order[r];
+            const ChainQuote& q = quotes_[i];
+            const std::int64_t ticks = q_strike[i] / g;
+            const bool new_group = groups.empty() || groups.back().timestamp != q.timestamp ||
+                groups.back().underlying != q.underlying || groups.back().expiry_day != q.expiry_day;
+            if (new_group)
+            {
+                ChainGroup grp = {};
+                grp.timestamp = q.timestamp;
+                grp.expiry_day = q.expiry_day;
+                grp.underlying = q.underlying;
+                grp.first_row = r;
+                grp.first_escape = (std::uint32_t)strike_escape.size();
+                grp.base_strike = ticks;
+                groups.push_back(grp);
+                strike_delta[r] = 0;
+
+                const std::int32_t day = chain_day_of(q.timestamp);
+                if (dates.empty() || dates.back().day != day)
+                    dates.push_back({ day, (std::uint32_t)(groups.size() - 1), 0, 0 });
+                dates.back().group_count++;
+            }
+            else
+            {
+                // 例如 100、100.001、200：tick 0.001 時 100 點的間距放不進 u16，改存絕對 tick
+                const std::int64_t delta = ticks - prev_ticks;
+                if (delta >= kChainStrikeEscape)
+                {
+                    strike_delta[r] = kChainStrikeEscape;
+                    strike_escape.push_back(ticks);
+                }
+                else
+                {
+                    strike_delta[r] = (std::uint16_t)delta;
+                }
+            }
+            prev_ticks = ticks;
+            groups.back().row_count++;
+            type[r] = q.type;
+            bid[r] = q.bid;
+            ask[r] = q.ask;
+            iv[r] = q.iv;
+            oi[r] = q.oi;
+        }
+
+        // 4. 字典
+        std::vector<std::uint8_t> dict;
+        {
+            std::vector<std::uint32_t> offs(symbols_.size() + 1, 0);
+            std::size_t chars = 0;
+            for (std::size_t s = 0; s < symbols_.size(); ++s)
+            {
+                offs[s] = (std::uint32_t)chars;
+                chars += symbols_[s].size();
+            }
+            offs[symbols_.size()] = (std::uint32_t)chars;
+            const std::uint32_t count = (std::uint32_t)symbols_.size();
+            dict.resize(4 + offs.size() * 4 + chars);
+            memcpy(dict.data(), &count, 4);
+            memcpy(dict.data() + 4, offs.data(), offs.size() * 4);
+            std::uint8_t* p = dict.data() + 4 + offs.size() * 4;
+            for (const std::string& s : symbols_)
+            {
+                memcpy(p, s.data(), s.size());
+                p += s.size();
+            }
+        }
+
+        // 5. 組出整份檔案
+        const std::pair<const void*, std::size_t> payload[ChainSection_COUNT] = {
+            { dict.data(), dict.size() },
+            { dates.data(), dates.size() * sizeof(ChainDateEntry) },
+            { groups.data(), groups.size() * sizeof(ChainGroup) },
+            { strike_delta.data(), n * sizeof(std::uint16_t) },
+            { type.data(), n },
+            { bid.data(), n * sizeof(float) },
+            { ask.data(), n * sizeof(float) },
+            { iv.data(), n * sizeof(float) },
+            { oi.data(), n * sizeof(std::uint32_t) },
+            { strike_escape.data(), strike_escape.size() * sizeof(std::int64_t) },
+        };
+        ChainSection table[ChainSection_COUNT];
+        std::size_t off = sizeof(ChainFileHeader) + sizeof(table);
+        for (std::uint32_t s = 0; s < ChainSection_COUNT; ++s)
+        {
+            table[s].id = s;
+            table[s].offset = off;
+            table[s].size = payload[s].second;
+            table[s].checksum = chain_checksum((const std::uint8_t*)payload[s].first, payload[s].second);
+            off += chain_align8(payload[s].second);
+        }
+
+        ChainFileHeader header = {};
+        memcpy(header.magic, kChainMagic, sizeof(kChainMagic));
+        header.version = kChainVersion;
+        header.section_count = ChainSection_COUNT;
+        header.file_size = off;
+        header.row_count = n;
+        header.group_count = (std::uint32_t)groups.size();
+        header.date_count = (std::uint32_t)dates.size();
+        header.symbol_count = (std::uint32_t)symbols_.size();
+        header.escape_count = (std::uint32_t)strike_escape.size();
+        header.strike_tick = g * kChainStrikeResolution;
+
+        // 先寫暫存檔再改名，避免寫到一半的檔案蓋掉舊檔
+        const std::string tmp = std::string(path) + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f)
+        {
+            printf("Error: cannot write %s\n", tmp.c_str());
+            return false;
+        }
+        static const std::uint8_t zeros[8] = {};
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(table, sizeof(table), 1, f) == 1;
+        for (std::uint32_t s = 0; s < ChainSection_COUNT && ok; ++s)
+        {
+            const std::size_t pad = chain_align8(payload[s].second) - payload[s].second;
+            ok = (payload[s].second == 0 || fwrite(payload[s].first, payload[s].second, 1, f) == 1) &&
+                (pad == 0 || fwrite(zeros, pad, 1, f) == 1);
+        }
+        ok = (fclose(f) == 0) && ok;
+        remove(path);
+        if (!ok || rename(tmp.c_str(), path) != 0)
+        {
+            printf("Error: cannot write %s\n", path);
+            remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::vector<ChainQuote> quotes_;
+    std::vector<std::string> symbols_;
+    std::unordered_map<std::string, std::uint32_t> symbol_ids_;
+};
+
+// ----------------------------- Reader (mmap) -----------------------------
+class OptionChainFile
+{
+public:
+    OptionChainFile() = default;
+    OptionChainFile(const OptionChainFile&) = delete;
+    OptionChainFile& operator=(const OptionChainFile&) = delete;
+
+    // verify = true 時逐 section 驗 checksum (會讀過整份檔案)
+    bool Open(const char* path, bool verify = false)
+    {
+        Close();
+        if (!mf_.Open(path))
+        {
+            printf("Error: cannot open %s\n", path);
+            return false;
+        }
+        if (mf_.size < sizeof(ChainFileHeader) + ChainSection_COUNT * sizeof(ChainSection))
+            return Fail(path, "file too small");
+        header_ = (const ChainFileHeader*)mf_.data;
+        if (memcmp(header_->magic, kChainMagic, sizeof(kChainMagic)) != 0 || header_->version != kChainVersion ||
+            header_->section_count != ChainSection_COUNT || header_->file_size != mf_.size)
+            return Fail(path, "bad header or version");
+
+        const ChainSection* table = (const ChainSection*)(mf_.data + sizeof(ChainFileHeader));
+        const std::uint64_t n = header_->row_count;
+        if (n > mf_.size)   // 每列至少佔好幾個 byte；先擋掉讓下面的乘法溢位的值
+            return Fail(path, "bad row count");
+        const std::uint64_t expect[ChainSection_COUNT] = {
+            0, header_->date_count * (std::uint64_t)sizeof(ChainDateEntry), header_->group_count * (std::uint64_t)sizeof(ChainGroup),
+            n * sizeof(std::uint16_t), n, n * sizeof(float), n * sizeof(float), n * sizeof(float), n * sizeof(std::uint32_t),
+            header_->escape_count * (std::uint64_t)sizeof(std::int64_t)
+        };
+        for (std::uint32_t s = 0; s < ChainSection_COUNT; ++s)
+        {
+            const ChainSection& sec = table[s];
+            // offset + size 可能溢位，分開比
+            if (sec.id != s || (sec.offset & 7) != 0 || sec.offset > mf_.size || sec.size > mf_.size - sec.offset ||
+                (s != 0 && sec.size != expect[s]))
+                return Fail(path, "bad section table");
+            if (verify && chain_checksum(mf_.data + sec.offset, (std::size_t)sec.size) != sec.checksum)
+                return Fail(path, "checksum mismatch");
+        }
+
+        const std::uint8_t* dict = mf_.data + table[ChainSection_Symbols].offset;
+        if (table[ChainSection_Symbols].size < 4)
+            return Fail(path, "bad symbol dictionary");
+        std::uint32_t symbol_count;
+        memcpy(&symbol_count, dict, 4);
+        if (symbol_count != header_->symbol_count || 4 + (symbol_count + 1) * 4ull > table[ChainSection_Symbols].size)
+            return Fail(path, "bad symbol dictionary");
+        symbol_offsets_ = (const std::uint32_t*)(dict + 4);
+        symbol_chars_ = (const char*)(dict + 4 + (symbol_count + 1) * 4);
+        if (symbol_offsets_[symbol_count] > table[ChainSection_Symbols].size - 4 - (symbol_count + 1) * 4)
+            return Fail(path, "bad symbol dictionary");
+
+        dates_ = (const ChainDateEntry*)(mf_.data + table[ChainSection_Dates].offset);
+        groups_ = (const ChainGroup*)(mf_.data + table[ChainSection_Groups].offset);
+        strike_delta_ = (const std::uint16_t*)(mf_.data + table[ChainSection_StrikeDelta].offset);
+        type_ = mf_.data + table[ChainSection_Type].offset;
+        bid_ = (const float*)(mf_.data + table[ChainSection_Bid].offset);
+        ask_ = (const float*)(mf_.data + table[ChainSection_Ask].offset);
+        iv_ = (const float*)(mf_.data + table[ChainSection_IV].offset);
+        oi_ = (const std::uint32_t*)(mf_.data + table[ChainSection_OI].offset);
+        strike_escape_ = (const std::int64_t*)(mf_.data + table[ChainSection_StrikeEscape].offset);
+        for (std::uint32_t i = 0; i < header_->date_count; ++i)
+        {
+            const ChainDateEntry& d = dates_[i];
+            if ((std::uint64_t)d.first_group + d.group_count > header_->group_count)
+                return Fail(path, "bad date index");
+        }
+        for (std::uint32_t i = 0; i < header_->group_count; ++i)
+        {
+            const ChainGroup& g = groups_[i];
+            if (g.first_row > n || g.row_count > n - g.first_row || g.underlying >= symbol_count ||
+                g.first_escape > header_->escape_count)
+                return Fail(path, "bad group index");
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        mf_.Close();
+        header_ = nullptr;
+    }
+
+    bool is_open() const { return header_ != nullptr; }
+    std::size_t row_count() const { return header_ ? (std::size_t)header_->row_count : 0; }
+    std::size_t group_count() const { return header_ ? header_->group_count : 0; }
+    std::size_t date_count() const { return header_ ? header_->date_count : 0; }
+    std::size_t symbol_count() const { return header_ ? header_->symbol_count : 0; }
+    std::size_t file_size() const { return mf_.size; }
+    double strike_tick() const { return header_ ? header_->strike_tick : 0.0; }
+
+    std::string_view Symbol(std::uint32_t id) const
+    {
+        return std::string_view(symbol_chars_ + symbol_offsets_[id], symbol_offsets_[id + 1] - symbol_offsets_[id]);
+    }
+
+    // 找不到回傳 -1
+    int FindSymbol(std::string_view symbol) const
+    {
+        for (std::uint32_t s = 0; s < symbol_count(); ++s)
+            if (Symbol(s) == symbol)
+                return (int)s;
+        return -1;
+    }
+
+    // 欄位指標 (直接指向映射記憶體)
+    const ChainDateEntry* dates() const { return dates_; }
+    const ChainGroup* groups() const { return groups_; }
+    const std::uint16_t* strike_delta() const { return strike_delta_; }
+    const std::uint8_t* type() const { return type_; }
+    const float* bid() const { return bid_; }
+    const float* ask() const { return ask_; }
+    const float* iv() const { return iv_; }
+    const std::uint32_t* oi() const { return oi_; }
+
+    // 某一天 (UTC) 的群組範圍 [first, last)；沒有資料時 first == last
+    std::pair<const ChainGroup*, const ChainGroup*> GroupsOnDate(std::int32_t day) const
+    {
+        const ChainDateEntry* end = dates_ + date_count();
+        const ChainDateEntry* it = std::lower_bound(dates_, end, day,
+            [](const ChainDateEntry& e, std::int32_t d) { return e.day < d; });
+        if (it == end || it->day != day)
+            return { groups_, groups_ };
+        return { groups_ + it->first_group, groups_ + it->first_group + it->group_count };
+    }
+
+    // 該日該到期日最後一個時間點的群組 (日線資料就是唯一那組)；找不到回傳 nullptr
+    const ChainGroup* FindOnDate(std::int32_t day, std::uint32_t underlying, std::int32_t expiry_day) const
+    {
+        const auto range = GroupsOnDate(day);
+        for (const ChainGroup* g = range.second; g != range.first;)
+        {
+            --g;
+            if (g->underlying == underlying && g->expiry_day == expiry_day)
+                return g;
+        }
+        return nullptr;
+    }
+
+    // 精確 key 查詢 (群組依 timestamp, 標的代號, expiry 排序)
+    const ChainGroup* Find(std::int64_t timestamp, std::uint32_t underlying, std::int32_t expiry_day) const
+    {
+        const ChainGroup* end = groups_ + group_count();
+        const std::string_view sym = Symbol(underlying);
+        const ChainGroup* it = std::lower_bound(groups_, end, 0, [&](const ChainGroup& g, int) {
+            if (g.timestamp != timestamp) return g.timestamp < timestamp;
+            if (g.underlying != underlying) return Symbol(g.underlying) < sym;
+            return g.expiry_day < expiry_day;
+        });
+        if (it == end || it->timestamp != timestamp || it->underlying != underlying || it->expiry_day != expiry_day)
+            return nullptr;
+        return it;
+    }
+
+    // 解出一組的履約價 (前綴和，遇到 escape 換成絕對 tick)；out 至少 g.row_count 格
+    void DecodeStrikes(const ChainGroup& g, double* out) const
+    {
+        const double tick = strike_tick();
+        std::int64_t ticks = g.base_strike;
+        std::uint32_t escape = g.first_escape;
+        for (std::uint32_t i = 0; i < g.row_count; ++i)
+        {
+            ticks = NextStrike(ticks, strike_delta_[g.first_row + i], escape);
+            out[i] = ticks * tick;
+        }
+    }
+
+    // 逐列解碼一組，f(const ChainQuote&)
+    template <typename F>
+    void ForEachQuote(const ChainGroup& g, F&& f) const
+    {
+        const double tick = strike_tick();
+        std::int64_t ticks = g.base_strike;
+        std::uint32_t escape = g.first_escape;
+        ChainQuote q;
+        q.timestamp = g.timestamp;
+        q.expiry_day = g.expiry_day;
+        q.underlying = g.underlying;
+        for (std::uint64_t r = g.first_row; r < g.first_row + g.row_count; ++r)
+        {
+            ticks = NextStrike(ticks, strike_delta_[r], escape);
+            q.strike = ticks * tick;
+            q.type = type_[r];
+            q.bid = bid_[r];
+            q.ask = ask_[r];
+            q.iv = iv_[r];
+            q.oi = oi_[r];
+            f(q);
+        }
+    }
+
+private:
+    // escape 索引超出 (檔案損毀) 時沿用前一個履約價，不越界讀取
+    std::int64_t NextStrike(std::int64_t ticks, std::uint16_t delta, std::uint32_t& escape) const
+    {
+        if (delta != kChainStrikeEscape)
+            return ticks + delta;
+        return escape < header_->escape_count ? strike_escape_[escape++] : ticks;
+    }
+
+    bool Fail(const char* path, const char* why)
+    {
+        printf("Error: %s is not a valid chain file (%s)\n", path, why);
+        Close();
+        return false;
+    }
+
+    MappedFile mf_;
+    const ChainFileHeader* header_ = nullptr;
+    const std::uint32_t* symbol_offsets_ = nullptr;
+    const char* symbol_chars_ = nullptr;
+    const ChainDateEntry* dates_ = nullptr;
+    const ChainGroup* groups_ = nullptr;
+    const std::uint16_t* strike_delta_ = nullptr;
+    const std::uint8_t* type_ = nullptr;
+    const float* bid_ = nullptr;
+    const float* ask_ = nullptr;
+    const float* iv_ = nullptr;
+    const std::uint32_t* oi_ = nullptr;
+    const std::int64_t* strike_escape_ = nullptr;
+};
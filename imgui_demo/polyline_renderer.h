@@ -0,0 +1,231 @@
+// polyline_renderer.h - 大量點數曲線的繪製路徑 (取代 ImPlot 的 CPU 三角化)
+//
+// ImPlot::PlotLine / PlotShaded 每一段都在 CPU 上展開成 ImDrawList 三角形，
+// 200 點沒問題，幾十萬點以上就撐不住。這裡提供兩條路徑：
+//   - GPU：backend 有註冊 GpuPolylineBackend (目前是 OpenGL3，見 gl_polyline.h) 時，
+//          原始 x/y 只在資料變動時上傳一次，每幀只在 plot 的 ImDrawList 插入一個 callback，
+//          由 vertex shader 把每一段展開成粗線 / 填色四邊形。
+//   - CPU：其他 backend 依 plot 寬度做每像素欄 first/min/max/last 抽樣 (M4)，再交給 ImPlot，
+//          輸出點數只和像素寬度有關，與原始點數無關。
+//          SDL_Renderer 沒有 shader；SDL_GPU 需要每個 driver 各一份預先編好的 shader (SPIR-V / DXIL / MSL)，
+//          這個 demo 的建置沒有 shader 編譯流程，所以 SDL_GPU 目前也走這條路徑。
+// 點數少於 kDirectPoints 時兩條路徑都直接走 ImPlot，外觀和原本完全一樣。
+//
+// 同一份資料 (同樣的 xs / ys 指標) 的線與填色共用 backend 的一次上傳；
+// GPU 路徑在 ImPlot 要 auto-fit 的幀回報資料的 x / y 範圍，行為與 ImPlot::PlotLine 相同。
+// 限制：xs 必須遞增。
+#pragma once
+
+#include "imgui.h"
+#include "implot.h"
+#include "implot_internal.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 每幀的一筆 GPU 繪製命令 (plot 座標 / 螢幕座標都在 UI 建構時決定)
+struct PolylineDraw
+{
+    enum Mode { Line = 0, Fill = 1 };
+
+    int mode = Line;
+    ImVec4 color;
+    float thickness = 1.0f;          // 像素 (未乘 FramebufferScale)
+    double fill_ref = 0.0;           // Fill：填到這個 y
+    double x_min = 0.0, x_max = 1.0; // 目前的軸範圍
+    double y_min = 0.0, y_max = 1.0;
+    ImVec2 plot_pos, plot_size;      // plot 區域 (螢幕座標)
+    int first = 0, count = 0;        // 可見的點區間 [first, first + count)
+};
+
+class GpuPolylineBackend
+{
+public:
+    virtual ~GpuPolylineBackend() = default;
+    virtual void BeginFrame() = 0;
+    // 同一個 series (資料) 的 version 沒變就不重傳
+    virtual bool Upload(ImGuiID series, std::uint64_t version, const double* xs, const double* ys, int n) = 0;
+    // 在 draw_list 目前的位置插入繪製 callback
+    virtual void AddDraw(ImDrawList* draw_list, ImGuiID series, const PolylineDraw& draw) = 0;
+};
+
+class PolylineRenderer
+{
+public:
+    static constexpr int kDirectPoints = 4096;
+
+    void SetGpuBackend(GpuPolylineBackend* backend) { gpu_ = backend; }
+    bool HasGpuBackend() const { return gpu_ != nullptr; }
+
+    // 每幀 UI 開始時呼叫一次
+    void BeginFrame()
+    {
+        if (gpu_)
+            gpu_->BeginFrame();
+        if (bounds_.size() > 64)   // 資料重新配置後舊指標的項目不會再用到
+            bounds_.clear();
+    }
+
+    // 必須在 ImPlot::BeginPlot / EndPlot 之間呼叫；version 在 xs / ys 內容改變時遞增
+    void PlotLine(const char* label, const double* xs, const double* ys, int n, std::uint64_t version,
+        const ImVec4& color, float thickness)
+    {
+        ImPlot::SetNextLineStyle(color, thickness);
+        if (n <= kDirectPoints)
+        {
+            ImPlot::PlotLine(label, xs, ys, n);
+            return;
+        }
+        if (gpu_)
+        {
+            PolylineDraw d;
+            d.mode = PolylineDraw::Line;
+            d.color = color;
+            d.thickness = thickness;
+            SubmitGpu(label, xs, ys, n, version, d);
+            return;
+        }
+        const int m = Decimate(xs, ys, n);
+        ImPlot::PlotLine(label, dx_.data(), dy_.data(), m);
+    }
+
+    void PlotShaded(const char* label, const double* xs, const double* ys, int n, double ref, std::uint64_t version,
+        const ImVec4& color, float fill_alpha)
+    {
+        ImPlot::SetNextFillStyle(color, fill_alpha);
+        if (n <= kDirectPoints)
+        {
+            ImPlot::PlotShaded(label, xs, ys, n, ref);
+            return;
+        }
+        if (gpu_)
+        {
+            PolylineDraw d;
+            d.mode = PolylineDraw::Fill;
+            d.color = ImVec4(color.x, color.y, color.z, color.w * fill_alpha);
+            d.fill_ref = ref;
+            SubmitGpu(label, xs, ys, n, version, d);
+            return;
+        }
+        const int m = Decimate(xs, ys, n);
+        ImPlot::PlotShaded(label, dx_.data(), dy_.data(), m, ref);
+    }
+
+    // M4 抽樣：可見範圍內每個像素欄保留第一 / 最小 / 最大 / 最後一點 (依原始順序)，
+    // 兩端各多留一點讓線接到邊界外。回傳輸出點數，結果在 dx_ / dy_。
+    int Decimate(const double* xs, const double* ys, int n)
+    {
+        const ImPlotRect lim = ImPlot::GetPlotLimits();
+        const int columns = std::max(1, (int)ImPlot::GetPlotSize().x);
+        const double x0 = lim.X.Min, x1 = lim.X.Max;
+
+        int lo = (int)(std::lower_bound(xs, xs + n, x0) - xs);
+        int hi = (int)(std::upper_bound(xs, xs + n, x1) - xs);
+        lo = std::max(0, lo - 1);
+        hi = std::min(n, hi + 1);
+
+        dx_.resize((std::size_t)(columns + 2) * 4);   // 兩端超出範圍的點各佔一欄
+        dy_.resize(dx_.size());
+        int m = 0;
+        auto emit = [&](int i) {
+            if (m > 0 && dx_[m - 1] == xs[i] && dy_[m - 1] == ys[i]) return;
+            dx_[m] = xs[i];
+            dy_[m] = ys[i];
+            ++m;
+        };
+
+        const double scale = x1 > x0 ? columns / (x1 - x0) : 0.0;
+        int i = lo;
+        while (i < hi)
+        {
+            const int col = (int)std::clamp((xs[i] - x0) * scale, -1.0, (double)columns);
+            int first = i, last = i, i_min = i, i_max = i;
+            for (++i; i < hi && (int)std::clamp((xs[i] - x0) * scale, -1.0, (double)columns) == col; ++i)
+            {
+                last = i;
+                if (ys[i] < ys[i_min]) i_min = i;
+                if (ys[i] > ys[i_max]) i_max = i;
+            }
+            int idx[4] = { first, i_min, i_max, last };
+            std::sort(idx, idx + 4);
+            for (int k : idx)
+                emit(k);
+        }
+        return m;
+    }
+
+private:
+    // 每份資料的 y 範圍 (auto-fit 用)，version 變了才重算
+    struct DataBounds
+    {
+        std::uint64_t version = ~0ull;
+        int n = 0;
+        double y_min = 0.0, y_max = 0.0;
+    };
+
+    GpuPolylineBackend* gpu_ = nullptr;
+    std::vector<double> dx_, dy_;
+    std::unordered_map<ImGuiID, DataBounds> bounds_;
+
+    // 以資料指標當 series ID：同一份資料的 PlotShaded / PlotLine 只上傳一次
+    static ImGuiID DataId(const double* xs, const double* ys)
+    {
+        ImGui::PushID(xs);
+        const ImGuiID id = ImGui::GetID(ys);
+        ImGui::PopID();
+        return id;
+    }
+
+    void FitData(ImGuiID series, const double* xs, const double* ys, int n, std::uint64_t version, const PolylineDraw& d)
+    {
+        DataBounds& b = bounds_[series];
+        if (b.version != version || b.n != n)
+        {
+            const auto mm = std::minmax_element(ys, ys + n);
+            b.version = version;
+            b.n = n;
+            b.y_min = *mm.first;
+            b.y_max = *mm.second;
+        }
+        ImPlot::FitPoint(ImPlotPoint(xs[0], b.y_min));
+        ImPlot::FitPoint(ImPlotPoint(xs[n - 1], b.y_max));
+        if (d.mode == PolylineDraw::Fill)
+            ImPlot::FitPoint(ImPlotPoint(xs[0], d.fill_ref));
+    }
+
+    void SubmitGpu(const char* label, const double* xs, const double* ys, int n, std::uint64_t version, PolylineDraw& d)
+    {
+        // BeginItem 處理圖例 (顏色方塊、點圖例隱藏)；回傳 false = 使用者把這條線關掉了
+        if (!ImPlot::BeginItem(label, 0, d.mode == PolylineDraw::Line ? ImPlotCol_Line : ImPlotCol_Fill))
+            return;
+
+        const ImGuiID series = DataId(xs, ys);
+        if (ImPlot::FitThisFrame())
+            FitData(series, xs, ys, n, version, d);
+        if (gpu_->Upload(series, version, xs, ys, n))
+        {
+            const ImPlotRect lim = ImPlot::GetPlotLimits();
+            d.x_min = lim.X.Min; d.x_max = lim.X.Max;
+            d.y_min = lim.Y.Min; d.y_max = lim.Y.Max;
+            d.plot_pos = ImPlot::GetPlotPos();
+            d.plot_size = ImPlot::GetPlotSize();
+
+            // 只畫可見範圍 (前後各多一點)，平移 / 縮放時 GPU 工作量跟著變小
+            int lo = (int)(std::lower_bound(xs, xs + n, d.x_min) - xs);
+            int hi = (int)(std::upper_bound(xs, xs + n, d.x_max) - xs);
+            lo = std::max(0, lo - 1);
+            hi = std::min(n, hi + 1);
+            d.first = lo;
+            d.count = hi - lo;
+            if (d.count >= 2)
+            {
+                ImPlot::PushPlotClipRect();
+                gpu_->AddDraw(ImPlot::GetPlotDrawList(), series, d);
+                ImPlot::PopPlotClipRect();
+            }
+        }
+        ImPlot::EndItem();
+    }
+};
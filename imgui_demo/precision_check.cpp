@@ -0,0 +1,159 @@
+// precision_check.cpp - 驗證 float32 顯示曲線的誤差 (curve_precision.h)
+//
+// 用法:
+//   precision_check [--scenarios N] [--points N] [--height PX] [--max-px X] [--seed S]
+//
+// 隨機產生涵蓋 UI 範圍的蝶式情境 (spot、IV 1-150%、0-90 天、利率、間距、Call / Put，
+// 三分之一帶股利率與一筆到期前的現金股利)，
+// 每個情境以 float64 與 float32 各算一次 T+0 曲線，誤差換算成「圖上像素」：
+//   像素誤差 = max|y32 - y64| * 圖高 / y 軸範圍，y 軸範圍與 DrawButterflyApp 相同 (含 ±1 留白)
+// 同時確認 price_curve_as<double> 與 OptionLegStore::price_curve 一致 (開 FMA 時允許最後幾個位元不同)，
+// 並量兩種精度的吞吐量。
+// 最差情境超過 --max-px (預設 0.5 像素) 時回傳 1。
+
+#include "curve_precision.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+struct PrecisionCase
+{
+    double spot, iv_pct, days, rate_pct, strike_atm, width;
+    double yield_pct, cash_div;   // cash_div 在 days / 2 除息
+    bool put;
+};
+
+static void BuildLegs(const PrecisionCase& c, OptionLegStore& legs)
+{
+    const OptionType type = c.put ? OptionType::Put : OptionType::Call;
+    legs.clear();
+    legs.add_leg({ c.strike_atm - c.width, 0.0, type, 1.0, 0.0, 0.0 });
+    legs.add_leg({ c.strike_atm, 0.0, type, -2.0, 0.0, 0.0 });
+    legs.add_leg({ c.strike_atm + c.width, 0.0, type, 1.0, 0.0, 0.0 });
+    for (std::size_t i = 0; i < legs.size(); ++i)
+    {
+        legs.set_expiry(i, c.days / 365.0);
+        legs.set_vol(i, c.iv_pct / 100.0);
+        legs.set_rate(i, c.rate_pct / 100.0);
+    }
+    if (c.yield_pct > 0.0 || c.cash_div > 0.0)
+    {
+        auto curves = std::make_shared<MarketCurves>();
+        curves->rates.add_pillar(0.25, c.rate_pct / 100.0);
+        curves->rates.add_pillar(1.0, c.rate_pct / 100.0 + 0.005);
+        curves->dividends.yield = c.yield_pct / 100.0;
+        if (c.cash_div > 0.0)
+            curves->add_cash_dividend(c.days / 2.0 / 365.0, c.cash_div);
+        legs.set_curves(std::move(curves));
+    }
+    else
+    {
+        legs.set_curves(nullptr);
+    }
+    legs.set_spot(c.spot);
+}
+
+// ----------------------------- Main -----------------------------
+int main(int argc, char** argv)
+{
+    int n_cases = 20000;
+    int n_points = 2000;
+    double height_px = 500.0;
+    double max_px = 0.5;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--scenarios") == 0 && i + 1 < argc) n_cases = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) n_points = std::max(2, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) height_px = std::max(1.0, atof(argv[++i]));
+        else if (strcmp(argv[i], "--max-px") == 0 && i + 1 < argc) max_px = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned)atoi(argv[++i]);
+        else
+        {
+            printf("Usage: %s [--scenarios N] [--points N] [--height PX] [--max-px X] [--seed S]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> U(0.0, 1.0);
+    OptionLegStore legs;
+    std::vector<double> xs(n_points), y_exp(n_points), y_ref(n_points), y64(n_points), y32(n_points);
+    std::vector<double> errors;
+    errors.reserve(n_cases);
+    PrecisionCase worst = {};
+    double worst_px = 0.0, worst_abs = 0.0;
+    double max_f64_diff = 0.0;
+    double sec64 = 0.0, sec32 = 0.0;
+
+    for (int c = 0; c < n_cases; ++c)
+    {
+        PrecisionCase pc;
+        pc.spot = 5.0 + 495.0 * U(rng) * U(rng);
+        pc.iv_pct = 1.0 + 149.0 * U(rng) * U(rng);
+        pc.days = (c % 10 == 0) ? 0.0 : std::floor(1.0 + 90.0 * U(rng));
+        pc.rate_pct = 10.0 * U(rng);
+        pc.strike_atm = pc.spot * (0.8 + 0.4 * U(rng));
+        pc.width = std::max(0.1, pc.spot * 0.2 * U(rng));
+        pc.put = (c & 1) != 0;
+        pc.yield_pct = (c % 3 == 1) ? 3.0 * U(rng) : 0.0;
+        pc.cash_div = (c % 3 == 1 && pc.days > 0.0) ? pc.spot * 0.02 * U(rng) : 0.0;
+        BuildLegs(pc, legs);
+
+        const double cost = legs.total_value();
+        for (int i = 0; i < n_points; ++i)
+            xs[i] = pc.spot * (0.75 + 0.5 * i / (n_points - 1));
+        legs.payoff_curve(xs.data(), n_points, y_exp.data());
+        legs.price_curve(xs.data(), n_points, y_ref.data());
+
+        const auto t0 = std::chrono::steady_clock::now();
+        price_curve_display(legs, xs.data(), n_points, y64.data(), CurvePrecision::Float64);
+        const auto t1 = std::chrono::steady_clock::now();
+        price_curve_display(legs, xs.data(), n_points, y32.data(), CurvePrecision::Float32);
+        const auto t2 = std::chrono::steady_clock::now();
+        sec64 += std::chrono::duration<double>(t1 - t0).count();
+        sec32 += std::chrono::duration<double>(t2 - t1).count();
+
+        // y 軸範圍：與 DrawButterflyApp 相同
+        double y_min = 1e300, y_max = -1e300, max_abs = 0.0;
+        for (int i = 0; i < n_points; ++i)
+        {
+            max_f64_diff = std::max(max_f64_diff, std::fabs(y64[i] - y_ref[i]) / (1.0 + std::fabs(y_ref[i])));
+            y_min = std::min(y_min, std::min(y_exp[i], y64[i]) - cost);
+            y_max = std::max(y_max, std::max(y_exp[i], y64[i]) - cost);
+            max_abs = std::max(max_abs, std::fabs(y32[i] - y64[i]));
+        }
+        y_min = std::min(y_min, 0.0) - 1.0;
+        y_max = std::max(y_max, 0.0) + 1.0;
+        const double px = max_abs * height_px / (y_max - y_min);
+        errors.push_back(px);
+        if (px > worst_px)
+        {
+            worst_px = px;
+            worst_abs = max_abs;
+            worst = pc;
+        }
+    }
+
+    std::sort(errors.begin(), errors.end());
+    const auto pct = [&](double p) { return errors[std::min(errors.size() - 1, (std::size_t)(p * errors.size()))]; };
+    const double total_points = (double)n_cases * n_points;
+    printf("Scenarios: %d x %d points, plot height %.0f px\n", n_cases, n_points, height_px);
+    printf("float64 template vs OptionLegStore::price_curve: max rel diff %.2e\n", max_f64_diff);
+    printf("float32 pixel error: p50 %.2e  p99 %.2e  max %.2e px (abs %.2e)\n", pct(0.5), pct(0.99), worst_px, worst_abs);
+    printf("  worst: spot %.2f iv %.1f%% days %.0f rate %.2f%% atm %.2f width %.2f yield %.2f%% div %.2f %s\n",
+        worst.spot, worst.iv_pct, worst.days, worst.rate_pct, worst.strike_atm, worst.width, worst.yield_pct, worst.cash_div,
+        worst.put ? "put" : "call");
+    printf("Throughput: float64 %.1f M pts/s, float32 %.1f M pts/s (x%.2f)\n",
+        total_points / sec64 / 1e6, total_points / sec32 / 1e6, sec64 / sec32);
+
+    const bool ok = max_f64_diff <= 1e-12 && worst_px <= max_px;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+// pricing_service.h - 多個面板共用的背景定價服務
+//
+// - 去重：相同的 (情境, 點數) 只會算一次，結果以 shared_ptr 共用並快取。
+// - 依可見度排程：面板每幀呼叫 Request() 並給優先權；沒被 Request 的 (隱藏 / 收合 /
+//   參數已改掉的舊情境) 排隊工作直接移出佇列，不花任何 CPU；重新被請求時再排回來。
+// - 很久沒被請求的快取項目在 BeginFrame() 時淘汰。
+#pragma once
+
+#include "butterfly_scenario.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct PricingResult
+{
+    TaggedVector<double, MemTag_Pricing> xs, ys_exp, ys_cur;
+    double entry_cost = 0.0;
+};
+
+// 優先權：數字越大越先算
+enum PricingPriority
+{
+    PricingPriority_Visible = 1,
+    PricingPriority_Hovered = 2,
+    PricingPriority_Focused = 3,
+};
+
+class PricingService
+{
+public:
+    struct Stats
+    {
+        std::size_t entries = 0;
+        std::size_t queued = 0;
+        std::uint64_t computed = 0;      // 實際定價次數
+        std::uint64_t requests = 0;      // Request() 呼叫次數
+        std::uint64_t dedup_hits = 0;    // 已有結果或已在排隊中的請求
+    };
+
+    explicit PricingService(int threads = 2, std::uint64_t evict_after_frames = 600)
+        : evict_after_frames_(evict_after_frames)
+    {
+        for (int i = 0; i < std::max(1, threads); ++i)
+            workers_.emplace_back([this] { WorkerMain(); });
+    }
+
+    ~PricingService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : workers_)
+            t.join();
+    }
+
+    PricingService(const PricingService&) = delete;
+    PricingService& operator=(const PricingService&) = delete;
+
+    // 每幀 UI 開始前呼叫一次
+    void BeginFrame()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++frame_;
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            Entry& e = it->second;
+            if (IsStale(e))
+                e.queued = false;
+            if (!e.running && frame_ - e.last_frame > evict_after_frames_)
+                it = entries_.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // 回傳此情境「目前已完成」的結果 (可能為 nullptr)；尚未完成則排入佇列
+    std::shared_ptr<const PricingResult> Request(const Scenario& sc, int n_points, int priority)
+    {
+        const Key key = MakeKey(sc, n_points);
+        std::shared_ptr<const PricingResult> result;
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.requests;
+            Entry& e = entries_[key];
+            if (e.last_frame == frame_ || e.result || e.queued || e.running)
+                ++stats_.dedup_hits;
+            e.last_frame = frame_;
+            if (e.last_priority_frame != frame_)
+            {
+                e.priority = priority;
+                e.last_priority_frame = frame_;
+            }
+            else
+            {
+                e.priority = std::max(e.priority, priority);
+            }
+            if (!e.result && !e.queued && !e.running)
+                e.queued = true;
+            // 之前因為不可見而被跳過的工作，重新可見時也要叫醒 worker
+            wake = e.queued;
+            result = e.result;
+        }
+        if (wake)
+            cv_.notify_one();
+        return result;
+    }
+
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats s = stats_;
+        s.entries = entries_.size();
+        for (const auto& kv : entries_)
+            if (kv.second.queued) ++s.queued;
+        return s;
+    }
+
+private:
+    struct Key
+    {
+        Scenario sc;
+        int n_points;
+
+        // 逐欄位比較 (不碰 padding；0.0 與 -0.0 視為相同)
+        bool operator==(const Key& o) const
+        {
+            return n_points == o.n_points && sc.spot == o.sc.spot && sc.iv_pct == o.sc.iv_pct && sc.days == o.sc.days &&
+                sc.rate_pct == o.sc.rate_pct && sc.strike_atm == o.sc.strike_atm && sc.width == o.sc.width;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& k) const
+        {
+            const double fields[6] = { k.sc.spot, k.sc.iv_pct, k.sc.days, k.sc.rate_pct, k.sc.strike_atm, k.sc.width };
+            std::uint64_t h = 1469598103934665603ull;
+            for (double f : fields)
+            {
+                std::uint64_t bits;
+                f += 0.0;   // -0.0 -> 0.0，與 operator== 一致
+                memcpy(&bits, &f, sizeof(bits));
+                h = (h ^ bits) * 1099511628211ull;
+            }
+            return (std::size_t)(h ^ (std::uint64_t)k.n_points);
+        }
+    };
+
+    struct Entry
+    {
+        int priority = 0;
+        std::uint64_t last_frame = 0;
+        std::uint64_t last_priority_frame = 0;
+        bool queued = false;
+        bool running = false;
+        std::shared_ptr<const PricingResult> result;
+    };
+
+    static Key MakeKey(const Scenario& sc, int n_points)
+    {
+        return Key{ sc, std::max(2, n_points) };
+    }
+
+    // 這一幀與上一幀都沒被請求：面板已隱藏，或參數改了 (舊情境被新的取代)
+    bool IsStale(const Entry& e) const
+    {
+        return frame_ - e.last_frame > 1;
+    }
+
+    std::uint64_t evict_after_frames_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<Key, Entry, KeyHash> entries_;
+    std::vector<std::thread> workers_;
+    std::uint64_t frame_ = 1;
+    bool stop_ = false;
+    Stats stats_;
+
+    // 只挑「上一幀或這一幀仍有被請求」的工作，並且優先權最高者先做；過期的順手移出佇列
+    bool PickJob(Key& out_key)
+    {
+        Entry* best = nullptr;
+        for (auto& kv : entries_)
+        {
+            Entry& e = kv.second;
+            if (!e.queued)
+                continue;
+            if (IsStale(e))
+            {
+                e.queued = false;
+                continue;
+            }
+            if (!best || e.priority > best->priority)
+            {
+                best = &e;
+                out_key = kv.first;
+            }
+        }
+        if (!best)
+            return false;
+        best->queued = false;
+        best->running = true;
+        return true;
+    }
+
+    void WorkerMain()
+    {
+        std::unique_ptr<ScenarioPricer> pricer;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            Key key;
+            cv_.wait(lock, [&] { return stop_ || PickJob(key); });
+            if (stop_)
+                return;
+            lock.unlock();
+
+            if (!pricer || pricer->n_points() != key.n_points)
+                pricer = std::make_unique<ScenarioPricer>(key.n_points);
+            auto res = std::make_shared<PricingResult>();
+            res->xs.resize(key.n_points);
+            res->ys_exp.resize(key.n_points);
+            res->ys_cur.resize(key.n_points);
+            res->entry_cost = pricer->EvaluateCurves(key.sc, res->xs.data(), res->ys_exp.data(), res->ys_cur.data());
+
+            lock.lock();
+            ++stats_.computed;
+            auto it = entries_.find(key);
+            if (it != entries_.end())
+            {
+                it->second.running = false;
+                it->second.result = std::move(res);
+            }
+        }
+    }
+};
@@ -0,0 +1,286 @@
+// render_pipeline.h - 兩段式管線：主執行緒建構第 N+1 幀 UI，render thread 送出第 N 幀
+//
+// 只用在 SDL_GPU backend：SDL_GPU 的 command buffer / swapchain 可以在非主執行緒取得，
+// 因此 SDL_WaitAndAcquireGPUSwapchainTexture 的 vsync 等待不再卡住 UI。
+// (OpenGL context 綁定單一執行緒、SDL_Renderer 必須在主執行緒，兩者維持原本的序列流程。)
+//
+// 三組 ImDrawData 深拷貝 (triple buffering)：一組給 render thread 正在畫、一組排隊、
+// 一組給主執行緒寫入。佇列深度固定為 1，render thread 落後時以最新一幀取代排隊中的舊幀，
+// 主執行緒永遠不會被阻塞。穩定狀態下每幀只做 memcpy，不配置記憶體。
+// 貼圖狀態 (ImTextureData) 屬於 ImGui、只在主執行緒碰：有貼圖要建立 / 更新 / 刪除的幀在主執行緒同步畫，
+// 快照本身不帶 Textures 清單，draw command 的 TexRef 也在拷貝時解析成純 ImTextureID。
+#pragma once
+
+#include "imgui.h"
+#include "imgui_impl_sdlgpu3.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ImDrawData 的深拷貝；ImDrawList 重複使用，容量只增不減。不含任何 ImGui 擁有的貼圖狀態
+struct DrawDataSnapshot
+{
+    ImDrawData data;
+    std::vector<ImDrawList*> lists;
+    ImVec4 clear_color;
+    std::uint64_t frame_id = 0;
+
+    ~DrawDataSnapshot()
+    {
+        for (ImDrawList* l : lists)
+            IM_DELETE(l);
+    }
+
+    void Capture(const ImDrawData* src, const ImVec4& clear, std::uint64_t id)
+    {
+        while ((int)lists.size() < src->CmdListsCount)
+            lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+
+        data.Clear();
+        for (int i = 0; i < src->CmdListsCount; ++i)
+        {
+            const ImDrawList* s = src->CmdLists[i];
+            ImDrawList* d = lists[i];
+            CopyVector(d->CmdBuffer, s->CmdBuffer);
+#if IMGUI_VERSION_NUM >= 19200
+            // TexRef 可能指向 ImTextureData (主執行緒隨時會改)；Submit 時已確認所有貼圖都是 OK，直接取出 ID
+            for (ImDrawCmd& cmd : d->CmdBuffer)
+                cmd.TexRef = ImTextureRef(cmd.GetTexID());
+#endif
+            CopyVector(d->IdxBuffer, s->IdxBuffer);
+            CopyVector(d->VtxBuffer, s->VtxBuffer);
+            d->Flags = s->Flags;
+            data.CmdLists.push_back(d);
+        }
+        data.Valid = src->Valid;
+        data.CmdListsCount = src->CmdListsCount;
+        data.TotalIdxCount = src->TotalIdxCount;
+        data.TotalVtxCount = src->TotalVtxCount;
+        data.DisplayPos = src->DisplayPos;
+        data.DisplaySize = src->DisplaySize;
+        data.FramebufferScale = src->FramebufferScale;
+        data.OwnerViewport = src->OwnerViewport;
+#if IMGUI_VERSION_NUM >= 19200
+        data.Textures = nullptr;   // 貼圖更新只在主執行緒的同步幀處理，render thread 不看 ImGui 的貼圖清單
+#endif
+        clear_color = clear;
+        frame_id = id;
+    }
+
+    template <typename T>
+    static void CopyVector(ImVector<T>& dst, const ImVector<T>& src)
+    {
+        dst.resize(src.Size);   // ImVector::resize 保留容量
+        if (src.Size > 0)
+            memcpy(dst.Data, src.Data, (size_t)src.Size * sizeof(T));
+    }
+};
+
+class GpuRenderPipeline
+{
+public:
+    GpuRenderPipeline(SDL_GPUDevice* device, SDL_Window* window)
+        : device_(device), window_(window)
+    {
+        for (int i = 0; i < kSlots; ++i)
+            free_slots_.push_back(i);
+        thread_ = std::thread([this] { RenderThreadMain(); });
+    }
+
+    ~GpuRenderPipeline() { Shutdown(); }
+
+    GpuRenderPipeline(const GpuRenderPipeline&) = delete;
+    GpuRenderPipeline& operator=(const GpuRenderPipeline&) = delete;
+
+    // 主執行緒在 ImGui::Render() 之後呼叫；回傳 false 代表這幀必須同步繪製 (例如字型貼圖要更新)
+    bool Submit(const ImDrawData* draw_data, const ImVec4& clear_color)
+    {
+        if (NeedsSynchronousFrame(draw_data))
+        {
+            WaitIdle();
+            return false;
+        }
+
+        int slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+        }
+
+        // 拷貝在鎖外進行：這個 slot 只有主執行緒在用
+        snapshots_[slot].Capture(draw_data, clear_color, ++frame_counter_);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queued_slot_ >= 0)
+            {
+                free_slots_.push_back(queued_slot_);   // render thread 落後：丟掉舊的排隊幀
+                ++dropped_frames_;
+            }
+            queued_slot_ = slot;
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    // 等 render thread 把排隊中與正在畫的幀都處理完
+    void WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this] { return queued_slot_ < 0 && rendering_slot_ < 0; });
+    }
+
+    void Shutdown()
+    {
+        if (!thread_.joinable())
+            return;
+        WaitIdle();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    // 給延遲量測：有新的一幀上屏就回傳 true 以及幀編號 / 上屏時間 / swapchain 等待時間
+    bool ConsumePresented(std::uint64_t* frame_id, Uint64* present_ns, Uint64* swapchain_wait_ns)
+    {
+        const std::uint64_t id = presented_frame_.load(std::memory_order_acquire);
+        if (id == consumed_frame_)
+            return false;
+        consumed_frame_ = id;
+        *frame_id = id;
+        *present_ns = presented_ns_.load(std::memory_order_relaxed);
+        *swapchain_wait_ns = swapchain_wait_ns_.load(std::memory_order_relaxed);
+        return true;
+    }
+
+    // 最近一次 Submit 的幀編號 (主執行緒)
+    std::uint64_t SubmittedFrame() const { return frame_counter_; }
+
+    std::uint64_t DroppedFrames() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_frames_;
+    }
+
+private:
+    static constexpr int kSlots = 3;
+
+    SDL_GPUDevice* device_;
+    SDL_Window* window_;
+    DrawDataSnapshot snapshots_[kSlots];
+    std::vector<int> free_slots_;
+    int queued_slot_ = -1;
+    int rendering_slot_ = -1;
+    std::uint64_t frame_counter_ = 0;
+    std::uint64_t dropped_frames_ = 0;
+    bool stop_ = false;
+
+    std::atomic<std::uint64_t> presented_frame_{ 0 };
+    std::atomic<Uint64> presented_ns_{ 0 };
+    std::atomic<Uint64> swapchain_wait_ns_{ 0 };
+    std::uint64_t consumed_frame_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_, idle_cv_;
+    std::thread thread_;
+
+    static bool NeedsSynchronousFrame(const ImDrawData* draw_data)
+    {
+#if IMGUI_VERSION_NUM >= 19200
+        // 動態字型貼圖的建立 / 更新 / 刪除由 backend 在 RenderDrawData 內處理，必須在主執行緒同步畫；
+        // 這裡檢查後才拷貝，所以快照裡的 TexRef 都已有 TexID
+        if (draw_data->Textures != nullptr)
+            for (ImTextureData* tex : *draw_data->Textures)
+                if (tex->Status != ImTextureStatus_OK)
+                    return true;
+#else
+        (void)draw_data;
+#endif
+        return false;
+    }
+
+    void RenderThreadMain()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            cv_.wait(lock, [this] { return stop_ || queued_slot_ >= 0; });
+            if (stop_ && queued_slot_ < 0)
+                break;
+            rendering_slot_ = queued_slot_;
+            queued_slot_ = -1;
+            lock.unlock();
+
+            RenderSnapshot(snapshots_[rendering_slot_]);
+
+            lock.lock();
+            free_slots_.push_back(rendering_slot_);
+            rendering_slot_ = -1;
+            idle_cv_.notify_all();
+        }
+    }
+
+    void RenderSnapshot(DrawDataSnapshot& snap)
+    {
+        ImDrawData* draw_data = &snap.data;
+        const bool is_minimized = (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f);
+
+        SDL_GPUCommandBuffer* command_buffer = SDL_AcquireGPUCommandBuffer(device_);
+        if (!command_buffer)
+        {
+            printf("Error: SDL_AcquireGPUCommandBuffer(): %s\n", SDL_GetError());
+            return;
+        }
+
+        // vsync / mailbox 的等待發生在 render thread，不在主執行緒
+        SDL_GPUTexture* swapchain_texture = nullptr;
+        SDL_WaitAndAcquireGPUSwapchainTexture(command_buffer, window_, &swapchain_texture, nullptr, nullptr);
+
+        if (swapchain_texture != nullptr && !is_minimized)
+        {
+            ImGui_ImplSDLGPU3_PrepareDrawData(draw_data, command_buffer);
+
+            SDL_GPUColorTargetInfo target_info = {};
+            target_info.texture = swapchain_texture;
+            target_info.clear_color = SDL_FColor{ snap.clear_color.x, snap.clear_color.y, snap.clear_color.z, snap.clear_color.w };
+            target_info.load_op = SDL_GPU_LOADOP_CLEAR;
+            target_info.store_op = SDL_GPU_STOREOP_STORE;
+            target_info.mip_level = 0;
+            target_info.layer_or_depth_plane = 0;
+            target_info.cycle = false;
+
+            SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, &target_info, 1, nullptr);
+            if (render_pass)
+            {
+                ImGui_ImplSDLGPU3_RenderDrawData(draw_data, command_buffer, render_pass);
+                SDL_EndGPURenderPass(render_pass);
+            }
+        }
+
+        SDL_SubmitGPUCommandBuffer(command_buffer);
+
+        // 送出後等 swapchain 有空位：回傳時這一幀已排進 present，以此作為上屏時間
+        if (swapchain_texture != nullptr)
+        {
+            const Uint64 wait_start_ns = SDL_GetTicksNS();
+            SDL_WaitForGPUSwapchain(device_, window_);
+            const Uint64 presented_ns = SDL_GetTicksNS();
+            swapchain_wait_ns_.store(presented_ns - wait_start_ns, std::memory_order_relaxed);
+            presented_ns_.store(presented_ns, std::memory_order_relaxed);
+            presented_frame_.store(snap.frame_id, std::memory_order_release);
+        }
+    }
+};
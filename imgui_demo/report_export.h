@@ -0,0 +1,230 @@
+// report_export.h - CSV / JSON 報表匯出 (fmt)
+//
+// 每一列用 fmt::format_to + FMT_COMPILE 寫進重複使用的 fmt::memory_buffer
+// (格式字串編譯期檢查、沒有 locale、沒有 printf 解析)，累積到 4 MB 才一次 fwrite。
+// buffer 清空時保留容量，穩定狀態下不配置記憶體；FILE 本身關掉緩衝避免多拷貝一次。
+// GUI 的匯出按鈕與 scenario_sweep CLI 共用。
+#pragma once
+
+#include "butterfly_scenario.h"
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+
+// 固定小數位數的 double，輸出與 printf 的 %.Nf 逐位元相同。
+// fmt 的 {:.Nf} 走通用浮點演算法，上千萬列時會變成瓶頸；這裡先放大成整數再用 format_int，
+// 只有 NaN / 超大值 / 太接近 .5 進位邊界時才交回 fmt 的精確演算法。
+template <int Digits>
+struct FixedDecimal
+{
+    double v;
+};
+
+static inline FixedDecimal<0> Fx0(double v) { return { v }; }
+static inline FixedDecimal<4> Fx4(double v) { return { v }; }
+static inline FixedDecimal<6> Fx6(double v) { return { v }; }
+
+template <int Digits>
+struct fmt::formatter<FixedDecimal<Digits>>
+{
+    constexpr auto parse(fmt::format_parse_context& ctx) { return ctx.begin(); }
+
+    template <typename FormatContext>
+    auto format(const FixedDecimal<Digits>& f, FormatContext& ctx) const
+    {
+        static_assert(Digits >= 0 && Digits <= 9, "FixedDecimal supports 0-9 digits");
+        constexpr std::uint64_t kScale[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+        constexpr std::uint64_t scale = kScale[Digits];
+        auto out = ctx.out();
+        const double scaled = std::fabs(f.v) * (double)scale;
+        const double floor_scaled = std::floor(scaled);
+        const double frac = scaled - floor_scaled;
+        if (!(scaled < 9.0e15) || std::fabs(frac - 0.5) <= scaled * 4.0e-16 + 1e-12)
+            return fmt::format_to(out, FMT_COMPILE("{:.{}f}"), f.v, Digits);
+
+        const std::uint64_t n = (std::uint64_t)floor_scaled + (frac > 0.5 ? 1 : 0);
+        if (std::signbit(f.v))
+            *out++ = '-';
+        const fmt::format_int int_part(n / scale);
+        out = std::copy(int_part.data(), int_part.data() + int_part.size(), out);
+        if constexpr (Digits > 0)
+        {
+            // 小數部分加上 scale 再格式化、去掉開頭的 1，就是補零後的 Digits 位
+            const fmt::format_int frac_part(n % scale + scale);
+            *out++ = '.';
+            out = std::copy(frac_part.data() + 1, frac_part.data() + frac_part.size(), out);
+        }
+        return out;
+    }
+};
+
+class ReportFile
+{
+public:
+    explicit ReportFile(const char* path, std::size_t flush_bytes = 4 << 20)
+        : flush_bytes_(flush_bytes)
+    {
+        f_ = fopen(path, "wb");
+        if (!f_)
+        {
+            fprintf(stderr, "Error: cannot open %s\n", path);
+            return;
+        }
+        setvbuf(f_, nullptr, _IONBF, 0);
+        buf_.reserve(flush_bytes_ + 4096);
+    }
+
+    // 寫到已開啟的 FILE (例如 stdout)；Close 時只 flush，不關閉
+    explicit ReportFile(FILE* f, std::size_t flush_bytes = 4 << 20)
+        : f_(f), owns_file_(false), flush_bytes_(flush_bytes)
+    {
+        buf_.reserve(flush_bytes_ + 4096);
+    }
+
+    ~ReportFile() { Close(); }
+
+    ReportFile(const ReportFile&) = delete;
+    ReportFile& operator=(const ReportFile&) = delete;
+
+    bool ok() const { return f_ != nullptr && !failed_; }
+    fmt::memory_buffer& buffer() { return buf_; }
+    std::uint64_t bytes_written() const { return bytes_written_ + buf_.size(); }
+
+    // 每寫完一列呼叫；累積到門檻才真的寫檔
+    void Commit()
+    {
+        if (buf_.size() >= flush_bytes_)
+            Flush();
+    }
+
+    void Flush()
+    {
+        if (f_ && buf_.size() > 0)
+        {
+            if (fwrite(buf_.data(), 1, buf_.size(), f_) != buf_.size())
+                failed_ = true;
+            bytes_written_ += buf_.size();
+        }
+        buf_.clear();
+    }
+
+    bool Close()
+    {
+        if (!f_)
+            return false;
+        Flush();
+        if ((owns_file_ ? fclose(f_) : fflush(f_)) != 0)
+            failed_ = true;
+        f_ = nullptr;
+        return !failed_;
+    }
+
+private:
+    FILE* f_ = nullptr;
+    bool owns_file_ = true;
+    bool failed_ = false;
+    std::size_t flush_bytes_;
+    std::uint64_t bytes_written_ = 0;
+    fmt::memory_buffer buf_;
+};
+
+// ----------------------------- 情境結果 (scenario_sweep) -----------------------------
+static inline void AppendScenarioCsvHeader(fmt::memory_buffer& buf)
+{
+    fmt::format_to(std::back_inserter(buf), FMT_COMPILE(
+        "id,spot,iv_pct,days,rate_pct,strike_atm,width,entry_cost,t0_min,t0_max,t0_mean,"
+        "max_loss,max_profit,delta,gamma,theta_per_day,vega_per_pct\n"));
+}
+
+static inline void AppendScenarioCsvRow(fmt::memory_buffer& buf, std::uint64_t id, const Scenario& sc, const ScenarioResult& r)
+{
+    fmt::format_to(std::back_inserter(buf), FMT_COMPILE("{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n"),
+        id, Fx4(sc.spot), Fx4(sc.iv_pct), Fx0(sc.days), Fx4(sc.rate_pct), Fx4(sc.strike_atm), Fx4(sc.width),
+        Fx6(r.entry_cost), Fx6(r.t0_min), Fx6(r.t0_max), Fx6(r.t0_mean), Fx6(r.expiry_min), Fx6(r.expiry_max),
+        Fx6(r.greeks.delta), Fx6(r.greeks.gamma), Fx6(r.greeks.theta / 365.0), Fx6(r.greeks.vega / 100.0));
+}
+
+// JSON 陣列的一個元素：first 為 false 時加前導逗號；開頭 "[" 與結尾 "]" 由呼叫端寫
+static inline void AppendScenarioJsonRow(fmt::memory_buffer& buf, bool first, std::uint64_t id, const Scenario& sc, const ScenarioResult& r)
+{
+    fmt::format_to(std::back_inserter(buf),
+        FMT_COMPILE("{}{{\"id\":{},\"spot\":{},\"iv_pct\":{},\"days\":{},\"rate_pct\":{},\"strike_atm\":{},\"width\":{},"
+            "\"entry_cost\":{},\"t0_min\":{},\"t0_max\":{},\"t0_mean\":{},\"max_loss\":{},\"max_profit\":{},"
+            "\"delta\":{},\"gamma\":{},\"theta_per_day\":{},\"vega_per_pct\":{}}}\n"),
+        first ? "" : ",", id, Fx4(sc.spot), Fx4(sc.iv_pct), Fx0(sc.days), Fx4(sc.rate_pct), Fx4(sc.strike_atm), Fx4(sc.width),
+        Fx6(r.entry_cost), Fx6(r.t0_min), Fx6(r.t0_max), Fx6(r.t0_mean), Fx6(r.expiry_min), Fx6(r.expiry_max),
+        Fx6(r.greeks.delta), Fx6(r.greeks.gamma), Fx6(r.greeks.theta / 365.0), Fx6(r.greeks.vega / 100.0));
+}
+
+// ----------------------------- 損益曲線 + Greeks (GUI) -----------------------------
+// 每個網格點：到期 / T+0 損益 (已扣成本) 以及該 spot 下的部位 Greeks
+struct CurveReport
+{
+    const OptionLegStore* legs = nullptr;
+    const double* xs = nullptr;
+    const double* ys_exp = nullptr;
+    const double* ys_cur = nullptr;
+    int n_points = 0;
+    double entry_cost = 0.0;
+};
+
+static inline bool ExportCurveCsv(const char* path, const CurveReport& rep)
+{
+    ReportFile file(path);
+    if (!file.ok())
+        return false;
+    fmt::memory_buffer& buf = file.buffer();
+    fmt::format_to(std::back_inserter(buf), FMT_COMPILE("# spot={},entry_cost={}\n"), Fx4(rep.legs->spot()), Fx6(rep.entry_cost));
+    fmt::format_to(std::back_inserter(buf), FMT_COMPILE("spot,expiry_pnl,t0_pnl,delta,gamma,theta_per_day,vega_per_pct,rho_per_pct\n"));
+    for (int i = 0; i < rep.n_points; ++i)
+    {
+        const Greeks g = rep.legs->greeks_at(rep.xs[i]);
+        fmt::format_to(std::back_inserter(buf), FMT_COMPILE("{},{},{},{},{},{},{},{}\n"),
+            Fx4(rep.xs[i]), Fx6(rep.ys_exp[i]), Fx6(rep.ys_cur[i]),
+            Fx6(g.delta), Fx6(g.gamma), Fx6(g.theta / 365.0), Fx6(g.vega / 100.0), Fx6(g.rho / 100.0));
+        file.Commit();
+    }
+    return file.Close();
+}
+
+static inline bool ExportCurveJson(const char* path, const CurveReport& rep)
+{
+    ReportFile file(path);
+    if (!file.ok())
+        return false;
+    fmt::memory_buffer& buf = file.buffer();
+    const OptionLegStore& legs = *rep.legs;
+    const Greeks pos = legs.greeks_at(legs.spot());
+    fmt::format_to(std::back_inserter(buf),
+        FMT_COMPILE("{{\n\"spot\":{},\"entry_cost\":{},\n"
+            "\"greeks\":{{\"delta\":{},\"gamma\":{},\"theta_per_day\":{},\"vega_per_pct\":{},\"rho_per_pct\":{}}},\n"
+            "\"legs\":[\n"),
+        Fx4(legs.spot()), Fx6(rep.entry_cost),
+        Fx6(pos.delta), Fx6(pos.gamma), Fx6(pos.theta / 365.0), Fx6(pos.vega / 100.0), Fx6(pos.rho / 100.0));
+    for (std::size_t i = 0; i < legs.size(); ++i)
+    {
+        const bool is_put = legs.type[i] == static_cast<std::uint8_t>(OptionType::Put);
+        fmt::format_to(std::back_inserter(buf),
+            FMT_COMPILE("{}{{\"type\":\"{}\",\"strike\":{},\"qty\":{},\"expiry_years\":{},\"vol\":{},\"rate\":{},\"value\":{}}}\n"),
+            i == 0 ? "" : ",", is_put ? "put" : "call",
+            Fx4(legs.strike[i]), Fx4(legs.qty[i]), Fx6(legs.expiry[i]), Fx6(legs.vol[i]), Fx6(legs.rate[i]), Fx6(legs.value[i]));
+    }
+    fmt::format_to(std::back_inserter(buf), FMT_COMPILE("],\n\"curve\":[\n"));
+    for (int i = 0; i < rep.n_points; ++i)
+    {
+        const Greeks g = legs.greeks_at(rep.xs[i]);
+        fmt::format_to(std::back_inserter(buf),
+            FMT_COMPILE("{}{{\"spot\":{},\"expiry_pnl\":{},\"t0_pnl\":{},\"delta\":{},\"gamma\":{},\"theta_per_day\":{},\"vega_per_pct\":{}}}\n"),
+            i == 0 ? "" : ",", Fx4(rep.xs[i]), Fx6(rep.ys_exp[i]), Fx6(rep.ys_cur[i]),
+            Fx6(g.delta), Fx6(g.gamma), Fx6(g.theta / 365.0), Fx6(g.vega / 100.0));
+        file.Commit();
+    }
+    fmt::format_to(std::back_inserter(buf), FMT_COMPILE("]\n}}\n"));
+    return file.Close();
+}
@@ -0,0 +1,474 @@
+// risk_ladder.h - Bump-and-reprice 風險階梯：spot 衝擊 x IV 衝擊 x 時間推移 的部位損益矩陣
+//
+// 一次批次計算整個矩陣，而不是每格呼叫一次定價：
+//   - log(S) 每個 spot 衝擊只算一次，所有腿 / 所有 (IV, 時間) 共用
+//   - 每條腿在某個 (IV, 時間) 下的 sqrt(T)、sigma*sqrt(T)、drift、K*exp(-rT)、log(K) 只算一次，
+//     整列 spot 共用；有期限結構 / 股利時折現與遠期因子取自部位的 MarketCurves，
+//     時間推移後改用 rolled(dt) (從推移後的日期起算的遠期折現，已除息的股利不再扣)
+//   - 部位設定了隨機波動率模型 (heston_cos.h) 時改用 COS 定價：IV 衝擊平移 sqrt(v0) (與模型 vega 相同的定義)，
+//     每個 (IV, 時間) 依到期日各建一份展開係數，一條腿整列 spot 一次交給 cos_put_grid
+// (IV, 時間) 的每一列是一個工作單位，由常駐的 worker 與 UI 執行緒一起分攤 (fork-join)，
+// Compute() 回傳時結果已完成，輸入改變的同一幀就能顯示。worker 在第一次 Compute 時才建立 (面板沒開過就不佔執行緒)。
+#pragma once
+
+#include "imgui.h"
+#include "implot.h"
+#include "butterfly_app.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct RiskLadderConfig
+{
+    int spot_steps = 20;          // 單邊格數：-N..+N
+    double spot_step_pct = 1.0;   // 每格 spot 變動 (%)
+    int iv_steps = 10;            // 單邊格數
+    double iv_step_pts = 1.0;     // 每格 IV 變動 (波動率點數，1 = 1%)
+    int time_shifts = 5;          // 0, 1, ..., time_shifts-1 個時間步
+    double time_step_days = 7.0;
+
+    int spot_count() const { return 2 * spot_steps + 1; }
+    int iv_count() const { return 2 * iv_steps + 1; }
+
+    bool operator==(const RiskLadderConfig&) const = default;
+};
+
+class RiskLadder
+{
+public:
+    explicit RiskLadder(int threads = (int)std::max(1u, std::thread::hardware_concurrency()) - 1)
+        : n_workers_(std::max(0, threads))
+    {
+    }
+
+    ~RiskLadder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : workers_)
+            t.join();
+    }
+
+    RiskLadder(const RiskLadder&) = delete;
+    RiskLadder& operator=(const RiskLadder&) = delete;
+
+    // 部位與設定都沒變就沿用上次結果；回傳是否重算
+    bool Update(const OptionLegStore& legs, const RiskLadderConfig& cfg)
+    {
+        if (valid_ && legs.generation() == key_ && cfg == cfg_)
+            return false;
+        Compute(legs, cfg);
+        return true;
+    }
+
+    void Compute(const OptionLegStore& legs, const RiskLadderConfig& cfg)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        cfg_ = cfg;
+        key_ = legs.generation();
+        base_value_ = legs.total_value();
+        base_spot_ = legs.spot();
+
+        const int n_spot = cfg.spot_count();
+        spots_.resize(n_spot);
+        log_spots_.resize(n_spot);
+        for (int s = 0; s < n_spot; ++s)
+        {
+            spots_[s] = std::max(1e-9, base_spot_ * (1.0 + SpotShockPct(s) / 100.0));
+            log_spots_[s] = std::log(spots_[s]);
+        }
+
+        const std::size_t n_legs = legs.size();
+        strike_.assign(legs.strike.begin(), legs.strike.end());
+        log_strike_.resize(n_legs);
+        for (std::size_t i = 0; i < n_legs; ++i)
+            log_strike_[i] = std::log(std::max(1e-12, strike_[i]));
+        expiry_.assign(legs.expiry.begin(), legs.expiry.end());
+        qty_.assign(legs.qty.begin(), legs.qty.end());
+        vol_.assign(legs.vol.begin(), legs.vol.end());
+        rate_.assign(legs.rate.begin(), legs.rate.end());
+        type_.assign(legs.type.begin(), legs.type.end());
+        model_ = legs.model();
+        curves_.clear();
+        if (legs.curves())
+            for (int t = 0; t < cfg.time_shifts; ++t)
+                curves_.push_back(legs.curves()->rolled(TimeShiftDays(t) / 365.0));
+
+        const int n_slices = cfg.iv_count() * cfg.time_shifts;
+        values_.resize((std::size_t)n_slices * n_spot);
+
+        // fork：資料都寫好之後，把 (工作編號, 下一個 slice = 0) 當成一個值發佈；
+        // 上一個工作還沒離開 RunSlices 的 worker 看到編號不同就不會領到新工作的 slice
+        if (workers_.size() != (std::size_t)n_workers_)
+            for (int i = 0; i < n_workers_; ++i)
+                workers_.emplace_back([this] { WorkerMain(); });
+        const std::uint64_t job = job_ + 1;
+        n_slices_.store(n_slices, std::memory_order_relaxed);
+        remaining_.store(n_slices, std::memory_order_relaxed);
+        cursor_.store(job << 32, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = job;
+        }
+        cv_.notify_all();
+
+        RunSlices(job);
+
+        // join
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait(lock, [this] { return remaining_.load(std::memory_order_acquire) == 0; });
+        }
+
+        valid_ = true;
+        compute_us_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    bool Valid() const { return valid_; }
+    const RiskLadderConfig& Config() const { return cfg_; }
+    double ComputeMicros() const { return compute_us_; }
+    int Threads() const { return n_workers_ + 1; }
+    bool UsesModel() const { return (bool)model_; }
+
+    // 索引 -> 衝擊量；IV 索引 0 是最大的正衝擊 (熱圖最上面一列)
+    double SpotShockPct(int s) const { return (s - cfg_.spot_steps) * cfg_.spot_step_pct; }
+    double IvShockPts(int v) const { return (cfg_.iv_steps - v) * cfg_.iv_step_pts; }
+    double TimeShiftDays(int t) const { return t * cfg_.time_step_days; }
+    double ShockedSpot(int s) const { return spots_[s]; }
+
+    // 損益 (相對目前部位價值)
+    double PnL(int t, int v, int s) const { return values_[((std::size_t)t * cfg_.iv_count() + v) * cfg_.spot_count() + s]; }
+    // 某個時間推移下的 iv_count x spot_count 矩陣 (列優先)
+    const double* Slice(int t) const { return &values_[(std::size_t)t * cfg_.iv_count() * cfg_.spot_count()]; }
+
+private:
+    RiskLadderConfig cfg_;
+    std::uint64_t key_ = ~0ull;
+    bool valid_ = false;
+    double base_value_ = 0.0;
+    double base_spot_ = 0.0;
+    double compute_us_ = 0.0;
+
+    // 工作快照 (Compute 期間唯讀)
+    std::vector<double> spots_, log_spots_;
+    std::vector<double> strike_, log_strike_, expiry_, qty_, vol_, rate_;
+    std::vector<std::uint8_t> type_;
+    std::vector<std::shared_ptr<const MarketCurves>> curves_;   // 每個時間推移一份；沒有期限結構時為空
+    std::shared_ptr<const StochVolParams> model_;               // 空 = Black-Scholes
+    TaggedVector<double, MemTag_Surfaces> values_;   // time_shifts x iv_count x spot_count
+    std::atomic<int> n_slices_{ 0 };
+
+    int n_workers_ = 0;
+    std::vector<std::thread> workers_;   // 第一次 Compute 才建立
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    std::atomic<std::uint64_t> cursor_{ 0 };   // 高 32 位元 = 工作編號，低 32 位元 = 下一個 slice
+    std::atomic<int> remaining_{ 0 };
+    std::uint64_t job_ = 0;
+    bool stop_ = false;
+
+    void WorkerMain()
+    {
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return stop_ || job_ != seen; });
+                if (stop_)
+                    return;
+                seen = job_;
+            }
+            RunSlices(seen);
+        }
+    }
+
+    // 只領 job 這個工作的 slice：cursor_ 的編號不同 (已換成新工作) 或領完就離開
+    void RunSlices(std::uint64_t job)
+    {
+        SliceScratch scratch;
+        std::uint64_t cur = cursor_.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if ((cur >> 32) != job || (int)(cur & 0xFFFFFFFFu) >= n_slices_.load(std::memory_order_relaxed))
+                return;
+            if (!cursor_.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                continue;
+            const int slice = (int)(cur & 0xFFFFFFFFu);
+            ComputeSlice(slice, scratch);
+            if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_cv_.notify_all();
+            }
+            cur = cursor_.load(std::memory_order_acquire);
+        }
+    }
+
+    // 每個執行緒自己的暫存
+    struct SliceScratch
+    {
+        std::vector<double> terms;    // 每腿 8 個：qty, logK, K*df, vst, drift, (0 = 已到期), exp(-qT), 現金股利現值
+        std::vector<double> fk, put;  // 模型：一條腿整列 spot 的 F/K 與 put / (K df)
+        std::vector<CosSlice> cos;    // 模型：這個 slice 用到的各到期日係數
+    };
+
+    // 不同 slice 寫 values_ 中不重疊的列
+    void ComputeSlice(int slice, SliceScratch& scratch)
+    {
+        std::vector<double>& terms = scratch.terms;
+        const int n_iv = cfg_.iv_count();
+        const int n_spot = cfg_.spot_count();
+        const int t = slice / n_iv;
+        const int v = slice % n_iv;
+        const double dt_years = TimeShiftDays(t) / 365.0;
+        const double dvol = IvShockPts(v) / 100.0;
+
+        // 這一列共用的每腿衍生項
+        const std::size_t n_legs = strike_.size();
+        terms.resize(n_legs * 8);
+        for (std::size_t i = 0; i < n_legs; ++i)
+        {
+            const double T = std::max(0.0, expiry_[i] - dt_years);
+            const double sigma = std::max(1e-4, vol_[i] + dvol);
+            const double sqrtT = std::sqrt(T);
+            double* a = &terms[i * 8];
+            a[0] = qty_[i];
+            a[1] = log_strike_[i];
+            a[3] = sigma * sqrtT;
+            a[5] = T > 0.0 ? 1.0 : 0.0;
+            if (!curves_.empty())
+            {
+                const ExpiryFactors f = curves_[t]->factors(T);
+                a[2] = strike_[i] * f.df;
+                a[4] = f.carry_t + 0.5 * sigma * sigma * T;
+                a[6] = f.div_df;
+                a[7] = f.div_pv;
+            }
+            else
+            {
+                a[2] = strike_[i] * std::exp(-rate_[i] * T);
+                a[4] = (rate_[i] + 0.5 * sigma * sigma) * T;
+                a[6] = 1.0;
+                a[7] = 0.0;
+            }
+        }
+
+        double* row = &values_[(std::size_t)slice * n_spot];
+        if (model_)
+        {
+            ModelSlice(row, dt_years, dvol, scratch);
+            return;
+        }
+        for (int s = 0; s < n_spot; ++s)
+        {
+            const double S = spots_[s];
+            const double logS = log_spots_[s];
+            double sum = 0.0;
+            for (std::size_t i = 0; i < n_legs; ++i)
+            {
+                const double* a = &terms[i * 8];
+                const bool is_put = type_[i] == static_cast<std::uint8_t>(OptionType::Put);
+                double price;
+                if (a[5] == 0.0 || a[3] <= 0.0)
+                {
+                    price = is_put ? put_payoff(S, strike_[i]) : call_payoff(S, strike_[i]);
+                }
+                else if (S - a[7] <= 0.0)
+                {
+                    price = is_put ? a[2] : 0.0;   // 與 OptionLegStore 相同的慣例 (put 為 K df)
+                }
+                else
+                {
+                    // 沒有現金股利時共用整列的 log(S)
+                    const double s_adj = S - a[7];
+                    const double d1 = ((a[7] == 0.0 ? logS : std::log(s_adj)) - a[1] + a[4]) / a[3];
+                    const double call = s_adj * a[6] * norm_cdf(d1) - a[2] * norm_cdf(d1 - a[3]);
+                    price = is_put ? call - s_adj * a[6] + a[2] : call;
+                }
+                sum += a[0] * price;
+            }
+            row[s] = sum - base_value_;
+        }
+    }
+
+    // 模型下的一列：vol 欄位不使用，IV 衝擊改成平移 sqrt(v0)；與 OptionLegStore 相同的慣例
+    // (已到期 = 內含價值，S - div_pv <= 0 時 call 為 0、put 為 K df)
+    void ModelSlice(double* row, double dt_years, double dvol, SliceScratch& scratch) const
+    {
+        const int n_spot = cfg_.spot_count();
+        const double sigma0 = std::max(1e-4, std::sqrt(std::max(0.0, model_->v0)) + dvol);
+        StochVolParams p = *model_;
+        p.v0 = sigma0 * sigma0;
+        scratch.cos.clear();
+        scratch.fk.resize(n_spot);
+        scratch.put.resize(n_spot);
+        for (int s = 0; s < n_spot; ++s)
+            row[s] = -base_value_;
+
+        for (std::size_t i = 0; i < strike_.size(); ++i)
+        {
+            const double* a = &scratch.terms[i * 8];
+            const double q = a[0], K = strike_[i], kdf = a[2], qdf = a[6], pv = a[7];
+            const bool is_put = type_[i] == static_cast<std::uint8_t>(OptionType::Put);
+            if (a[5] == 0.0)
+            {
+                for (int s = 0; s < n_spot; ++s)
+                    row[s] += q * (is_put ? put_payoff(spots_[s], K) : call_payoff(spots_[s], K));
+                continue;
+            }
+            if (K <= 0.0)
+                continue;
+            const double T = std::max(0.0, expiry_[i] - dt_years);
+            const CosSlice* slice = nullptr;
+            for (const CosSlice& c : scratch.cos)
+                if (c.T == T)
+                    slice = &c;
+            if (!slice)
+            {
+                scratch.cos.push_back(build_cos_slice(p, T));
+                slice = &scratch.cos.back();
+            }
+
+            const double to_fk = qdf / kdf;
+            for (int s = 0; s < n_spot; ++s)
+                scratch.fk[s] = std::max(1e-12, (spots_[s] - pv) * to_fk);
+            cos_put_grid(*slice, scratch.fk.data(), n_spot, scratch.put.data());
+            for (int s = 0; s < n_spot; ++s)
+            {
+                const double s_adj = spots_[s] - pv;
+                const double put = scratch.put[s] * kdf;
+                const double v = s_adj <= 0.0 ? (is_put ? kdf : 0.0) : (is_put ? put : put + s_adj * qdf - kdf);
+                row[s] += q * v;
+            }
+        }
+    }
+};
+
+// ----------------------------- UI -----------------------------
+struct RiskLadderView
+{
+    RiskLadder ladder;
+    RiskLadderConfig cfg;
+    int time_index = 0;
+    bool show_table = false;
+};
+
+static void DrawRiskLadder(RiskLadderView& view, const OptionLegStore& legs, bool* p_open)
+{
+    if (!*p_open)
+        return;
+    ImGui::SetNextWindowSize(ImVec2(900, 560), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("風險階梯 (Risk Ladder)", p_open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    RiskLadderConfig& cfg = view.cfg;
+    ImGui::PushItemWidth(140.0f);
+    ImGui::SliderInt("Spot 單邊格數", &cfg.spot_steps, 1, 50);
+    ImGui::SameLine();
+    SliderDouble("Spot 每格 %", &cfg.spot_step_pct, 0.1, 5.0, "%.1f");
+    ImGui::SliderInt("IV 單邊格數", &cfg.iv_steps, 0, 30);
+    ImGui::SameLine();
+    SliderDouble("IV 每格 (點)", &cfg.iv_step_pts, 0.1, 10.0, "%.1f");
+    ImGui::SliderInt("時間推移數", &cfg.time_shifts, 1, 12);
+    ImGui::SameLine();
+    SliderDouble("每步天數", &cfg.time_step_days, 1.0, 30.0, "%.0f");
+    ImGui::PopItemWidth();
+
+    view.ladder.Update(legs, cfg);
+    const RiskLadder& L = view.ladder;
+    const int n_spot = cfg.spot_count();
+    const int n_iv = cfg.iv_count();
+    view.time_index = std::clamp(view.time_index, 0, cfg.time_shifts - 1);
+
+    ImGui::Text("%d x %d x %d 格，%d 執行緒，%.0f us", n_spot, n_iv, cfg.time_shifts, L.Threads(), L.ComputeMicros());
+    if (L.UsesModel())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(COS 模型定價；IV 衝擊 = sqrt(v0) 平移)");
+    }
+    ImGui::SetNextItemWidth(200.0f);
+    char time_label[32];
+    snprintf(time_label, sizeof(time_label), "+%.0f 天", L.TimeShiftDays(view.time_index));
+    ImGui::SliderInt("時間推移", &view.time_index, 0, cfg.time_shifts - 1, time_label);
+    ImGui::SameLine();
+    ImGui::Checkbox("表格", &view.show_table);
+
+    const double* slice = L.Slice(view.time_index);
+    double max_abs = 1e-9;
+    for (int k = 0; k < n_iv * n_spot; ++k)
+        max_abs = std::max(max_abs, std::fabs(slice[k]));
+
+    if (!view.show_table)
+    {
+        const double spot_lo = L.SpotShockPct(0), spot_hi = L.SpotShockPct(n_spot - 1);
+        const double iv_lo = L.IvShockPts(n_iv - 1), iv_hi = L.IvShockPts(0);
+        const double half_spot = 0.5 * cfg.spot_step_pct, half_iv = 0.5 * cfg.iv_step_pts;
+        ImPlot::PushColormap(ImPlotColormap_RdBu);
+        if (ImPlot::BeginPlot("##Ladder", ImVec2(-90, -1), ImPlotFlags_NoLegend | ImPlotFlags_NoMouseText))
+        {
+            MemTagScope implot_scope(MemTag_ImPlot);
+            ImPlot::SetupAxes("Spot 衝擊 (%)", "IV 衝擊 (點)", ImPlotAxisFlags_NoGridLines, ImPlotAxisFlags_NoGridLines);
+            ImPlot::SetupAxisLimits(ImAxis_X1, spot_lo - half_spot, spot_hi + half_spot, ImGuiCond_Always);
+            ImPlot::SetupAxisLimits(ImAxis_Y1, iv_lo - half_iv, iv_hi + half_iv, ImGuiCond_Always);
+            ImPlot::PlotHeatmap("##PnL", slice, n_iv, n_spot, -max_abs, max_abs, nullptr,
+                ImPlotPoint(spot_lo - half_spot, iv_lo - half_iv), ImPlotPoint(spot_hi + half_spot, iv_hi + half_iv));
+            if (ImPlot::IsPlotHovered())
+            {
+                const ImPlotPoint m = ImPlot::GetPlotMousePos();
+                const int s = std::clamp((int)std::lround((m.x - spot_lo) / cfg.spot_step_pct), 0, n_spot - 1);
+                const int v = std::clamp((int)std::lround((iv_hi - m.y) / cfg.iv_step_pts), 0, n_iv - 1);
+                ImGui::SetTooltip("Spot %+.1f%% ($%.2f)\nIV %+.1f 點\n損益 $%.2f",
+                    L.SpotShockPct(s), L.ShockedSpot(s), L.IvShockPts(v), L.PnL(view.time_index, v, s));
+            }
+            ImPlot::EndPlot();
+        }
+        ImGui::SameLine();
+        ImPlot::ColormapScale("##LadderScale", -max_abs, max_abs, ImVec2(80, -1), "%.2f");
+        ImPlot::PopColormap();
+    }
+    else if (ImGui::BeginTable("##LadderTable", n_iv + 1,
+        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY))
+    {
+        // 列 = spot 衝擊、欄 = IV 衝擊
+        ImGui::TableSetupScrollFreeze(1, 1);
+        ImGui::TableSetupColumn("Spot \\ IV", ImGuiTableColumnFlags_WidthFixed, 110.0f);
+        char header[32];
+        for (int v = 0; v < n_iv; ++v)
+        {
+            snprintf(header, sizeof(header), "%+.1f", L.IvShockPts(v));
+            ImGui::TableSetupColumn(header, ImGuiTableColumnFlags_WidthFixed, 70.0f);
+        }
+        ImGui::TableHeadersRow();
+        for (int s = 0; s < n_spot; ++s)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%+.1f%% %.2f", L.SpotShockPct(s), L.ShockedSpot(s));
+            for (int v = 0; v < n_iv; ++v)
+            {
+                ImGui::TableSetColumnIndex(v + 1);
+                const double pnl = L.PnL(view.time_index, v, s);
+                ImGui::TextColored(pnl >= 0.0 ? ImVec4(0.1f, 0.5f, 0.2f, 1.0f) : ImVec4(0.8f, 0.2f, 0.2f, 1.0f), "%.2f", pnl);
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
@@ -0,0 +1,353 @@
+// scenario_sweep.cpp - 不開 GUI 的批次情境風險計算
+// Butterfly Spread Scenario Sweep (CLI)
+//
+// 用法:
+//   scenario_sweep <scenarios.csv|scenarios.bin> [output.csv|output.json] [--threads N] [--points N]
+//   scenario_sweep --generate <N> <scenarios.bin>      產生隨機情境 (壓力測試用)
+//
+// CSV 欄位: spot,iv_pct,days,rate_pct,strike_atm,width (第一行若不是數字視為標題)
+// 輸出 CSV (或副檔名 .json 時為 JSON 陣列): 每個情境的成本、損益網格統計與部位 Greeks，
+// 順序與輸入相同。格式化走 report_export.h (fmt，編譯期格式字串)。
+//
+// 架構: reader -> [bounded queue] -> N x pricer -> [bounded queue] -> writer
+// 每個階段以批次 (kBatchSize 筆) 傳遞，佇列有上限，寫得慢時上游自然被擋住。
+// writer 依 seq 重排；pricer 交出的批次若超前 writer 超過 kReorderWindow 批就先等，重排緩衝因此有上限。
+// 輸出可以是 stdout，所以錯誤訊息一律寫 stderr。
+
+#include "butterfly_scenario.h"
+#include "bounded_queue.h"
+#include "report_export.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+static constexpr std::size_t kBatchSize = 4096;
+static constexpr std::size_t kQueueDepth = 64;       // 每個佇列最多幾個批次
+static constexpr std::size_t kReadBlock = 4 << 20;   // 每次 fread 4 MB
+static constexpr std::uint64_t kReorderWindow = 16;  // writer 重排緩衝最多幾個批次
+
+struct ScenarioBatch
+{
+    std::uint64_t seq = 0;
+    std::uint64_t first_id = 0;
+    std::vector<Scenario> items;
+    std::vector<ScenarioResult> results;
+};
+
+// ----------------------------- Reader -----------------------------
+static bool ParseDouble(const char*& p, const char* end, double& out)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p < end && *p == '+') ++p;
+    auto res = std::from_chars(p, end, out);
+    if (res.ec != std::errc())
+        return false;
+    p = res.ptr;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p < end && *p == ',') ++p;
+    return true;
+}
+
+static bool ParseScenarioLine(const char* p, const char* end, Scenario& sc)
+{
+    double* fields[6] = { &sc.spot, &sc.iv_pct, &sc.days, &sc.rate_pct, &sc.strike_atm, &sc.width };
+    for (double* f : fields)
+        if (!ParseDouble(p, end, *f))
+            return false;
+    return true;
+}
+
+static bool IsBinaryScenarioFile(FILE* f)
+{
+    char magic[8] = {};
+    const bool is_bin = fread(magic, 1, 8, f) == 8 && memcmp(magic, kScenarioFileMagic, 8) == 0;
+    fseek(f, 0, SEEK_SET);
+    return is_bin;
+}
+
+static void ReadBinaryScenarios(FILE* f, BoundedQueue<ScenarioBatch>& out)
+{
+    std::uint64_t count = 0;
+    fseek(f, 8, SEEK_SET);
+    if (fread(&count, sizeof(count), 1, f) != 1)
+        return;
+
+    std::uint64_t seq = 0, id = 0;
+    while (id < count)
+    {
+        ScenarioBatch batch;
+        batch.seq = seq++;
+        batch.first_id = id;
+        batch.items.resize((std::size_t)std::min<std::uint64_t>(kBatchSize, count - id));
+        const std::size_t got = fread(batch.items.data(), sizeof(Scenario), batch.items.size(), f);
+        batch.items.resize(got);
+        id += got;
+        if (got == 0 || !out.push(std::move(batch)))
+            break;
+    }
+}
+
+static void ReadCsvScenarios(FILE* f, BoundedQueue<ScenarioBatch>& out)
+{
+    std::vector<char> buf(kReadBlock);
+    std::string carry;     // 跨區塊的半行
+    std::uint64_t seq = 0, id = 0, line_no = 0;
+    ScenarioBatch batch;
+    batch.items.reserve(kBatchSize);
+
+    auto handle_line = [&](const char* b, const char* e) {
+        ++line_no;
+        if (e > b && e[-1] == '\r') --e;
+        if (b == e) return;
+        Scenario sc;
+        if (!ParseScenarioLine(b, e, sc))
+        {
+            if (line_no != 1)   // 第一行允許是標題
+                fprintf(stderr, "Warning: skip malformed line %llu\n", (unsigned long long)line_no);
+            return;
+        }
+        batch.items.push_back(sc);
+        if (batch.items.size() == kBatchSize)
+        {
+            batch.seq = seq++;
+            batch.first_id = id;
+            id += batch.items.size();
+            out.push(std::move(batch));
+            batch = ScenarioBatch();
+            batch.items.reserve(kBatchSize);
+        }
+    };
+
+    std::size_t n;
+    while ((n = fread(buf.data(), 1, buf.size(), f)) > 0)
+    {
+        const char* p = buf.data();
+        const char* end = p + n;
+        while (p < end)
+        {
+            const char* nl = (const char*)memchr(p, '\n', end - p);
+            if (!nl)
+            {
+                carry.append(p, end);
+                break;
+            }
+            if (!carry.empty())
+            {
+                carry.append(p, nl);
+                handle_line(carry.data(), carry.data() + carry.size());
+                carry.clear();
+            }
+            else
+            {
+                handle_line(p, nl);
+            }
+            p = nl + 1;
+        }
+    }
+    if (!carry.empty())
+        handle_line(carry.data(), carry.data() + carry.size());
+    if (!batch.items.empty())
+    {
+        batch.seq = seq;
+        batch.first_id = id;
+        out.push(std::move(batch));
+    }
+}
+
+// ----------------------------- Writer -----------------------------
+// writer 下一個要寫的 seq；pricer 在 seq >= next_seq + kReorderWindow 時等待。
+// seq == next_seq 的批次永遠可以通過，所以不會卡死。
+class ReorderGate
+{
+public:
+    void WaitTurn(std::uint64_t seq)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return seq < next_seq_ + kReorderWindow; });
+    }
+
+    void Advance(std::uint64_t next_seq)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            next_seq_ = next_seq;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::uint64_t next_seq_ = 0;
+};
+
+static std::uint64_t WriteResults(ReportFile& file, bool json, BoundedQueue<ScenarioBatch>& in, ReorderGate& gate)
+{
+    fmt::memory_buffer& buf = file.buffer();
+    if (json)
+        buf.append(std::string_view("[\n"));
+    else
+        AppendScenarioCsvHeader(buf);
+
+    // pricer 完成順序不固定，依 seq 重排後輸出
+    std::map<std::uint64_t, ScenarioBatch> pending;
+    std::uint64_t next_seq = 0, written = 0;
+    ScenarioBatch batch;
+    while (in.pop(batch))
+    {
+        pending.emplace(batch.seq, std::move(batch));
+        for (auto it = pending.find(next_seq); it != pending.end(); it = pending.find(++next_seq))
+        {
+            const ScenarioBatch& b = it->second;
+            for (std::size_t i = 0; i < b.items.size(); ++i)
+            {
+                if (json)
+                    AppendScenarioJsonRow(buf, written + i == 0, b.first_id + i, b.items[i], b.results[i]);
+                else
+                    AppendScenarioCsvRow(buf, b.first_id + i, b.items[i], b.results[i]);
+            }
+            written += b.items.size();
+            pending.erase(it);
+            file.Commit();
+        }
+        gate.Advance(next_seq);
+    }
+    if (json)
+        buf.append(std::string_view("]\n"));
+    return written;
+}
+
+// ----------------------------- Generate -----------------------------
+static int GenerateScenarios(std::uint64_t count, const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "Error: cannot open %s\n", path);
+        return -1;
+    }
+    fwrite(kScenarioFileMagic, 1, 8, f);
+    fwrite(&count, sizeof(count), 1, f);
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> spot(50.0, 150.0), iv(5.0, 120.0), rate(0.0, 8.0), width(0.5, 20.0);
+    std::uniform_int_distribution<int> days(0, 365);
+    std::vector<Scenario> block;
+    block.reserve(kBatchSize);
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        const double s = spot(rng);
+        block.push_back({ s, iv(rng), (double)days(rng), rate(rng), std::round(s), width(rng) });
+        if (block.size() == kBatchSize || i + 1 == count)
+        {
+            fwrite(block.data(), sizeof(Scenario), block.size(), f);
+            block.clear();
+        }
+    }
+    fclose(f);
+    printf("Generated %llu scenarios: %s\n", (unsigned long long)count, path);
+    return 0;
+}
+
+// ----------------------------- Main -----------------------------
+int main(int argc, char** argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "--generate") == 0)
+        return GenerateScenarios(strtoull(argv[2], nullptr, 10), argv[3]);
+
+    const char* in_path = nullptr;
+    const char* out_path = nullptr;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    int points = 200;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) points = std::max(2, atoi(argv[++i]));
+        else if (!in_path) in_path = argv[i];
+        else if (!out_path) out_path = argv[i];
+    }
+    if (!in_path)
+    {
+        fprintf(stderr, "Usage: %s <scenarios.csv|scenarios.bin> [output.csv|output.json] [--threads N] [--points N]\n", argv[0]);
+        fprintf(stderr, "       %s --generate <N> <scenarios.bin>\n", argv[0]);
+        return -1;
+    }
+
+    FILE* in = fopen(in_path, "rb");
+    if (!in)
+    {
+        fprintf(stderr, "Error: cannot open %s\n", in_path);
+        return -1;
+    }
+    std::unique_ptr<ReportFile> out = out_path ? std::make_unique<ReportFile>(out_path) : std::make_unique<ReportFile>(stdout);
+    if (!out->ok())
+    {
+        fclose(in);
+        return -1;
+    }
+    const std::size_t out_len = out_path ? strlen(out_path) : 0;
+    const bool json = out_len >= 5 && strcmp(out_path + out_len - 5, ".json") == 0;
+
+    const auto t_start = std::chrono::steady_clock::now();
+    BoundedQueue<ScenarioBatch> to_price(kQueueDepth), to_write(kQueueDepth);
+    ReorderGate gate;
+
+    std::thread reader([&] {
+        if (IsBinaryScenarioFile(in))
+            ReadBinaryScenarios(in, to_price);
+        else
+            ReadCsvScenarios(in, to_price);
+        to_price.close();
+    });
+
+    std::atomic<int> pricers_alive(threads);
+    std::vector<std::thread> pricers;
+    for (int t = 0; t < threads; ++t)
+    {
+        pricers.emplace_back([&] {
+            ScenarioPricer pricer(points);
+            ScenarioBatch batch;
+            while (to_price.pop(batch))
+            {
+                batch.results.resize(batch.items.size());
+                for (std::size_t i = 0; i < batch.items.size(); ++i)
+                    batch.results[i] = pricer.Evaluate(batch.items[i]);
+                gate.WaitTurn(batch.seq);
+                to_write.push(std::move(batch));
+            }
+            if (--pricers_alive == 0)
+                to_write.close();
+        });
+    }
+
+    const std::uint64_t written = WriteResults(*out, json, to_write, gate);
+
+    reader.join();
+    for (std::thread& t : pricers)
+        t.join();
+    fclose(in);
+    if (!out->Close())
+    {
+        fprintf(stderr, "Error: failed to write %s\n", out_path ? out_path : "stdout");
+        return -1;
+    }
+
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    fprintf(stderr, "Priced %llu scenarios in %.3f s (%.0f scenarios/min, %d threads, %d grid points)\n",
+        (unsigned long long)written, sec, sec > 0.0 ? written / sec * 60.0 : 0.0, threads, points);
+    return 0;
+}
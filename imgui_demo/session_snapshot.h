@@ -0,0 +1,640 @@
+// session_snapshot.h - App Session 的版本化二進位快照
+//
+// 檔案格式 (native endian，只給本機同一份程式讀寫)：
+//   SnapshotFileHeader
+//   SnapshotSection[section_count]
+//   各 section 資料 (每段 8-byte 對齊、容量固定)
+//
+// 每個 section 的容量在建立檔案時決定，因此 offset 固定：之後只把「有變動」的
+// section (歷史只寫新增的那幾格) 原地寫回，不必整份重寫。容量不夠時才整份重建。
+// 寫檔在背景執行緒；讀檔用 mmap，驗證 checksum 後直接從映射記憶體拷貝。
+// checksum 以 kSnapshotChunk 為單位分塊：寫回時只重算被改到的塊，再把各塊的 hash 合成 section 的 checksum。
+#pragma once
+
+#include "butterfly_app.h"
+#include "mapped_file.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr char kSnapshotMagic[8] = { 'B', 'F', 'L', 'Y', 'S', 'N', 'A', 'P' };
+static constexpr std::uint32_t kSnapshotVersion = 4;
+static constexpr std::size_t kSnapshotChunk = 4096;
+
+enum SnapshotSectionId : std::uint32_t
+{
+    SnapshotSection_Params = 1,
+    SnapshotSection_Legs = 2,
+    SnapshotSection_History = 3,
+    SnapshotSection_Curve = 4,
+    SnapshotSection_COUNT = 4
+};
+
+struct SnapshotFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t section_count;
+    std::uint64_t file_size;
+};
+
+struct SnapshotSection
+{
+    std::uint32_t id;
+    std::uint32_t checksum;   // 涵蓋 [offset, offset + size)，見 snapshot_section_checksum
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+struct SnapshotParams
+{
+    double current_price;
+    double iv_pct;
+    double risk_free_pct;
+    double strike_atm;
+    double width;
+    std::int32_t days_to_expiry;
+    std::int32_t show_explain;
+    // 期限結構 / 股利 (TermStructureInput)；快取的曲線是用這組算的
+    double zero_pct[TermStructureInput::kPillars];
+    double yield_pct;
+    double div_days[TermStructureInput::kMaxDividends];
+    double div_amount[TermStructureInput::kMaxDividends];
+    std::int32_t use_term_structure;
+    std::int32_t n_dividends;
+    // 定價模型 (StochVolInput) 與顯示曲線精度
+    double v0_vol_pct;
+    double kappa;
+    double theta_vol_pct;
+    double xi;
+    double rho;
+    double jump_lambda;
+    double jump_mu_pct;
+    double jump_sigma_pct;
+    std::int32_t model;
+    std::int32_t precision;
+};
+
+// Legs:    u64 count, u64 capacity, strike/expiry/qty/vol/rate[capacity] (double), type[capacity] (u8, 補齊到 8)
+// History: u64 total_pushed, u64 capacity, HistorySample[capacity]
+// Curve:   u64 n_points, xs/ys_exp/ys_cur[n_points] (double)
+
+static inline std::uint32_t snapshot_checksum(const std::uint8_t* p, std::size_t n)
+{
+    std::uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// section checksum = 各 kSnapshotChunk 塊 FNV-1a 值串起來再做一次 FNV-1a
+static inline std::uint32_t snapshot_combine(const std::uint32_t* chunk_hashes, std::size_t n)
+{
+    return snapshot_checksum((const std::uint8_t*)chunk_hashes, n * sizeof(std::uint32_t));
+}
+
+static inline std::uint32_t snapshot_section_checksum(const std::uint8_t* p, std::size_t n)
+{
+    std::vector<std::uint32_t> chunks((n + kSnapshotChunk - 1) / kSnapshotChunk);
+    for (std::size_t c = 0; c < chunks.size(); ++c)
+        chunks[c] = snapshot_checksum(p + c * kSnapshotChunk, std::min(kSnapshotChunk, n - c * kSnapshotChunk));
+    return snapshot_combine(chunks.data(), chunks.size());
+}
+
+static inline std::size_t snapshot_align8(std::size_t n)
+{
+    return (n + 7) & ~(std::size_t)7;
+}
+
+// ----------------------------- Layout -----------------------------
+struct SnapshotLayout
+{
+    std::size_t leg_capacity = 0;
+    std::size_t history_capacity = 0;
+    std::size_t curve_points = 0;
+
+    std::size_t section_size(std::uint32_t id) const
+    {
+        switch (id)
+        {
+        case SnapshotSection_Params: return sizeof(SnapshotParams);
+        case SnapshotSection_Legs: return 16 + leg_capacity * 5 * sizeof(double) + snapshot_align8(leg_capacity);
+        case SnapshotSection_History: return 16 + history_capacity * sizeof(HistorySample);
+        case SnapshotSection_Curve: return 8 + curve_points * 3 * sizeof(double);
+        }
+        return 0;
+    }
+
+    std::size_t section_offset(std::uint32_t id) const
+    {
+        std::size_t off = sizeof(SnapshotFileHeader) + SnapshotSection_COUNT * sizeof(SnapshotSection);
+        for (std::uint32_t s = 1; s < id; ++s)
+            off += snapshot_align8(section_size(s));
+        return off;
+    }
+
+    std::size_t file_size() const
+    {
+        return section_offset(SnapshotSection_COUNT) + snapshot_align8(section_size(SnapshotSection_COUNT));
+    }
+
+    bool operator==(const SnapshotLayout& o) const
+    {
+        return leg_capacity == o.leg_capacity && history_capacity == o.history_capacity && curve_points == o.curve_points;
+    }
+
+    static SnapshotLayout For(const ButterflyApp& app)
+    {
+        SnapshotLayout l;
+        l.leg_capacity = 64;
+        while (l.leg_capacity < app.legs.size()) l.leg_capacity *= 2;
+        l.history_capacity = app.history.capacity();
+        l.curve_points = (std::size_t)ButterflyApp::n_points;
+        return l;
+    }
+};
+
+// ----------------------------- Load (mmap) -----------------------------
+// 讀回快照；任何 section 驗證失敗就略過該 section (保留預設值)
+static bool LoadSessionSnapshot(const char* path, ButterflyApp& app)
+{
+    MappedFile mf;
+    if (!mf.Open(path))
+        return false;
+
+    if (mf.size < sizeof(SnapshotFileHeader))
+        return false;
+    SnapshotFileHeader header;
+    memcpy(&header, mf.data, sizeof(header));
+    if (memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || header.version != kSnapshotVersion ||
+        header.file_size != mf.size || header.section_count != SnapshotSection_COUNT ||
+        sizeof(SnapshotFileHeader) + (std::size_t)header.section_count * sizeof(SnapshotSection) > mf.size)
+    {
+        printf("Warning: snapshot %s ignored (bad header or version).\n", path);
+        return false;
+    }
+
+    bool params_loaded = false, curve_loaded = false;
+    for (std::uint32_t s = 0; s < header.section_count; ++s)
+    {
+        SnapshotSection sec;
+        memcpy(&sec, mf.data + sizeof(SnapshotFileHeader) + s * sizeof(SnapshotSection), sizeof(sec));
+        // offset + size 可能溢位，分開比
+        if (sec.offset > mf.size || sec.size > mf.size - sec.offset)
+            continue;
+        const std::uint8_t* p = mf.data + sec.offset;
+        if (snapshot_section_checksum(p, (std::size_t)sec.size) != sec.checksum)
+        {
+            printf("Warning: snapshot section %u corrupted, using defaults.\n", sec.id);
+            continue;
+        }
+
+        switch (sec.id)
+        {
+        case SnapshotSection_Params:
+        {
+            if (sec.size < sizeof(SnapshotParams)) break;
+            SnapshotParams prm;
+            memcpy(&prm, p, sizeof(prm));
+            app.current_price = prm.current_price;
+            app.iv_pct = prm.iv_pct;
+            app.risk_free_pct = prm.risk_free_pct;
+            app.strike_atm = prm.strike_atm;
+            app.width = prm.width;
+            app.days_to_expiry = prm.days_to_expiry;
+            app.show_explain = prm.show_explain != 0;
+            app.use_term_structure = prm.use_term_structure != 0;
+            memcpy(app.term_structure.zero_pct, prm.zero_pct, sizeof(prm.zero_pct));
+            app.term_structure.yield_pct = prm.yield_pct;
+            app.term_structure.n_dividends = std::clamp((int)prm.n_dividends, 0, TermStructureInput::kMaxDividends);
+            memcpy(app.term_structure.div_days, prm.div_days, sizeof(prm.div_days));
+            memcpy(app.term_structure.div_amount, prm.div_amount, sizeof(prm.div_amount));
+            StochVolInput& sv = app.stoch_vol;
+            sv.model = std::clamp((int)prm.model, (int)PricingModel_BlackScholes, (int)PricingModel_Bates);
+            sv.v0_vol_pct = prm.v0_vol_pct;
+            sv.kappa = prm.kappa;
+            sv.theta_vol_pct = prm.theta_vol_pct;
+            sv.xi = prm.xi;
+            sv.rho = prm.rho;
+            sv.jump_lambda = prm.jump_lambda;
+            sv.jump_mu_pct = prm.jump_mu_pct;
+            sv.jump_sigma_pct = prm.jump_sigma_pct;
+            app.precision = prm.precision == (int)CurvePrecision::Float32 ? CurvePrecision::Float32 : CurvePrecision::Float64;
+            params_loaded = true;
+            break;
+        }
+        case SnapshotSection_Legs:
+        {
+            std::uint64_t count, capacity;
+            memcpy(&count, p, 8);
+            memcpy(&capacity, p + 8, 8);
+            if (count > capacity || 16 + capacity * 5 * sizeof(double) + snapshot_align8(capacity) > sec.size) break;
+            const double* cols = (const double*)(p + 16);
+            const std::uint8_t* types = (const std::uint8_t*)(cols + capacity * 5);
+            app.legs.clear();
+            app.legs.reserve((std::size_t)count);
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                OptionLeg leg;
+                leg.strike = cols[0 * capacity + i];
+                leg.expiry = cols[1 * capacity + i];
+                leg.qty = cols[2 * capacity + i];
+                leg.vol = cols[3 * capacity + i];
+                leg.rate = cols[4 * capacity + i];
+                leg.type = (OptionType)types[i];
+                app.legs.add_leg(leg);
+            }
+            break;
+        }
+        case SnapshotSection_History:
+        {
+            std::uint64_t total, capacity;
+            memcpy(&total, p, 8);
+            memcpy(&capacity, p + 8, 8);
+            if (capacity != app.history.capacity() || 16 + capacity * sizeof(HistorySample) > sec.size) break;
+            memcpy(app.history.samples.data(), p + 16, (std::size_t)capacity * sizeof(HistorySample));
+            app.history.total_pushed = total;
+            break;
+        }
+        case SnapshotSection_Curve:
+        {
+            std::uint64_t n;
+            memcpy(&n, p, 8);
+            if (n != (std::uint64_t)ButterflyApp::n_points || 8 + n * 3 * sizeof(double) > sec.size) break;
+            const double* cols = (const double*)(p + 8);
+            memcpy(app.xs.data(), cols, (std::size_t)n * sizeof(double));
+            memcpy(app.ys_exp.data(), cols + n, (std::size_t)n * sizeof(double));
+            memcpy(app.ys_cur.data(), cols + 2 * n, (std::size_t)n * sizeof(double));
+            curve_loaded = true;
+            break;
+        }
+        }
+    }
+
+    // 蝶式的腿由參數推導；快照裡的腿數不對就重建
+    if (app.legs.size() != ButterflyLeg_COUNT)
+    {
+        app.legs.clear();
+        for (int i = 0; i < ButterflyLeg_COUNT; ++i)
+            app.legs.add_leg({ 100.0, 0.0, OptionType::Call, i == ButterflyLeg_Mid ? -2.0 : 1.0, 0.0, 0.0 });
+    }
+    app.SyncButterflyLegs();
+    // 快取的曲線與參數 (含期限結構、模型、精度) 一致時，第一幀直接畫，不必重算
+    if (params_loaded && curve_loaded)
+    {
+        app.curve_generation = app.legs.generation();
+        app.curve_precision = app.precision;
+    }
+    printf("Loaded session snapshot: %s (%zu history samples)\n", path, app.history.count());
+    return true;
+}
+
+// ----------------------------- Background Writer -----------------------------
+// 主執行緒每幀呼叫 Submit()：只在內容改變且超過節流間隔時，把「變動的部分」
+// 拷貝成 patch 交給背景執行緒；背景執行緒更新自己的 image、重算 checksum、寫回檔案。
+class SessionSnapshotWriter
+{
+public:
+    explicit SessionSnapshotWriter(const char* path, double min_interval_sec = 0.5)
+        : path_(path), min_interval_(min_interval_sec)
+    {
+        thread_ = std::thread([this] { ThreadMain(); });
+    }
+
+    ~SessionSnapshotWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+        if (file_) fclose(file_);
+    }
+
+    SessionSnapshotWriter(const SessionSnapshotWriter&) = delete;
+    SessionSnapshotWriter& operator=(const SessionSnapshotWriter&) = delete;
+
+    // force = true 時忽略節流 (例如結束前)
+    void Submit(const ButterflyApp& app, bool force = false)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (!force && std::chrono::duration<double>(now - last_submit_).count() < min_interval_)
+            return;
+
+        SnapshotParams prm = {};
+        prm.current_price = app.current_price;
+        prm.iv_pct = app.iv_pct;
+        prm.risk_free_pct = app.risk_free_pct;
+        prm.strike_atm = app.strike_atm;
+        prm.width = app.width;
+        prm.days_to_expiry = app.days_to_expiry;
+        prm.show_explain = app.show_explain ? 1 : 0;
+        prm.use_term_structure = app.use_term_structure ? 1 : 0;
+        memcpy(prm.zero_pct, app.term_structure.zero_pct, sizeof(prm.zero_pct));
+        prm.yield_pct = app.term_structure.yield_pct;
+        prm.n_dividends = app.term_structure.n_dividends;
+        memcpy(prm.div_days, app.term_structure.div_days, sizeof(prm.div_days));
+        memcpy(prm.div_amount, app.term_structure.div_amount, sizeof(prm.div_amount));
+        const StochVolInput& sv = app.stoch_vol;
+        prm.v0_vol_pct = sv.v0_vol_pct;
+        prm.kappa = sv.kappa;
+        prm.theta_vol_pct = sv.theta_vol_pct;
+        prm.xi = sv.xi;
+        prm.rho = sv.rho;
+        prm.jump_lambda = sv.jump_lambda;
+        prm.jump_mu_pct = sv.jump_mu_pct;
+        prm.jump_sigma_pct = sv.jump_sigma_pct;
+        prm.model = sv.model;
+        prm.precision = (std::int32_t)app.precision;
+
+        bool params_dirty = !has_params_ || memcmp(&prm, &last_params_, sizeof(prm)) != 0;
+        // 背景定價還沒追上 (或精度剛切換) 時曲線先標記無效 (n = 0)，追上後再補寫一次
+        const bool curve_current = app.curve_generation == app.legs.generation() && app.curve_precision == app.precision;
+        bool legs_dirty = app.legs.generation() != last_legs_generation_ || curve_current != last_curve_written_;
+        bool history_dirty = app.history.total_pushed != last_history_pushed_;
+        if (!params_dirty && !legs_dirty && !history_dirty && SnapshotLayout::For(app) == last_layout_)
+            return;
+
+        Patch patch;
+        patch.layout = SnapshotLayout::For(app);
+        // 版面改變時背景會整份重建，必須送出完整內容
+        const bool full = !(patch.layout == last_layout_);
+        if (full)
+        {
+            params_dirty = legs_dirty = history_dirty = true;
+            last_history_pushed_ = 0;
+        }
+        if (params_dirty)
+            patch.Add(SnapshotSection_Params, 0, &prm, sizeof(prm));
+
+        if (legs_dirty)
+        {
+            // 腿與曲線都由 generation 決定
+            const std::uint64_t count = app.legs.size(), capacity = patch.layout.leg_capacity;
+            patch.Add(SnapshotSection_Legs, 0, &count, 8);
+            patch.Add(SnapshotSection_Legs, 8, &capacity, 8);
+            const AlignedVector<double>* cols[5] = { &app.legs.strike, &app.legs.expiry, &app.legs.qty, &app.legs.vol, &app.legs.rate };
+            for (int c = 0; c < 5; ++c)
+                patch.Add(SnapshotSection_Legs, 16 + c * capacity * sizeof(double), cols[c]->data(), count * sizeof(double));
+            patch.Add(SnapshotSection_Legs, 16 + 5 * capacity * sizeof(double), app.legs.type.data(), count);
+
+            const std::uint64_t n = curve_current ? ButterflyApp::n_points : 0;
+            patch.Add(SnapshotSection_Curve, 0, &n, 8);
+            if (curve_current)
+            {
+                patch.Add(SnapshotSection_Curve, 8, app.xs.data(), n * sizeof(double));
+                patch.Add(SnapshotSection_Curve, 8 + n * sizeof(double), app.ys_exp.data(), n * sizeof(double));
+                patch.Add(SnapshotSection_Curve, 8 + 2 * n * sizeof(double), app.ys_cur.data(), n * sizeof(double));
+            }
+            last_curve_written_ = curve_current;
+        }
+
+        if (history_dirty)
+        {
+            // 只送上次之後新增的格子 (超過一圈就整圈重送)
+            const HistoryRing& h = app.history;
+            const std::uint64_t cap = h.capacity();
+            const std::uint64_t first = std::max(last_history_pushed_, h.total_pushed > cap ? h.total_pushed - cap : 0);
+            patch.Add(SnapshotSection_History, 0, &h.total_pushed, 8);
+            patch.Add(SnapshotSection_History, 8, &cap, 8);
+            for (std::uint64_t i = first; i < h.total_pushed; ++i)
+            {
+                const std::size_t slot = (std::size_t)(i % cap);
+                patch.Add(SnapshotSection_History, 16 + slot * sizeof(HistorySample), &h.samples[slot], sizeof(HistorySample));
+            }
+        }
+
+        last_params_ = prm;
+        has_params_ = true;
+        last_legs_generation_ = app.legs.generation();
+        last_history_pushed_ = app.history.total_pushed;
+        last_submit_ = now;
+        last_layout_ = patch.layout;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(std::move(patch));
+        }
+        cv_.notify_one();
+    }
+
+    // 等背景執行緒把目前排隊的 patch 都寫完
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this] { return pending_.empty() && !writing_; });
+    }
+
+private:
+    struct Patch
+    {
+        struct Range
+        {
+            std::uint32_t section;
+            std::size_t offset;     // section 內偏移
+            std::size_t bytes_begin;
+            std::size_t size;
+        };
+
+        SnapshotLayout layout;
+        std::vector<Range> ranges;
+        std::vector<std::uint8_t> bytes;
+
+        void Add(std::uint32_t section, std::size_t offset, const void* src, std::size_t size)
+        {
+            if (size == 0) return;
+            ranges.push_back({ section, offset, bytes.size(), size });
+            bytes.insert(bytes.end(), (const std::uint8_t*)src, (const std::uint8_t*)src + size);
+        }
+    };
+
+    std::string path_;
+    double min_interval_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_, idle_cv_;
+    std::vector<Patch> pending_;
+    bool stop_ = false;
+    bool writing_ = false;
+
+    // 主執行緒端的 dirty 追蹤
+    std::chrono::steady_clock::time_point last_submit_{};
+    SnapshotParams last_params_ = {};
+    bool has_params_ = false;
+    std::uint64_t last_legs_generation_ = ~0ull;
+    bool last_curve_written_ = false;
+    std::uint64_t last_history_pushed_ = 0;
+    SnapshotLayout last_layout_;
+
+    // 背景執行緒端的檔案映像
+    SnapshotLayout layout_;
+    TaggedVector<std::uint8_t, MemTag_Snapshot> image_;
+    std::vector<std::uint32_t> chunk_hash_[SnapshotSection_COUNT + 1];   // 各 section 每個 kSnapshotChunk 塊的 hash
+    std::vector<std::uint8_t> chunk_dirty_[SnapshotSection_COUNT + 1];
+    FILE* file_ = nullptr;
+
+    void ThreadMain()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+            if (pending_.empty() && stop_)
+                break;
+
+            std::vector<Patch> batch;
+            batch.swap(pending_);
+            writing_ = true;
+            lock.unlock();
+            for (const Patch& p : batch)
+                Apply(p);
+            lock.lock();
+            writing_ = false;
+            idle_cv_.notify_all();
+        }
+    }
+
+    void Apply(const Patch& patch)
+    {
+        // 版面改變才重建 image；只是檔案不在 (上次寫失敗) 時用現有 image 整份重寫
+        const bool relayout = image_.empty() || !(patch.layout == layout_);
+        if (relayout)
+            ResetImage(patch.layout);
+        const bool rewrite = relayout || !file_;
+
+        // 套用到 image，記下每個 section 被改到的範圍與 checksum 塊
+        std::size_t dirty_lo[SnapshotSection_COUNT + 1], dirty_hi[SnapshotSection_COUNT + 1];
+        for (std::uint32_t s = 1; s <= SnapshotSection_COUNT; ++s) { dirty_lo[s] = SIZE_MAX; dirty_hi[s] = 0; }
+        for (const Patch::Range& r : patch.ranges)
+        {
+            const std::size_t base = layout_.section_offset(r.section);
+            if (r.offset + r.size > layout_.section_size(r.section))
+                continue;
+            memcpy(&image_[base + r.offset], &patch.bytes[r.bytes_begin], r.size);
+            dirty_lo[r.section] = std::min(dirty_lo[r.section], base + r.offset);
+            dirty_hi[r.section] = std::max(dirty_hi[r.section], base + r.offset + r.size);
+            std::vector<std::uint8_t>& flags = chunk_dirty_[r.section];
+            for (std::size_t c = r.offset / kSnapshotChunk; c <= (r.offset + r.size - 1) / kSnapshotChunk; ++c)
+                flags[c] = 1;
+        }
+
+        SnapshotSection* table = (SnapshotSection*)(image_.data() + sizeof(SnapshotFileHeader));
+        for (std::uint32_t s = 1; s <= SnapshotSection_COUNT; ++s)
+        {
+            if (dirty_hi[s] == 0 && !relayout) continue;
+            SnapshotSection& sec = table[s - 1];
+            std::vector<std::uint32_t>& hashes = chunk_hash_[s];
+            std::vector<std::uint8_t>& flags = chunk_dirty_[s];
+            const std::uint8_t* p = &image_[(std::size_t)sec.offset];
+            for (std::size_t c = 0; c < hashes.size(); ++c)
+            {
+                if (!flags[c] && !relayout) continue;
+                hashes[c] = snapshot_checksum(p + c * kSnapshotChunk, std::min(kSnapshotChunk, (std::size_t)sec.size - c * kSnapshotChunk));
+                flags[c] = 0;
+            }
+            sec.checksum = snapshot_combine(hashes.data(), hashes.size());
+        }
+
+        if (rewrite)
+        {
+            WriteWholeFile();
+            return;
+        }
+
+        // 原地寫回：section 資料 + section table (checksum)；任何一步失敗就關檔，下一個 patch 整份重寫
+        bool ok = true;
+        for (std::uint32_t s = 1; s <= SnapshotSection_COUNT && ok; ++s)
+            if (dirty_hi[s] != 0)
+                ok = WriteRange(dirty_lo[s], dirty_hi[s] - dirty_lo[s]);
+        ok = ok && WriteRange(sizeof(SnapshotFileHeader), SnapshotSection_COUNT * sizeof(SnapshotSection));
+        if (ok && fflush(file_) != 0)
+        {
+            printf("Error: cannot flush snapshot %s\n", path_.c_str());
+            ok = false;
+        }
+        if (!ok)
+        {
+            fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    void ResetImage(const SnapshotLayout& layout)
+    {
+        // 容量改變時保留舊 image 中仍有效的內容不划算；由 patch 補齊 (Submit 會整段送出)
+        layout_ = layout;
+        image_.assign(layout_.file_size(), 0);
+
+        SnapshotFileHeader header = {};
+        memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+        header.version = kSnapshotVersion;
+        header.section_count = SnapshotSection_COUNT;
+        header.file_size = image_.size();
+        memcpy(image_.data(), &header, sizeof(header));
+
+        SnapshotSection* table = (SnapshotSection*)(image_.data() + sizeof(SnapshotFileHeader));
+        for (std::uint32_t s = 1; s <= SnapshotSection_COUNT; ++s)
+        {
+            table[s - 1].id = s;
+            table[s - 1].offset = layout_.section_offset(s);
+            table[s - 1].size = layout_.section_size(s);
+            table[s - 1].checksum = 0;
+            const std::size_t chunks = (layout_.section_size(s) + kSnapshotChunk - 1) / kSnapshotChunk;
+            chunk_hash_[s].assign(chunks, 0);
+            chunk_dirty_[s].assign(chunks, 0);
+        }
+    }
+
+    // 整份重建：先寫暫存檔再改名，避免寫到一半的檔案蓋掉舊快照
+    void WriteWholeFile()
+    {
+        if (file_) { fclose(file_); file_ = nullptr; }
+
+        const std::string tmp = path_ + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f)
+        {
+            printf("Error: cannot write snapshot %s\n", tmp.c_str());
+            return;
+        }
+        const bool written = fwrite(image_.data(), 1, image_.size(), f) == image_.size();
+        if (fclose(f) != 0 || !written)
+        {
+            printf("Error: failed writing snapshot %s\n", tmp.c_str());
+            remove(tmp.c_str());
+            return;
+        }
+        remove(path_.c_str());
+        if (rename(tmp.c_str(), path_.c_str()) != 0)
+        {
+            printf("Error: cannot replace snapshot %s\n", path_.c_str());
+            return;
+        }
+        file_ = fopen(path_.c_str(), "r+b");
+        if (!file_)
+            printf("Error: cannot reopen snapshot %s\n", path_.c_str());
+    }
+
+    bool WriteRange(std::size_t offset, std::size_t size)
+    {
+        if (fseek(file_, (long)offset, SEEK_SET) != 0 || fwrite(&image_[offset], 1, size, file_) != size)
+        {
+            printf("Error: failed writing snapshot %s at offset %zu\n", path_.c_str(), offset);
+            return false;
+        }
+        return true;
+    }
+};
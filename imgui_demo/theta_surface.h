@@ -0,0 +1,100 @@
+// theta_surface.h - 到期衰減動畫用的 spot x 剩餘天數 損益曲面
+// 背景執行緒一次把 0..DTE 每一天的 T+0 曲線算好，播放時只做查表 + 天與天之間線性內插。
+// 曲面只用於顯示，依 CurvePrecision 可以用 float32 計算。
+#pragma once
+
+#include "butterfly_pricing.h"
+#include "curve_precision.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class ThetaSurface
+{
+public:
+    ThetaSurface() = default;
+    ~ThetaSurface() { Cancel(); }
+
+    ThetaSurface(const ThetaSurface&) = delete;
+    ThetaSurface& operator=(const ThetaSurface&) = delete;
+
+    // 以目前的部位 (複製一份) 與 x 網格開始背景計算；key 用來判斷曲面是否仍對應目前參數
+    void Start(const OptionLegStore& legs, const CurveVector& xs, double entry_cost, int days, std::uint64_t key,
+               CurvePrecision precision = CurvePrecision::Float64)
+    {
+        Cancel();
+        key_ = key;
+        precision_ = precision;
+        days_ = std::max(0, days);
+        n_points_ = (int)xs.size();
+        values_.assign((std::size_t)(days_ + 1) * n_points_, 0.0);
+        rows_done_.store(0, std::memory_order_relaxed);
+        ready_.store(false, std::memory_order_relaxed);
+        cancel_.store(false, std::memory_order_relaxed);
+
+        worker_ = std::thread([this, legs = OptionLegStore(legs), xs, entry_cost, precision]() mutable {
+            // 從到期日往回算：第 0 列 (剩 0 天) 最先完成
+            // 剩 d 天 = 從今天往後推 days_ - d 天：期限結構改用推移後的曲線 (MarketCurves::rolled)
+            const std::shared_ptr<const MarketCurves> curves = legs.curves();
+            for (int d = 0; d <= days_; ++d)
+            {
+                if (cancel_.load(std::memory_order_relaxed))
+                    return;
+                const double T = d / 365.0;
+                for (std::size_t i = 0; i < legs.size(); ++i)
+                    legs.set_expiry(i, T);
+                if (curves)
+                    legs.set_curves(curves->rolled((days_ - d) / 365.0));
+                double* row = &values_[(std::size_t)d * n_points_];
+                price_curve_display(legs, xs.data(), n_points_, row, precision);
+                for (int j = 0; j < n_points_; ++j)
+                    row[j] -= entry_cost;
+                rows_done_.fetch_add(1, std::memory_order_relaxed);
+            }
+            ready_.store(true, std::memory_order_release);
+        });
+    }
+
+    void Cancel()
+    {
+        cancel_.store(true, std::memory_order_relaxed);
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+    bool Ready() const { return ready_.load(std::memory_order_acquire); }
+    std::uint64_t Key() const { return key_; }
+    CurvePrecision Precision() const { return precision_; }
+    int Days() const { return days_; }
+    float Progress() const { return days_ < 0 ? 0.0f : rows_done_.load(std::memory_order_relaxed) / (float)(days_ + 1); }
+
+    // 取剩餘 days_left 天的曲線 (相鄰兩天線性內插)；必須在 Ready() 之後呼叫
+    void Sample(double days_left, double* out) const
+    {
+        const double d = std::clamp(days_left, 0.0, (double)days_);
+        const int d0 = std::min((int)std::floor(d), days_);
+        const int d1 = std::min(d0 + 1, days_);
+        const double t = d - d0;
+        const double* r0 = &values_[(std::size_t)d0 * n_points_];
+        const double* r1 = &values_[(std::size_t)d1 * n_points_];
+        for (int j = 0; j < n_points_; ++j)
+            out[j] = r0[j] + (r1[j] - r0[j]) * t;
+    }
+
+private:
+    std::thread worker_;
+    std::atomic<bool> cancel_{ false };
+    std::atomic<bool> ready_{ false };
+    std::atomic<int> rows_done_{ 0 };
+    std::uint64_t key_ = ~0ull;
+    CurvePrecision precision_ = CurvePrecision::Float64;
+    int days_ = -1;
+    int n_points_ = 0;
+    TaggedVector<double, MemTag_Surfaces> values_;   // (days + 1) x n_points，第 d 列 = 剩 d 天
+};